@@ -0,0 +1,211 @@
+#pragma once
+
+#include <gauss/kernels.hpp>
+#include <gauss/matrix.hpp>
+#include <vector>
+
+namespace math {
+
+// How far the nonzero elements of a matrix reach from its main diagonal
+struct Bandwidth {
+	size_t lower = 0; // diagonals below the main one
+	size_t upper = 0; // diagonals above it
+};
+
+template <typename T> Bandwidth detect_bandwidth (Matrix_view<T> mat)
+{
+	Bandwidth result;
+	for (size_t row = 0; row < mat.rows(); row++) {
+		auto r = mat[row];
+		// Only scan up to the farthest nonzero found so far
+		for (size_t col = 0; col + result.lower < row && col < r.size(); col++) {
+			if (r[col] != 0) {
+				result.lower = row - col;
+				break;
+			}
+		}
+		for (size_t col = r.size()-1; col != size_t(-1) && col > row + result.upper; col--) {
+			if (r[col] != 0) {
+				result.upper = col - row;
+				break;
+			}
+		}
+	}
+	return result;
+}
+
+// Square band matrix, stored row by row: only the elements within the band take memory.
+// Every row has room for `lower` more elements past the upper edge of the band,
+// which is where row swaps of the LU factorization put the fill-in
+template <typename T> class Band_matrix {
+	Bandwidth band;
+	Matrix<T> data; // element (r, c) is data[r][c + band.lower - r]
+
+public:
+	// The rows are short and accessed at varying offsets, so there is nothing to align
+	Band_matrix (size_t n, Bandwidth b)
+		: band{b}, data(n, 2*b.lower + b.upper + 1, T(0), Matrix_allocation::packed()) {}
+
+	// Elements of `mat` outside the band are ignored
+	Band_matrix (Matrix_view<const T> mat, Bandwidth b): Band_matrix(mat.rows(), b)
+	{
+		assert(mat.rows() == mat.cols());
+		for (size_t row = 0; row < size(); row++) {
+			const size_t begin = row > band.lower ? row - band.lower : 0;
+			const size_t end = std::min(size(), row + band.upper + 1);
+			std::copy(mat[row].begin() + begin, mat[row].begin() + end, row_span(row, begin, end).begin());
+		}
+	}
+
+	[[nodiscard]] size_t size () const { return data.rows(); }
+	[[nodiscard]] Bandwidth bandwidth () const { return band; }
+
+	// Columns [begin, end) of a row; they must lie within its storage
+	std::span<T> row_span (size_t row, size_t begin, size_t end)
+	{
+		assert(begin + band.lower >= row && end <= row + band.lower + band.upper + 1 && begin <= end);
+		return Matrix_view<T>(data)[row].subspan(begin + band.lower - row, end - begin);
+	}
+	std::span<const T> row_span (size_t row, size_t begin, size_t end) const
+	{
+		return const_cast<Band_matrix*>(this)->row_span(row, begin, end);
+	}
+
+	T& operator() (size_t row, size_t col) { return row_span(row, col, col+1)[0]; }
+	const T& operator() (size_t row, size_t col) const { return row_span(row, col, col+1)[0]; }
+};
+
+// LU factorization of a band matrix with partial pivoting, in O(n * lower * (lower+upper)).
+// L is kept as multipliers below the diagonal, with the row swaps applied in between
+// (not to L itself), like LAPACK's gbtrf does
+template <typename T> class Band_lu {
+	Band_matrix<T> lu;
+	std::vector<size_t> swapped_with; // the row swapped with row k at step k
+	size_t factored = 0;
+	unsigned permutations = 0;
+
+public:
+	explicit Band_lu (Band_matrix<T> mat): lu{std::move(mat)}, swapped_with(lu.size())
+	{
+		const size_t n = lu.size();
+		const auto [lower, upper] = lu.bandwidth();
+
+		using std::abs;
+		for (size_t k = 0; k < n; k++) {
+			const size_t last_row = std::min(n-1, k + lower);
+			const size_t end_col = std::min(n, k + lower + upper + 1);
+
+			size_t main_row = k;
+			for (size_t row = k+1; row <= last_row; row++) {
+				if (abs(lu(row, k)) > abs(lu(main_row, k)))
+					main_row = row;
+			}
+			if (lu(main_row, k) == 0)
+				return; // singular
+
+			swapped_with[k] = main_row;
+			if (main_row != k) {
+				auto main = lu.row_span(main_row, k, end_col);
+				std::swap_ranges(main.begin(), main.end(), lu.row_span(k, k, end_col).begin());
+				permutations++;
+			}
+
+			const T inv_main_element = T(1) / lu(k, k);
+			const auto main = std::span<const T>(lu.row_span(k, k+1, end_col));
+			for (size_t row = k+1; row <= last_row; row++) {
+				T& left_element = lu(row, k);
+				left_element *= inv_main_element;
+				axpy(lu.row_span(row, k+1, end_col), -left_element, main);
+			}
+			factored = k+1;
+		}
+	}
+
+	[[nodiscard]] size_t size () const { return lu.size(); }
+
+	// solve() must not be called on a singular matrix
+	[[nodiscard]] bool singular () const { return factored < size(); }
+
+	[[nodiscard]] T determinant () const
+	{
+		if (singular())
+			return 0;
+		T result = permutations % 2 ? -1 : 1;
+		for (size_t k = 0; k < size(); k++)
+			result *= lu(k, k);
+		return result;
+	}
+
+	// Solve A*x = b. `x` and `b` may be the same
+	void solve (std::span<T> x, std::span<const T> b) const
+	{
+		assert(!singular());
+		assert(x.size() == size() && b.size() == size());
+		const size_t n = size();
+		const auto [lower, upper] = lu.bandwidth();
+
+		if (x.data() != b.data())
+			std::copy(b.begin(), b.end(), x.begin());
+
+		for (size_t k = 0; k < n; k++) {
+			std::swap(x[k], x[swapped_with[k]]);
+			for (size_t row = k+1; row <= std::min(n-1, k + lower); row++)
+				x[row] -= lu(row, k) * x[k];
+		}
+
+		for (size_t k = n-1; k != size_t(-1); k--) {
+			const size_t end_col = std::min(n, k + lower + upper + 1);
+			const auto row = lu.row_span(k, k+1, end_col);
+			const T sum = dot(row, std::span<const T>(x.subspan(k+1, row.size())));
+			x[k] = (x[k] - sum) / lu(k, k);
+		}
+	}
+};
+
+// The Thomas algorithm for a tridiagonal system, in O(n).
+// `lower[i]` is the element at (i+1, i), `upper[i]` is at (i, i+1).
+// There is no pivoting, so it's only stable for e.g. diagonally dominant matrices.
+// Returns: false if a zero main element was met, and `x` is then meaningless
+template <typename T> bool thomas_solve
+(std::span<T> x, std::span<const std::type_identity_t<T>> lower,
+ std::span<const std::type_identity_t<T>> diag, std::span<const std::type_identity_t<T>> upper,
+ std::span<const std::type_identity_t<T>> rhs)
+{
+	const size_t n = diag.size();
+	assert(n > 0 && x.size() == n && rhs.size() == n);
+	assert(lower.size() == n-1 && upper.size() == n-1);
+
+	// The upper diagonal after elimination, divided by the main one
+	std::vector<T> factors(n-1);
+	T main_element = diag[0];
+	if (main_element == 0)
+		return false;
+	x[0] = rhs[0] / main_element;
+	for (size_t i = 1; i < n; i++) {
+		factors[i-1] = upper[i-1] / main_element;
+		main_element = diag[i] - lower[i-1] * factors[i-1];
+		if (main_element == 0)
+			return false;
+		x[i] = (rhs[i] - lower[i-1] * x[i-1]) / main_element;
+	}
+	for (size_t i = n-2; i != size_t(-1); i--)
+		x[i] -= factors[i] * x[i+1];
+	return true;
+}
+
+// The determinant of a tridiagonal matrix, by the three-term recurrence (same layout as above)
+template <typename T> T tridiagonal_determinant
+(std::span<const std::type_identity_t<T>> lower, std::span<const std::type_identity_t<T>> diag,
+ std::span<const std::type_identity_t<T>> upper)
+{
+	assert(lower.size()+1 == diag.size() && upper.size()+1 == diag.size());
+	T previous = 1, result = diag[0];
+	for (size_t i = 1; i < diag.size(); i++) {
+		const T next = diag[i] * result - lower[i-1] * upper[i-1] * previous;
+		previous = result;
+		result = next;
+	}
+	return result;
+}
+
+} // namespace math
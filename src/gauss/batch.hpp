@@ -0,0 +1,249 @@
+#pragma once
+
+#include <gauss/kernels.hpp>
+#include <gauss/matrix.hpp>
+#include <gauss/solve.hpp>
+#include <util/thread-pool.hpp>
+#include <vector>
+
+namespace math {
+
+// Many matrices of the same size, stored as a structure of arrays: element (row, col)
+// of every matrix is contiguous, so one step of an algorithm vectorizes across the matrices
+template <typename T> class Matrix_batch {
+	size_t count_, rows_, cols_;
+	std::vector<T> storage;
+
+public:
+	Matrix_batch (size_t count, size_t rows, size_t cols)
+		: count_{count}, rows_{rows}, cols_{cols}, storage(count * rows * cols) {}
+
+	[[nodiscard]] size_t count () const { return count_; }
+	[[nodiscard]] size_t rows () const { return rows_; }
+	[[nodiscard]] size_t cols () const { return cols_; }
+
+	// Element (row, col) of every matrix
+	std::span<T> operator() (size_t row, size_t col)
+	{
+		assert(row < rows_ && col < cols_);
+		return std::span(storage).subspan((row * cols_ + col) * count_, count_);
+	}
+	std::span<const T> operator() (size_t row, size_t col) const
+	{
+		assert(row < rows_ && col < cols_);
+		return std::span(storage).subspan((row * cols_ + col) * count_, count_);
+	}
+};
+
+// Matrices are solved this many at a time, so that the working set stays in cache.
+// The inner loops have this fixed trip count, which lets the compiler vectorize them
+constexpr size_t batch_block_size = 256;
+
+namespace detail {
+
+// Buffers of gauss_solve_batch_block(), kept from one block to the next
+template <typename T> struct Batch_workspace {
+	std::vector<T> storage;
+	// permute[var*block + s] is the variable in column `var` of matrix `s`
+	std::vector<size_t> permute;
+	bool permuted = true; // whether `permute` has to be reset to the identity
+	std::vector<char> diverged, all_zero;
+	std::vector<T> inverse, raw_solution;
+	std::vector<int> result;
+
+	Batch_workspace (size_t rows, size_t cols)
+		: storage(rows * cols * batch_block_size), permute((cols-1) * batch_block_size),
+		  diverged(batch_block_size), all_zero(batch_block_size),
+		  inverse(std::min(rows, cols-1) * batch_block_size), raw_solution((cols-1) * batch_block_size),
+		  result(batch_block_size) {}
+};
+
+// Up to batch_block_size matrices [begin, end) of the batch; see gauss_solve_batch()
+template <typename T> void gauss_solve_batch_block
+(const Matrix_batch<T>& systems, Matrix_batch<T>& triangulated, std::span<T> solutions,
+ std::span<int> classification, size_t begin, size_t end, Batch_workspace<T>& work)
+{
+	constexpr size_t block = batch_block_size;
+	const size_t n = end - begin;
+	assert(n <= block);
+	const size_t num_equations = systems.rows();
+	const size_t num_variables = systems.cols()-1;
+	const size_t cols = systems.cols();
+	const size_t free_col = num_variables;
+
+	// The matrices past `n` are padding: identity, with zero free terms
+	const auto at = [&] (size_t row, size_t col) { return &work.storage[(row * cols + col) * block]; };
+	for (size_t row = 0; row < num_equations; row++) {
+		for (size_t col = 0; col < cols; col++) {
+			const auto src = systems(row, col).subspan(begin, n);
+			std::copy(src.begin(), src.end(), at(row, col));
+			std::fill(at(row, col) + n, at(row, col) + block, row == col ? T(1) : T(0));
+		}
+	}
+
+	auto& permute = work.permute;
+	if (work.permuted) {
+		for (size_t var = 0; var < num_variables; var++)
+			std::fill_n(permute.begin() + var*block, block, var);
+		work.permuted = false;
+	}
+
+	// Matrices with a row of zero coefficients fall out of step with the rest, since
+	// gauss_triangulate() then moves on to the next row without moving to the next column.
+	// They are solved one by one at the end
+	auto& diverged = work.diverged;
+	std::fill(diverged.begin(), diverged.end(), false);
+	// inverse[equ*block + s]: of the main element in row `equ` of matrix `s`, for the
+	// elimination and then for the back substitution
+	auto& inverse = work.inverse;
+	const size_t num_main = std::min(num_equations, num_variables);
+
+	// Every matrix still in step has its main element at (equ, equ)
+	for (size_t equ = 0; equ < num_main; equ++) {
+		const T* const main_element = at(equ, equ);
+		bool any_zero = false;
+		for (size_t s = 0; s < block; s++)
+			any_zero |= main_element[s] == 0;
+		for (size_t s = 0; s < n && any_zero; s++) {
+			if (diverged[s] || main_element[s] != 0)
+				continue;
+			// Find a nonzero main element, same as gauss_triangulate()
+			size_t nonzero = equ+1;
+			while (nonzero < num_variables && at(equ, nonzero)[s] == 0)
+				nonzero++;
+			if (nonzero == num_variables) {
+				diverged[s] = true;
+				continue;
+			}
+			for (size_t row = 0; row < num_equations; row++)
+				std::swap(at(row, nonzero)[s], at(row, equ)[s]);
+			std::swap(permute[nonzero*block + s], permute[equ*block + s]);
+			work.permuted = true;
+		}
+
+		T* const main_inverse = &inverse[equ*block];
+		for (size_t s = 0; s < block; s++)
+			main_inverse[s] = 1 / (diverged[s] ? T(1) : main_element[s]);
+
+		// The elements of a row from the main column on are contiguous
+		const size_t width = (cols - equ) * block;
+		const auto main_row = std::span<const T>(at(equ, equ), width);
+		for (size_t nequ = equ+1; nequ < num_equations; nequ++) {
+			eliminate_batch(std::span(at(nequ, equ), width), main_row,
+					std::span<const T>(main_inverse, block));
+		}
+	}
+
+	// Second step, same as gauss_gather(). In a matrix still in step, every row with
+	// a main element has a nonzero coefficient there, so only the rows past the last
+	// variable can be "0*x1 + 0*x2 + ... = <nonzero>", which means no solution
+	auto& result = work.result;
+	std::fill(result.begin(), result.end(),
+			num_equations < num_variables ? int(num_variables - num_equations) : 0);
+	auto& all_zero = work.all_zero;
+	for (size_t row = num_variables; row < num_equations; row++) {
+		std::fill(all_zero.begin(), all_zero.end(), true);
+		for (size_t col = 0; col < num_variables; col++) {
+			const T* const coefs = at(row, col);
+			for (size_t s = 0; s < block; s++)
+				all_zero[s] &= coefs[s] == 0;
+		}
+		const T* const free_terms = at(row, free_col);
+		for (size_t s = 0; s < block; s++) {
+			if (all_zero[s] && free_terms[s] != 0)
+				result[s] = -1;
+		}
+	}
+
+	const size_t count = systems.count();
+	if (num_equations >= num_variables) {
+		auto& raw_solution = work.raw_solution;
+		for (size_t i = num_variables-1; i != size_t(-1); i--) {
+			T* const coef = &raw_solution[i*block];
+			std::copy_n(at(i, free_col), block, coef);
+			for (size_t j = i+1; j < num_variables; j++) {
+				const T* const a = at(i, j);
+				const T* const x = &raw_solution[j*block];
+				DO_PRAGMA(GCC ivdep)
+				for (size_t s = 0; s < block; s++)
+					coef[s] -= a[s] * x[s];
+			}
+			const T* const main_inverse = &inverse[i*block];
+			for (size_t s = 0; s < block; s++)
+				coef[s] *= main_inverse[s];
+		}
+
+		for (size_t var = 0; var < num_variables; var++) {
+			if (!work.permuted) {
+				std::copy_n(&raw_solution[var*block], n, solutions.begin() + var * count + begin);
+				continue;
+			}
+			for (size_t s = 0; s < n; s++)
+				solutions[permute[var*block + s] * count + begin + s] = raw_solution[var*block + s];
+		}
+	}
+
+	{ // Redo the matrices that fell out of step, from the start
+		Matrix<T> single(num_equations, cols);
+		std::vector<size_t> single_permute(num_variables);
+		std::vector<T> single_solution(num_variables);
+		for (size_t s = 0; s < n; s++) {
+			if (!diverged[s])
+				continue;
+			for (size_t row = 0; row < num_equations; row++) {
+				for (size_t col = 0; col < cols; col++)
+					single[row][col] = systems(row, col)[begin + s];
+			}
+			gauss_triangulate(Matrix_view<T>(single), std::span(single_permute));
+			for (size_t row = 0; row < num_equations; row++) {
+				for (size_t col = 0; col < cols; col++)
+					at(row, col)[s] = single[row][col];
+			}
+			result[s] = gauss_gather(std::span(single_solution), Matrix_view<T>(single));
+			if (result[s] == 0) {
+				for (size_t var = 0; var < num_variables; var++)
+					solutions[single_permute[var] * count + begin + s] = single_solution[var];
+			}
+		}
+	}
+
+	for (size_t row = 0; row < num_equations; row++) {
+		for (size_t col = 0; col < cols; col++)
+			std::copy_n(at(row, col), n, triangulated(row, col).begin() + begin);
+	}
+	std::copy_n(result.begin(), n, classification.begin() + begin);
+}
+
+} // namespace detail
+
+// Both steps of the Gauss method for every matrix of a batch: gauss_triangulate(), then
+// gauss_gather(), for each matrix. Each main element is divided by once per matrix, and
+// multiplied by after that, with the vectorized eliminate_batch(). So the results may differ
+// from theirs in the last bits, and so may the classification of a matrix whose rank
+// only shows when some elements cancel out exactly.
+// `triangulated` receives the triangulated matrices.
+// `solutions` receives the solutions in the real order of variables, with variable `var`
+// of matrix `s` at [var * count + s]; they only make sense where the classification is 0.
+// `classification` receives what gauss_gather() would have returned for each matrix.
+// The matrices are split between up to `threads` threads
+template <typename T> void gauss_solve_batch
+(const Matrix_batch<T>& systems, Matrix_batch<T>& triangulated, std::span<T> solutions,
+ std::span<int> classification, unsigned threads = 1)
+{
+	assert(systems.rows() > 0 && systems.cols() > 1);
+	assert(triangulated.count() == systems.count());
+	assert(triangulated.rows() == systems.rows() && triangulated.cols() == systems.cols());
+	assert(solutions.size() == systems.count() * (systems.cols()-1));
+	assert(classification.size() == systems.count());
+
+	const size_t min_matrices_per_thread = 1 + parallel_min_elements / (systems.rows() * systems.cols());
+	parallel_for(0, systems.count(), threads, min_matrices_per_thread, [&] (size_t begin, size_t end) {
+		detail::Batch_workspace<T> work(systems.rows(), systems.cols());
+		for (size_t block = begin; block < end; block += batch_block_size) {
+			detail::gauss_solve_batch_block(systems, triangulated, solutions, classification,
+					block, std::min(end, block + batch_block_size), work);
+		}
+	});
+}
+
+} // namespace math
@@ -0,0 +1,330 @@
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <cmath>
+#include <gauss/big-int.hpp>
+#include <utility>
+
+namespace math {
+namespace {
+
+using Limbs = std::vector<std::uint32_t>;
+constexpr std::uint64_t limb_base = std::uint64_t(1) << 32;
+
+void trim (Limbs& a)
+{
+	while (!a.empty() && a.back() == 0)
+		a.pop_back();
+}
+
+int compare (const Limbs& a, const Limbs& b)
+{
+	if (a.size() != b.size())
+		return a.size() < b.size() ? -1 : 1;
+	for (size_t i = a.size(); i-- > 0;) {
+		if (a[i] != b[i])
+			return a[i] < b[i] ? -1 : 1;
+	}
+	return 0;
+}
+
+Limbs add (const Limbs& a, const Limbs& b)
+{
+	const Limbs& longer = a.size() >= b.size() ? a : b;
+	const Limbs& shorter = a.size() >= b.size() ? b : a;
+	Limbs result(longer.size() + 1);
+	std::uint64_t carry = 0;
+	for (size_t i = 0; i < longer.size(); i++) {
+		carry += std::uint64_t(longer[i]) + (i < shorter.size() ? shorter[i] : 0);
+		result[i] = std::uint32_t(carry);
+		carry >>= 32;
+	}
+	result.back() = std::uint32_t(carry);
+	trim(result);
+	return result;
+}
+
+// `a` must not be less than `b`
+Limbs subtract (const Limbs& a, const Limbs& b)
+{
+	Limbs result(a.size());
+	std::uint64_t borrow = 0;
+	for (size_t i = 0; i < a.size(); i++) {
+		const std::uint64_t subtrahend = (i < b.size() ? b[i] : 0) + borrow;
+		borrow = a[i] < subtrahend;
+		result[i] = std::uint32_t(a[i] + borrow * limb_base - subtrahend);
+	}
+	assert(borrow == 0);
+	trim(result);
+	return result;
+}
+
+Limbs multiply (const Limbs& a, const Limbs& b)
+{
+	if (a.empty() || b.empty())
+		return {};
+	Limbs result(a.size() + b.size());
+	for (size_t i = 0; i < a.size(); i++) {
+		std::uint64_t carry = 0;
+		for (size_t j = 0; j < b.size(); j++) {
+			carry += std::uint64_t(a[i]) * b[j] + result[i+j];
+			result[i+j] = std::uint32_t(carry);
+			carry >>= 32;
+		}
+		result[i + b.size()] = std::uint32_t(carry);
+	}
+	trim(result);
+	return result;
+}
+
+// Divide `a` by `d` in place and return the remainder
+std::uint32_t divide_small (Limbs& a, std::uint32_t d)
+{
+	assert(d != 0);
+	std::uint64_t remainder = 0;
+	for (size_t i = a.size(); i-- > 0;) {
+		const std::uint64_t current = remainder << 32 | a[i];
+		a[i] = std::uint32_t(current / d);
+		remainder = current % d;
+	}
+	trim(a);
+	return std::uint32_t(remainder);
+}
+
+// The quotient and the remainder, by Knuth's algorithm D (TAOCP vol. 2, 4.3.1)
+std::pair<Limbs, Limbs> divide (const Limbs& a, const Limbs& b)
+{
+	assert(!b.empty());
+	if (compare(a, b) < 0)
+		return { {}, a };
+	if (b.size() == 1) {
+		Limbs quotient = a;
+		const std::uint32_t remainder = divide_small(quotient, b[0]);
+		return { std::move(quotient), remainder ? Limbs{ remainder } : Limbs{} };
+	}
+
+	// Shift both so that the top limb of the divisor has its top bit set, which keeps
+	// the estimates of quotient limbs at most two too large
+	const int shift = std::countl_zero(b.back());
+	const auto shifted = [shift] (const Limbs& x, size_t size) {
+		Limbs result(size);
+		for (size_t i = 0; i < x.size(); i++) {
+			result[i] |= x[i] << shift;
+			if (shift > 0 && i+1 < size)
+				result[i+1] |= x[i] >> (32 - shift);
+		}
+		return result;
+	};
+	const size_t n = b.size(), m = a.size() - n;
+	const Limbs v = shifted(b, n);
+	Limbs u = shifted(a, a.size() + 1);
+
+	Limbs quotient(m + 1);
+	for (size_t j = m+1; j-- > 0;) {
+		const std::uint64_t top = std::uint64_t(u[j+n]) << 32 | u[j+n-1];
+		std::uint64_t q = top / v[n-1], r = top % v[n-1];
+		while (q >= limb_base || q * v[n-2] > (r << 32 | u[j+n-2])) {
+			q--;
+			r += v[n-1];
+			if (r >= limb_base)
+				break;
+		}
+
+		// u[j..j+n] -= q * v
+		std::int64_t borrow = 0;
+		for (size_t i = 0; i < n; i++) {
+			const std::uint64_t product = q * v[i];
+			const std::int64_t t = std::int64_t(u[i+j]) - borrow - std::int64_t(product & 0xffffffff);
+			u[i+j] = std::uint32_t(t);
+			borrow = std::int64_t(product >> 32) - (t >> 32);
+		}
+		const std::int64_t t = std::int64_t(u[j+n]) - borrow;
+		u[j+n] = std::uint32_t(t);
+
+		// Rarely, q was still one too large: add v back
+		if (t < 0) {
+			q--;
+			std::uint64_t carry = 0;
+			for (size_t i = 0; i < n; i++) {
+				carry += std::uint64_t(u[i+j]) + v[i];
+				u[i+j] = std::uint32_t(carry);
+				carry >>= 32;
+			}
+			u[j+n] += std::uint32_t(carry);
+		}
+		quotient[j] = std::uint32_t(q);
+	}
+
+	Limbs remainder(n);
+	for (size_t i = 0; i < n; i++) {
+		remainder[i] = u[i] >> shift;
+		if (shift > 0)
+			remainder[i] |= u[i+1] << (32 - shift);
+	}
+	trim(quotient);
+	trim(remainder);
+	return { std::move(quotient), std::move(remainder) };
+}
+
+} // namespace
+
+void Big_int::normalize ()
+{
+	trim(magnitude);
+	negative &= !magnitude.empty();
+}
+
+Big_int::Big_int (std::int64_t x): negative(x < 0)
+{
+	std::uint64_t abs_x = negative ? 0 - std::uint64_t(x) : std::uint64_t(x);
+	for (; abs_x != 0; abs_x >>= 32)
+		magnitude.push_back(std::uint32_t(abs_x));
+}
+
+size_t Big_int::bits () const
+{
+	return magnitude.empty() ? 0 : 32 * magnitude.size() - std::countl_zero(magnitude.back());
+}
+
+std::uint32_t Big_int::mod (std::uint32_t m) const
+{
+	assert(m != 0);
+	std::uint64_t remainder = 0;
+	for (size_t i = magnitude.size(); i-- > 0;)
+		remainder = (remainder << 32 | magnitude[i]) % m;
+	return std::uint32_t(remainder);
+}
+
+Big_int Big_int::abs () const
+{
+	Big_int result = *this;
+	result.negative = false;
+	return result;
+}
+
+Big_int Big_int::abs_shifted_right (size_t count) const
+{
+	Big_int result;
+	const size_t limbs = count / 32, bits_shift = count % 32;
+	if (limbs >= magnitude.size())
+		return result;
+	result.magnitude.assign(magnitude.begin() + limbs, magnitude.end());
+	if (bits_shift > 0) {
+		for (size_t i = 0; i < result.magnitude.size(); i++) {
+			result.magnitude[i] >>= bits_shift;
+			if (i+1 < result.magnitude.size())
+				result.magnitude[i] |= result.magnitude[i+1] << (32 - bits_shift);
+		}
+	}
+	result.normalize();
+	return result;
+}
+
+double Big_int::to_double () const
+{
+	// The top 64 bits are more than a double holds
+	const size_t extra = bits() > 64 ? bits() - 64 : 0;
+	const Big_int top = abs_shifted_right(extra);
+	std::uint64_t value = 0;
+	for (size_t i = top.magnitude.size(); i-- > 0;)
+		value = value << 32 | top.magnitude[i];
+	const double result = std::ldexp(double(value), int(std::min<size_t>(extra, 1 << 20)));
+	return negative ? -result : result;
+}
+
+std::string Big_int::to_string () const
+{
+	if (is_zero())
+		return "0";
+	// Nine decimal digits at a time, least significant first
+	std::vector<std::uint32_t> groups;
+	Limbs rest = magnitude;
+	while (!rest.empty())
+		groups.push_back(divide_small(rest, 1'000'000'000));
+
+	std::string result = negative ? "-" : "";
+	result += std::to_string(groups.back());
+	for (size_t i = groups.size()-1; i-- > 0;) {
+		const std::string group = std::to_string(groups[i]);
+		result.append(9 - group.size(), '0');
+		result += group;
+	}
+	return result;
+}
+
+std::strong_ordering operator<=> (const Big_int& a, const Big_int& b)
+{
+	if (a.negative != b.negative)
+		return a.negative ? std::strong_ordering::less : std::strong_ordering::greater;
+	const int order = a.negative ? compare(b.magnitude, a.magnitude) : compare(a.magnitude, b.magnitude);
+	return order <=> 0;
+}
+
+Big_int Big_int::operator- () const
+{
+	Big_int result = *this;
+	result.negative = !negative;
+	result.normalize();
+	return result;
+}
+
+Big_int operator+ (const Big_int& a, const Big_int& b)
+{
+	Big_int result;
+	if (a.negative == b.negative) {
+		result.magnitude = add(a.magnitude, b.magnitude);
+		result.negative = a.negative;
+	} else if (compare(a.magnitude, b.magnitude) >= 0) {
+		result.magnitude = subtract(a.magnitude, b.magnitude);
+		result.negative = a.negative;
+	} else {
+		result.magnitude = subtract(b.magnitude, a.magnitude);
+		result.negative = b.negative;
+	}
+	result.normalize();
+	return result;
+}
+
+Big_int operator- (const Big_int& a, const Big_int& b)
+{
+	return a + -b;
+}
+
+Big_int operator* (const Big_int& a, const Big_int& b)
+{
+	Big_int result;
+	result.magnitude = multiply(a.magnitude, b.magnitude);
+	result.negative = a.negative != b.negative;
+	result.normalize();
+	return result;
+}
+
+Big_int operator/ (const Big_int& a, const Big_int& b)
+{
+	Big_int result;
+	result.magnitude = divide(a.magnitude, b.magnitude).first;
+	result.negative = a.negative != b.negative;
+	result.normalize();
+	return result;
+}
+
+Big_int operator% (const Big_int& a, const Big_int& b)
+{
+	Big_int result;
+	result.magnitude = divide(a.magnitude, b.magnitude).second;
+	result.negative = a.negative;
+	result.normalize();
+	return result;
+}
+
+Big_int gcd (Big_int a, Big_int b)
+{
+	a.negative = b.negative = false;
+	while (!b.is_zero()) {
+		a.magnitude = divide(a.magnitude, b.magnitude).second;
+		std::swap(a, b);
+	}
+	return a;
+}
+
+} // namespace math
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <compare>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Integers of arbitrary size, for the exact solver (see exact.hpp): no more than it needs,
+// with schoolbook multiplication and division, which are fast enough for a few thousand digits
+
+namespace math {
+
+class Big_int {
+	std::vector<std::uint32_t> magnitude; // least significant limb first, no leading zero limbs
+	bool negative = false;                // never set for zero
+
+	void normalize ();
+
+public:
+	Big_int () = default;
+	Big_int (std::int64_t);
+
+	[[nodiscard]] bool is_zero () const { return magnitude.empty(); }
+	[[nodiscard]] bool is_negative () const { return negative; }
+	// Of the absolute value; 0 for zero
+	[[nodiscard]] size_t bits () const;
+	// The absolute value modulo `m`
+	[[nodiscard]] std::uint32_t mod (std::uint32_t m) const;
+	[[nodiscard]] Big_int abs () const;
+	// The absolute value divided by 2^count, rounded down
+	[[nodiscard]] Big_int abs_shifted_right (size_t count) const;
+	// Rounded toward zero; infinite if out of range
+	[[nodiscard]] double to_double () const;
+	[[nodiscard]] std::string to_string () const;
+
+	friend bool operator== (const Big_int&, const Big_int&) = default;
+	friend std::strong_ordering operator<=> (const Big_int&, const Big_int&);
+
+	Big_int operator- () const;
+	friend Big_int operator+ (const Big_int&, const Big_int&);
+	friend Big_int operator- (const Big_int&, const Big_int&);
+	friend Big_int operator* (const Big_int&, const Big_int&);
+	// Rounded toward zero, with the remainder taking the sign of the dividend,
+	// as for built-in integers
+	friend Big_int operator/ (const Big_int&, const Big_int&);
+	friend Big_int operator% (const Big_int&, const Big_int&);
+
+	// Nonnegative
+	friend Big_int gcd (Big_int, Big_int);
+};
+
+} // namespace math
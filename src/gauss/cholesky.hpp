@@ -0,0 +1,155 @@
+#pragma once
+
+#include <cmath>
+#include <gauss/gemm.hpp>
+#include <gauss/matrix.hpp>
+#include <gauss/solve.hpp>
+
+// The Cholesky factorization A = U^T * U of symmetric positive definite matrices, with U upper
+// triangular. It needs no pivoting and half the operations of LU, as only the upper triangle
+// of A is read and updated; the lower one is left to rot.
+//
+// Blocked like lu_factor_columns(): a panel of rows is factored, then the trailing part of
+// the upper triangle receives its update as matrix products, one block column at a time.
+// A is only known to be positive definite once the factorization has succeeded, so it stops
+// at the first pivot that isn't positive; callers then fall back to LU
+
+namespace math {
+
+// Whether `a` is square, symmetric and has a positive diagonal, which every symmetric
+// positive definite matrix has. Compared in tiles, so that both triangles are read from cache
+template <typename T> bool maybe_positive_definite (Matrix_view<const T> a)
+{
+	const size_t n = a.rows();
+	if (a.cols() != n)
+		return false;
+	for (size_t i = 0; i < n; i++) {
+		if (!(a[i][i] > 0))
+			return false;
+	}
+
+	constexpr size_t tile = 64;
+	for (const auto& [row0, col0, block]: a.tiles(tile, tile)) {
+		if (col0 < row0)
+			continue; // below the diagonal, compared from the mirror tile
+		for (size_t row = 0; row < block.rows(); row++) {
+			for (size_t col = row0 == col0 ? row+1 : 0; col < block.cols(); col++) {
+				if (block[row][col] != a[col0 + col][row0 + row])
+					return false;
+			}
+		}
+	}
+	return true;
+}
+
+constexpr size_t default_cholesky_block_size = 64;
+
+template <typename T> class Cholesky_factorization {
+	Matrix<T> u; // U on and above the diagonal; garbage below it
+	bool positive_definite_ = true;
+
+	// Returns false at a pivot that isn't positive
+	bool factor_panel (size_t k0, size_t k_end)
+	{
+		using std::sqrt;
+		const size_t n = size();
+		for (size_t j = k0; j < k_end; j++) {
+			auto row = u[j];
+			if (!(row[j] > 0))
+				return false;
+			const T diagonal = sqrt(row[j]);
+			row[j] = diagonal;
+			const T inv_diagonal = T(1) / diagonal;
+			for (T& value: row.subspan(j+1))
+				value *= inv_diagonal;
+			// The rest of the panel's rows, on and right of their diagonal
+			for (size_t i = j+1; i < k_end; i++)
+				axpy(u[i].subspan(i), -row[i], std::span<const T>(row.subspan(i, n-i)));
+		}
+		return true;
+	}
+
+	void factorize (size_t block_size, unsigned threads)
+	{
+		assert(u.rows() == u.cols() && u.rows() > 0);
+		assert(block_size > 0);
+		const size_t n = size();
+
+		// Block columns of the trailing update, wide enough for gemm() to be efficient
+		constexpr size_t update_width = 256;
+
+		for (size_t k0 = 0; k0 < n; k0 += block_size) {
+			const size_t k_end = std::min(n, k0 + block_size), kb = k_end - k0;
+			if (!factor_panel(k0, k_end)) {
+				positive_definite_ = false;
+				return;
+			}
+
+			// A22 -= U12^T * U12 on and above the diagonal of A22: a block column at a time,
+			// down to its diagonal block
+			const Matrix_view<T> mat = u;
+			const auto u12 = [&] (size_t col0, size_t cols) {
+				return Matrix_view<const T>(mat.subview(k0, col0, kb, cols));
+			};
+			for (size_t col0 = k_end; col0 < n; col0 += update_width) {
+				const size_t width = std::min(update_width, n - col0);
+				const size_t rows = col0 + width - k_end;
+				gemm(mat.subview(k_end, col0, rows, width), T(-1), u12(k_end, rows), Transpose::yes,
+						u12(col0, width), Transpose::no, T(1), threads);
+			}
+		}
+	}
+
+public:
+	explicit Cholesky_factorization
+	(Matrix_view<const T> a, size_t block_size = default_cholesky_block_size, unsigned threads = 1)
+		: u(a)
+	{
+		factorize(block_size, threads);
+	}
+
+	// Factorize in the storage of `a` itself, without making a copy
+	explicit Cholesky_factorization
+	(Matrix<T>&& a, size_t block_size = default_cholesky_block_size, unsigned threads = 1)
+		: u(std::move(a))
+	{
+		factorize(block_size, threads);
+	}
+
+	[[nodiscard]] size_t size () const { return u.rows(); }
+
+	// Whether the factorization succeeded. If not, A is not positive definite (or too close to
+	// not being one for rounding to tell), and the other functions must not be called
+	[[nodiscard]] bool positive_definite () const { return positive_definite_; }
+
+	[[nodiscard]] T determinant () const
+	{
+		assert(positive_definite());
+		const T det = triangular_determinant(Matrix_view<const T>(u));
+		return det * det;
+	}
+
+	// Solve A*x = b. `x` and `b` may be the same
+	void solve (std::span<T> x, std::span<const std::type_identity_t<T>> b) const
+	{
+		assert(positive_definite());
+		assert(x.size() == size() && b.size() == size());
+		const size_t n = size();
+
+		// U^T*y = b, going down the rows of U as columns of U^T
+		if (x.data() != b.data())
+			std::ranges::copy(b, x.begin());
+		for (size_t i = 0; i < n; i++) {
+			x[i] /= u[i][i];
+			axpy(x.subspan(i+1), -x[i], u[i].subspan(i+1));
+		}
+
+		// U*x = y
+		for (size_t i = n-1; i != size_t(-1); i--) {
+			const auto known = std::span<const T>(x.subspan(i+1));
+			x[i] = (x[i] - dot(u[i].subspan(i+1), known)) / u[i][i];
+		}
+	}
+};
+
+} // namespace math
@@ -0,0 +1,630 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <gauss/gemm.hpp>
+#include <gauss/iterative.hpp>
+#include <gauss/lu.hpp>
+#include <limits>
+#include <optional>
+#include <random>
+#include <vector>
+
+// Eigenvalues of real matrices:
+//  - power_iteration() and inverse_iteration() find one eigenpair: the dominant one, or the one
+//    nearest to a shift; smallest_eigenvalue() the one nearest to zero, with a factorization
+//    that is already at hand;
+//  - eigenvalues() finds all of them, by reduction to Hessenberg form and the QR algorithm
+//    with implicit double shifts (Francis steps), which keeps complex pairs in real arithmetic;
+//  - lanczos() finds the extreme eigenvalues of symmetric matrices, dense or sparse,
+//    touching the matrix only through products with vectors.
+
+namespace math {
+
+struct Eigen_settings {
+	double tolerance = 1e-10; // on |A*v - lambda*v| / |A|, with |v| = 1
+	size_t max_iterations = 1000;
+	unsigned threads = 1;
+};
+
+template <typename T> struct Eigenpair_result {
+	bool converged = false;
+	size_t iterations = 0;
+	T eigenvalue = 0; // the eigenvector is left in `v`, normalized
+};
+
+namespace detail {
+template <typename T> T max_row_sum (Matrix_view<const T> a)
+{
+	using std::abs;
+	T norm = 0;
+	for (auto row: a) {
+		T sum = 0;
+		for (const T& value: row)
+			sum += abs(value);
+		norm = std::max(norm, sum);
+	}
+	return norm;
+}
+
+template <typename T> T normalize (std::span<T> v)
+{
+	using std::sqrt;
+	const T norm = sqrt(dot(std::span<const T>(v), std::span<const T>(v)));
+	if (norm > 0) {
+		for (T& value: v)
+			value /= norm;
+	}
+	return norm;
+}
+
+// A start vector with no particular direction, so as not to be orthogonal to what is sought.
+// The same every time, so that results are reproducible
+template <typename T> void arbitrary_unit_vector (std::span<T> v)
+{
+	std::minstd_rand random(12345);
+	std::uniform_real_distribution<double> distribution(-1, 1);
+	for (T& value: v)
+		value = T(distribution(random));
+	normalize(v);
+}
+
+// Given |v| = 1 and av = A*v: the Rayleigh quotient v^T*A*v, and whether |A*v - lambda*v|
+// is within `tolerance`
+template <typename T> std::pair<T, bool> rayleigh_check
+(std::span<const T> v, std::span<const T> av, T tolerance)
+{
+	using std::sqrt;
+	const T lambda = dot(v, av);
+	T residual_square = 0;
+	for (size_t i = 0; i < v.size(); i++)
+		residual_square += (av[i] - lambda * v[i]) * (av[i] - lambda * v[i]);
+	return { lambda, sqrt(residual_square) <= tolerance };
+}
+} // namespace detail
+
+// The eigenvalue of the largest magnitude, the other extreme with a shift past the spectrum:
+// iterates with A - shift*I. `v` is the starting guess, or arbitrary if zero.
+// Converges as fast as |lambda_2 / lambda_1| (of A - shift*I) goes to zero, so not at all
+// when the dominant eigenvalues are a complex pair or differ only in sign
+template <typename T> Eigenpair_result<T> power_iteration
+(Matrix_view<const T> a, std::span<T> v, std::type_identity_t<T> shift = 0,
+ const Eigen_settings& settings = {})
+{
+	const size_t n = a.rows();
+	assert(a.cols() == n && v.size() == n && n > 0);
+	if (detail::normalize(v) == 0)
+		detail::arbitrary_unit_vector(v);
+
+	Eigenpair_result<T> result;
+	const T tolerance = T(settings.tolerance) * detail::max_row_sum(a);
+	std::vector<T> av(n);
+	for (; result.iterations <= settings.max_iterations; result.iterations++) {
+		gemv(std::span(av), T(1), a, Transpose::no, std::span<const T>(v), T(0), settings.threads);
+		const auto [lambda, converged] = detail::rayleigh_check(std::span<const T>(v), std::span<const T>(av),
+				tolerance);
+		result.eigenvalue = lambda;
+		if (converged) {
+			result.converged = true;
+			break;
+		}
+		// v <- (A - shift*I) * v, normalized
+		for (size_t i = 0; i < n; i++)
+			v[i] = av[i] - shift * v[i];
+		if (detail::normalize(v) == 0)
+			break;
+	}
+	return result;
+}
+
+// The eigenvalue nearest to `shift`: power iteration with (A - shift*I)^-1, which is factored once.
+// Converges the faster, the closer the shift is to that eigenvalue compared to the others.
+// `v` is the starting guess, or arbitrary if zero
+template <typename T> Eigenpair_result<T> inverse_iteration
+(Matrix_view<const T> a, std::span<T> v, std::type_identity_t<T> shift, const Eigen_settings& settings = {})
+{
+	using std::abs, std::sqrt;
+	const size_t n = a.rows();
+	assert(a.cols() == n && v.size() == n && n > 0);
+	if (detail::normalize(v) == 0)
+		detail::arbitrary_unit_vector(v);
+
+	const T a_norm = detail::max_row_sum(a);
+	const auto factor = [&] (T s) {
+		Matrix<T> shifted(a);
+		for (size_t i = 0; i < n; i++)
+			shifted[i][i] -= s;
+		return Lu_factorization<T>(std::move(shifted), default_lu_block_size, settings.threads);
+	};
+	auto lu = factor(shift);
+	// A shift right on an eigenvalue is the best one could ask for, but can't be factored:
+	// moving it off a little still finds that eigenvalue in a step or two
+	if (lu.singular())
+		lu = factor(shift + std::max(abs(shift), a_norm) * sqrt(std::numeric_limits<T>::epsilon()));
+
+	Eigenpair_result<T> result;
+	if (lu.singular())
+		return result;
+
+	const T tolerance = T(settings.tolerance) * a_norm;
+	std::vector<T> av(n), next(n);
+	for (; result.iterations <= settings.max_iterations; result.iterations++) {
+		gemv(std::span(av), T(1), a, Transpose::no, std::span<const T>(v), T(0), settings.threads);
+		const auto [lambda, converged] = detail::rayleigh_check(std::span<const T>(v), std::span<const T>(av),
+				tolerance);
+		result.eigenvalue = lambda;
+		if (converged) {
+			result.converged = true;
+			break;
+		}
+		lu.solve(std::span(next), std::span<const T>(v));
+		std::ranges::copy(next, v.begin());
+		if (detail::normalize(v) == 0)
+			break;
+	}
+	return result;
+}
+
+// The eigenvalue of the smallest magnitude of a symmetric matrix A, which is only touched
+// through `solve(x, b)` setting x = A^-1 * b, as a factorization of A does: power iteration with A^-1.
+// Converges to `tolerance` relative to that eigenvalue, not to |A| as the others do, so it is found
+// as accurately when it is tiny, which is what the condition number needs.
+// `v` is the starting guess, or arbitrary if zero
+template <typename T, typename Solve> Eigenpair_result<T> smallest_eigenvalue
+(Solve&& solve, std::span<T> v, const Eigen_settings& settings = {})
+{
+	using std::abs;
+	const size_t n = v.size();
+	assert(n > 0);
+	if (detail::normalize(v) == 0)
+		detail::arbitrary_unit_vector(v);
+
+	Eigenpair_result<T> result;
+	std::vector<T> next(n);
+	for (; result.iterations <= settings.max_iterations; result.iterations++) {
+		solve(std::span(next), std::span<const T>(v));
+		// The Rayleigh quotient of A^-1, its eigenvalue of the largest magnitude
+		const T inverse = dot(std::span<const T>(v), std::span<const T>(next));
+		if (inverse == 0)
+			break;
+		result.eigenvalue = 1 / inverse;
+		if (detail::rayleigh_check(std::span<const T>(v), std::span<const T>(next),
+				T(settings.tolerance) * abs(inverse)).second) {
+			result.converged = true;
+			break;
+		}
+		std::ranges::copy(next, v.begin());
+		if (detail::normalize(v) == 0)
+			break;
+	}
+	return result;
+}
+
+// Reduce `a` in place to upper Hessenberg form Q^T*A*Q, with the same eigenvalues,
+// by Householder reflections. The elements below the subdiagonal are set to zero
+template <typename T> void hessenberg_reduce (Matrix_view<T> a, unsigned threads = 1)
+{
+	using std::sqrt;
+	const size_t n = a.rows();
+	assert(a.cols() == n);
+	std::vector<T> v(n), w(n);
+
+	for (size_t k = 0; k+2 < n; k++) {
+		// The reflection I - tau*v*v^T, v = (1, ...), takes column k below the diagonal to (beta, 0, ...)
+		const size_t m = n-k-1;
+		const auto vk = std::span(v).first(m);
+		for (size_t i = 0; i < m; i++)
+			vk[i] = a[k+1+i][k];
+		const T alpha = vk[0];
+		const T tail = dot(std::span<const T>(vk.subspan(1)), std::span<const T>(vk.subspan(1)));
+		if (tail == 0)
+			continue;
+		const T beta = alpha >= 0 ? -sqrt(alpha*alpha + tail) : sqrt(alpha*alpha + tail);
+		const T tau = (beta - alpha) / beta;
+		const T scale = T(1) / (alpha - beta);
+		vk[0] = 1;
+		for (size_t i = 1; i < m; i++)
+			vk[i] *= scale;
+
+		// From the left, on rows k+1.. and columns k+1..: rows -= tau * v * (v^T * rows),
+		// with column k set to what it becomes
+		const auto trailing = a.subview(k+1, k+1, m, m);
+		const auto wk = std::span(w).first(m);
+		gemv(wk, T(1), Matrix_view<const T>(trailing), Transpose::yes, std::span<const T>(vk), T(0), threads);
+		a[k+1][k] = beta;
+		for (size_t i = 1; i < m; i++)
+			a[k+1+i][k] = 0;
+
+		// From the right, on all rows and columns k+1..: row -= tau * (row * v) * v^T.
+		// That is row by row, so it goes in the same pass as the rest of the left one,
+		// while each row is in cache
+		parallel_for(0, n, threads, 1 + parallel_min_elements / m, [&] (size_t begin, size_t end) {
+			for (size_t i = begin; i < end; i++) {
+				const auto row = a[i].subspan(k+1);
+				if (i > k)
+					axpy(row, -tau * vk[i-k-1], std::span<const T>(wk));
+				const T product = dot(std::span<const T>(row), std::span<const T>(vk));
+				axpy(row, -tau * product, std::span<const T>(vk));
+			}
+		});
+	}
+}
+
+// All eigenvalues of the upper Hessenberg matrix `h`, which is destroyed, in no particular order.
+// Complex conjugate pairs come one after the other, the one with a positive imaginary part first.
+// Returns nothing if the QR algorithm fails to converge, which is very rare
+template <typename T> std::optional<std::vector<std::complex<T>>> hessenberg_eigenvalues (Matrix_view<T> h)
+{
+	using std::abs, std::sqrt;
+	const size_t n = h.rows();
+	assert(h.cols() == n);
+	constexpr T epsilon = std::numeric_limits<T>::epsilon();
+	constexpr size_t max_iterations = 30; // per eigenvalue
+	std::vector<std::complex<T>> result(n);
+	std::vector<T> scratch(n);
+
+	// The reflection of a double shift step on rows or columns k..k+2 (k..k+1 if k+1 is the last)
+	struct Reflection {
+		ptrdiff_t k;
+		T x, y, z, q, r;
+	};
+	std::vector<Reflection> reflections;
+	const auto reflect_columns = [] (std::span<T> row, const Reflection& reflection, ptrdiff_t last) {
+		const ptrdiff_t k = reflection.k;
+		T t = reflection.x * row[k] + reflection.y * row[k+1];
+		if (k != last-1) {
+			t += reflection.z * row[k+2];
+			row[k+2] -= t * reflection.r;
+		}
+		row[k+1] -= t * reflection.q;
+		row[k] -= t;
+	};
+
+	T h_norm = 0;
+	for (size_t i = 0; i < n; i++) {
+		for (size_t j = i > 0 ? i-1 : 0; j < n; j++)
+			h_norm += abs(h[i][j]);
+	}
+
+	// The active block is rows and columns [low, last]; everything past `last` has been found.
+	// `exceptional_shift` accumulates the exceptional shifts, applied to the diagonal
+	T exceptional_shift = 0;
+	for (ptrdiff_t last = ptrdiff_t(n)-1; last >= 0;) {
+		size_t iterations = 0;
+		ptrdiff_t low;
+		while (true) {
+			// A negligible subdiagonal element splits the matrix
+			for (low = last; low > 0; low--) {
+				T s = abs(h[low-1][low-1]) + abs(h[low][low]);
+				if (s == 0)
+					s = h_norm;
+				if (abs(h[low][low-1]) <= epsilon * s) {
+					h[low][low-1] = 0;
+					break;
+				}
+			}
+
+			T x = h[last][last];
+			if (low == last) {
+				// One eigenvalue has split off
+				result[last] = x + exceptional_shift;
+				last--;
+				break;
+			}
+
+			T y = h[last-1][last-1];
+			T w = h[last][last-1] * h[last-1][last];
+			if (low == last-1) {
+				// Two eigenvalues have: those of the 2x2 block
+				const T p = (y - x) / 2;
+				const T q = p*p + w;
+				T z = sqrt(abs(q));
+				x += exceptional_shift;
+				if (q >= 0) {
+					z = p + (p >= 0 ? z : -z);
+					result[last-1] = result[last] = x + z;
+					if (z != 0)
+						result[last] = x - w/z;
+				} else {
+					result[last-1] = { x + p, z };
+					result[last] = { x + p, -z };
+				}
+				last -= 2;
+				break;
+			}
+
+			if (iterations == max_iterations)
+				return std::nullopt;
+			// Exceptional shifts break cycles that the usual ones can fall into
+			if (iterations == 10 || iterations == 20) {
+				exceptional_shift += x;
+				for (ptrdiff_t i = 0; i <= last; i++)
+					h[i][i] -= x;
+				const T s = abs(h[last][last-1]) + abs(h[last-1][last-2]);
+				x = y = T(0.75) * s;
+				w = T(-0.4375) * s*s;
+			}
+			iterations++;
+
+			// Look for two consecutive small subdiagonal elements, to start the step after them
+			ptrdiff_t m;
+			T p = 0, q = 0, r = 0;
+			for (m = last-2; m >= low; m--) {
+				const T z = h[m][m];
+				r = x - z;
+				const T s0 = y - z;
+				p = (r*s0 - w) / h[m+1][m] + h[m][m+1];
+				q = h[m+1][m+1] - z - r - s0;
+				r = h[m+2][m+1];
+				const T s = abs(p) + abs(q) + abs(r);
+				p /= s;
+				q /= s;
+				r /= s;
+				if (m == low)
+					break;
+				const T u = abs(h[m][m-1]) * (abs(q) + abs(r));
+				const T v = abs(p) * (abs(h[m-1][m-1]) + abs(z) + abs(h[m+1][m+1]));
+				if (u <= epsilon * v)
+					break;
+			}
+			for (ptrdiff_t i = m+2; i <= last; i++) {
+				h[i][i-2] = 0;
+				if (i != m+2)
+					h[i][i-3] = 0;
+			}
+
+			// The double shift step on rows and columns [m, last], chasing the bulge down.
+			// Each reflection is applied to rows k..k+2 right away, but to columns k..k+2 only
+			// in the rows the rest of the step reads; the rows above are done after it,
+			// a row at a time, instead of going down the columns each time
+			reflections.clear();
+			for (ptrdiff_t k = m; k <= last-1; k++) {
+				if (k != m) {
+					p = h[k][k-1];
+					q = h[k+1][k-1];
+					r = k != last-1 ? h[k+2][k-1] : 0;
+					x = abs(p) + abs(q) + abs(r);
+					if (x != 0) {
+						p /= x;
+						q /= x;
+						r /= x;
+					}
+				}
+				const T s = p >= 0 ? sqrt(p*p + q*q + r*r) : -sqrt(p*p + q*q + r*r);
+				if (s == 0)
+					continue;
+				if (k == m) {
+					if (low != m)
+						h[k][k-1] = -h[k][k-1];
+				} else {
+					h[k][k-1] = -s*x;
+				}
+				p += s;
+				const Reflection reflection { k, p/s, q/s, r/s, q/p, r/p };
+				x = reflection.x;
+				y = reflection.y;
+				q = reflection.q;
+				r = reflection.r;
+				reflections.push_back(reflection);
+
+				// Rows k..k+2, contiguous: row -= (row0 + q*row1 + r*row2) * (x, y, z)
+				const auto row0 = h[k].subspan(k, last+1-k), row1 = h[k+1].subspan(k, last+1-k);
+				const auto sum = std::span(scratch).first(row0.size());
+				std::ranges::copy(row0, sum.begin());
+				axpy(sum, q, std::span<const T>(row1));
+				if (k != last-1) {
+					const auto row2 = h[k+2].subspan(k, last+1-k);
+					axpy(sum, r, std::span<const T>(row2));
+					axpy(row2, -reflection.z, std::span<const T>(sum));
+				}
+				axpy(row0, -x, std::span<const T>(sum));
+				axpy(row1, -y, std::span<const T>(sum));
+
+				// Columns k..k+2, in the rows below k, down to where the Hessenberg form ends
+				for (ptrdiff_t i = k+1; i <= std::min(last, k+3); i++)
+					reflect_columns(h[i], reflection, last);
+			}
+			// Several rows at once, as the reflections on one row depend on each other
+			constexpr ptrdiff_t rows_at_once = 16;
+			for (ptrdiff_t i0 = low; i0 <= last; i0 += rows_at_once) {
+				const ptrdiff_t i_end = std::min(last+1, i0 + rows_at_once);
+				for (const Reflection& reflection: reflections) {
+					for (ptrdiff_t i = i0; i < std::min(i_end, reflection.k + 1); i++)
+						reflect_columns(h[i], reflection, last);
+				}
+			}
+		}
+	}
+	return result;
+}
+
+// All eigenvalues of `a`; see hessenberg_eigenvalues()
+template <typename T> std::optional<std::vector<std::complex<T>>> eigenvalues
+(Matrix_view<const T> a, unsigned threads = 1)
+{
+	assert(a.rows() == a.cols());
+	Matrix<T> h(a);
+	hessenberg_reduce(Matrix_view<T>(h), threads);
+	return hessenberg_eigenvalues(Matrix_view<T>(h));
+}
+
+template <typename T> struct Lanczos_result {
+	bool converged = false;
+	size_t steps = 0; // the size of the Krylov subspace
+	// Both ascending, and they don't overlap: if the Krylov subspace is smaller than twice
+	// the count, `smallest` gets its middle eigenvalue and both get fewer than asked for
+	std::vector<T> smallest, largest;
+};
+
+namespace detail {
+template <typename T> void multiply
+(std::span<T> dest, Matrix_view<const T> mat, std::span<const T> vec, unsigned threads)
+{
+	gemv(dest, T(1), mat, Transpose::no, vec, T(0), threads);
+}
+template <typename T> void multiply
+(std::span<T> dest, const Csr_matrix<T>& mat, std::span<const T> vec, unsigned)
+{
+	mul_matrix_vector(dest, mat, vec);
+}
+
+// Eigenvalues of the symmetric tridiagonal matrix with the diagonal `d` and the off-diagonal `e`
+// (e[i] next to d[i] and d[i+1]; the last element is ignored), by the QL algorithm with implicit
+// shifts. Of the eigenvectors only the last components are computed, into `last`.
+// The inputs are destroyed and the eigenvalues are left in `d`, unsorted.
+// Returns false if the algorithm fails to converge
+template <typename T> bool tridiagonal_eigenvalues (std::span<T> d, std::span<T> e, std::span<T> last)
+{
+	using std::abs, std::hypot;
+	const ptrdiff_t n = d.size();
+	assert(e.size() == d.size() && last.size() == d.size() && n > 0);
+	constexpr size_t max_iterations = 30; // per eigenvalue
+	std::fill(last.begin(), last.end(), T(0));
+	last[n-1] = 1;
+	e[n-1] = 0;
+
+	for (ptrdiff_t l = 0; l < n; l++) {
+		size_t iterations = 0;
+		ptrdiff_t m;
+		do {
+			for (m = l; m < n-1; m++) {
+				const T dd = abs(d[m]) + abs(d[m+1]);
+				if (abs(e[m]) <= std::numeric_limits<T>::epsilon() * dd)
+					break;
+			}
+			if (m == l)
+				break;
+			if (iterations++ == max_iterations)
+				return false;
+
+			T g = (d[l+1] - d[l]) / (2 * e[l]);
+			T r = hypot(g, T(1));
+			g = d[m] - d[l] + e[l] / (g + (g >= 0 ? r : -r));
+			T s = 1, c = 1, p = 0;
+			ptrdiff_t i;
+			for (i = m-1; i >= l; i--) {
+				T f = s * e[i];
+				const T b = c * e[i];
+				e[i+1] = r = hypot(f, g);
+				if (r == 0) {
+					d[i+1] -= p;
+					e[m] = 0;
+					break;
+				}
+				s = f / r;
+				c = g / r;
+				g = d[i+1] - p;
+				r = (d[i] - g) * s + 2 * c * b;
+				p = s * r;
+				d[i+1] = g + p;
+				g = c * r - b;
+				f = last[i+1];
+				last[i+1] = s * last[i] + c * f;
+				last[i] = c * last[i] - s * f;
+			}
+			if (r == 0 && i >= l)
+				continue;
+			d[l] -= p;
+			e[l] = g;
+			e[m] = 0;
+		} while (m != l);
+	}
+	return true;
+}
+} // namespace detail
+
+// The `count` smallest and `count` largest eigenvalues of the symmetric matrix `mat`
+// (a Matrix_view or a Csr_matrix), by the Lanczos method with full reorthogonalization.
+// The Krylov subspace grows until all of them have converged, to `tolerance` relative to
+// the largest eigenvalue magnitude, or until `max_iterations` steps. It stops early, and not
+// converged, if the subspace turns out invariant with fewer than 2*count eigenvalues, as it does
+// when the matrix has fewer distinct eigenvalues than that.
+// Only products of the matrix with vectors are taken, and memory is O(n * steps)
+template <typename T, typename Mat> Lanczos_result<T> lanczos
+(const Mat& mat, size_t count, const Eigen_settings& settings = {})
+{
+	using std::abs, std::sqrt;
+	const size_t n = detail::matrix_size(mat);
+	assert(count > 0 && n > 0);
+	const size_t max_steps = std::min(n, std::max<size_t>(settings.max_iterations, 1));
+	// Checking convergence needs the eigenvalues of the tridiagonal matrix, so not every step
+	constexpr size_t check_every = 10;
+
+	Lanczos_result<T> result;
+	Matrix<T> basis(max_steps, n); // orthonormal, a row each
+	std::vector<T> alpha, beta; // the diagonal and off-diagonal of the tridiagonal matrix
+	std::vector<T> w(n), coefficients(max_steps);
+	std::vector<T> d, e, last;
+
+	detail::arbitrary_unit_vector(basis[0]);
+	for (size_t j = 0; j < max_steps; j++) {
+		const auto q = std::span<const T>(basis[j]);
+		detail::multiply(std::span(w), mat, q, settings.threads);
+		alpha.push_back(dot(q, std::span<const T>(w)));
+
+		// Orthogonalize against the whole basis so far, twice: once is not enough in floating point
+		const auto so_far = Matrix_view<const T>(basis).subview(0, 0, j+1, n);
+		const auto c = std::span(coefficients).first(j+1);
+		for (int pass = 0; pass < 2; pass++) {
+			gemv(c, T(1), so_far, Transpose::no, std::span<const T>(w), T(0), settings.threads);
+			gemv(std::span(w), T(-1), so_far, Transpose::yes, std::span<const T>(c), T(1), settings.threads);
+		}
+		const T norm = sqrt(dot(std::span<const T>(w), std::span<const T>(w)));
+		result.steps = j+1;
+
+		// An invariant subspace, if the next vector has vanished: the eigenvalues found are exact
+		const bool invariant = j+1 == n
+				|| norm <= std::numeric_limits<T>::epsilon() * std::max(abs(alpha.back()), T(1));
+		const bool out_of_steps = j+1 == max_steps;
+		if (!invariant && !out_of_steps) {
+			beta.push_back(norm);
+			for (size_t i = 0; i < n; i++)
+				basis[j+1][i] = w[i] / norm;
+		}
+		if (!invariant && !out_of_steps && ((j+1) % check_every != 0 || j+1 < 2*count))
+			continue;
+
+		// Ritz values and the last components of their vectors: the residual of a Ritz pair
+		// is |norm * last|
+		d = alpha;
+		e = beta;
+		e.resize(d.size());
+		last.resize(d.size());
+		if (!detail::tridiagonal_eigenvalues(std::span(d), std::span(e), std::span(last)))
+			return result;
+		std::vector<size_t> order(d.size());
+		for (size_t i = 0; i < order.size(); i++)
+			order[i] = i;
+		std::ranges::sort(order, [&] (size_t i1, size_t i2) { return d[i1] < d[i2]; });
+
+		T largest_magnitude = 0;
+		for (const T& value: d)
+			largest_magnitude = std::max(largest_magnitude, abs(value));
+		const size_t num_smallest = std::min(count, (order.size() + 1) / 2);
+		const size_t num_largest = std::min(count, order.size() / 2);
+		// Having fewer than asked for is fine once the whole space is spanned: there are no more.
+		// An invariant subspace found before that holds only some of the eigenvalues
+		bool converged = num_largest == count || j+1 == n;
+		if (!invariant) {
+			for (size_t k = 0; k < num_smallest; k++)
+				converged &= abs(norm * last[order[k]]) <= T(settings.tolerance) * largest_magnitude;
+			for (size_t k = 0; k < num_largest; k++) {
+				const size_t i = order[order.size()-1 - k];
+				converged &= abs(norm * last[i]) <= T(settings.tolerance) * largest_magnitude;
+			}
+		}
+
+		if (converged || invariant || out_of_steps) {
+			result.converged = converged;
+			for (size_t k = 0; k < num_smallest; k++)
+				result.smallest.push_back(d[order[k]]);
+			for (size_t k = 0; k < num_largest; k++)
+				result.largest.push_back(d[order[order.size() - num_largest + k]]);
+			return result;
+		}
+	}
+	return result;
+}
+
+} // namespace math
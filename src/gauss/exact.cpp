@@ -0,0 +1,328 @@
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <cmath>
+#include <gauss/exact.hpp>
+#include <gauss/modular.hpp>
+#include <gauss/solve.hpp>
+#include <limits>
+#include <optional>
+
+namespace math {
+namespace {
+
+// A nonsingular A is singular modulo this many primes in a row with negligible probability
+constexpr size_t max_singular_primes = 3;
+
+// The system scaled to integers: element (row, col) is mantissa * 2^shift
+struct Integer_system {
+	struct Element {
+		std::int64_t mantissa;
+		std::uint32_t shift;
+	};
+	size_t n = 0;
+	std::vector<Element> elements; // row by row
+	std::uint32_t max_shift = 0;
+	// Hadamard's bound on the determinant of A and on those of A with a column replaced by b,
+	// which are the numerators and the denominator of the solution by Cramer's rule
+	double log2_bound = 0;
+
+	const Element& at (size_t row, size_t col) const { return elements[row * (n+1) + col]; }
+};
+
+// Each row is scaled by the power of two that makes its smallest nonzero element an odd integer
+std::optional<Integer_system> scale_to_integers (Matrix_view<const double> system)
+{
+	Integer_system result;
+	result.n = system.rows();
+	result.elements.resize(system.rows() * system.cols());
+	std::vector<int> exponents(system.cols());
+
+	for (size_t row = 0; row < system.rows(); row++) {
+		const auto values = system[row];
+		const auto elements = std::span(result.elements).subspan(row * system.cols(), system.cols());
+		int min_exponent = std::numeric_limits<int>::max(), max_exponent = std::numeric_limits<int>::min();
+		for (size_t col = 0; col < values.size(); col++) {
+			if (!std::isfinite(values[col]))
+				return std::nullopt;
+			// values[col] = mantissa * 2^exponent, with an odd mantissa
+			int exponent = 0;
+			auto mantissa = std::int64_t(std::ldexp(std::frexp(values[col], &exponent), 53));
+			exponent -= 53;
+			if (mantissa != 0) {
+				const int zeros = std::countr_zero(std::uint64_t(mantissa));
+				mantissa /= std::int64_t(1) << zeros;
+				exponent += zeros;
+				min_exponent = std::min(min_exponent, exponent);
+				max_exponent = std::max(max_exponent, exponent);
+			}
+			elements[col].mantissa = mantissa;
+			exponents[col] = exponent;
+		}
+		if (min_exponent > max_exponent)
+			continue; // all zeros
+
+		double norm_square = 0; // scaled down by 4^(max_exponent - min_exponent)
+		for (size_t col = 0; col < values.size(); col++) {
+			if (elements[col].mantissa == 0) {
+				elements[col].shift = 0;
+				continue;
+			}
+			elements[col].shift = std::uint32_t(exponents[col] - min_exponent);
+			result.max_shift = std::max(result.max_shift, elements[col].shift);
+			const double scaled = std::ldexp(double(elements[col].mantissa), exponents[col] - max_exponent);
+			norm_square += scaled * scaled;
+		}
+		result.log2_bound += (max_exponent - min_exponent) + std::log2(norm_square) / 2;
+	}
+	return result;
+}
+
+// The solution modulo the current Mod_p modulus, or nothing if A is singular modulo it
+std::optional<std::vector<std::uint32_t>> solve_modulo (const Integer_system& system)
+{
+	const size_t n = system.n;
+	std::vector<Mod_p> powers_of_two(system.max_shift + 1);
+	powers_of_two[0] = 1;
+	for (size_t i = 1; i < powers_of_two.size(); i++)
+		powers_of_two[i] = powers_of_two[i-1] + powers_of_two[i-1];
+
+	Matrix<Mod_p> mat(n, n+1);
+	for (size_t row = 0; row < n; row++) {
+		for (size_t col = 0; col <= n; col++) {
+			const auto& element = system.at(row, col);
+			mat[row][col] = Mod_p(element.mantissa) * powers_of_two[element.shift];
+		}
+	}
+
+	std::vector<size_t> permute_equations(n), permute_variables(n);
+	gauss_triangulate_pivoting(Matrix_view<Mod_p>(mat), std::span(permute_equations),
+			std::span(permute_variables));
+	std::vector<Mod_p> raw_solution(n);
+	if (gauss_gather(std::span(raw_solution), Matrix_view<Mod_p>(mat)) != 0)
+		return std::nullopt;
+
+	std::vector<std::uint32_t> solution(n);
+	for (size_t i = 0; i < n; i++)
+		solution[permute_variables[i]] = raw_solution[i].residue();
+	return solution;
+}
+
+// Deterministic Miller-Rabin: these bases are enough for all n < 4759123141
+bool is_prime (std::uint32_t n)
+{
+	if (n < 2 || n % 2 == 0)
+		return n == 2;
+	const auto power = [n] (std::uint64_t base, std::uint32_t exponent) {
+		std::uint64_t result = 1;
+		for (; exponent > 0; exponent >>= 1, base = base * base % n) {
+			if (exponent & 1)
+				result = result * base % n;
+		}
+		return result;
+	};
+	const int twos = std::countr_zero(n-1);
+	const std::uint32_t odd = (n-1) >> twos;
+	for (std::uint32_t base: { 2u, 7u, 61u }) {
+		if (base % n == 0)
+			continue;
+		std::uint64_t x = power(base, odd);
+		if (x == 1 || x == n-1)
+			continue;
+		bool composite = true;
+		for (int i = 1; i < twos && composite; i++) {
+			x = x * x % n;
+			composite = x != n-1;
+		}
+		if (composite)
+			return false;
+	}
+	return true;
+}
+
+// The solution modulo the product of the primes so far, each component in [0, modulus)
+struct Chinese_remainders {
+	Big_int modulus = 1;
+	std::vector<Big_int> residues;
+
+	void add (std::uint32_t p, const std::vector<std::uint32_t>& solution)
+	{
+		// x = r + modulus * t, with t such that x = solution modulo p
+		const Mod_p::Modulus_scope scope(p);
+		const Mod_p inverse_modulus = inverse(Mod_p(modulus.mod(p)));
+		for (size_t i = 0; i < residues.size(); i++) {
+			const Mod_p t = (Mod_p(solution[i]) - Mod_p(residues[i].mod(p))) * inverse_modulus;
+			residues[i] = residues[i] + modulus * Big_int(t.residue());
+		}
+		modulus = modulus * Big_int(p);
+	}
+};
+
+// The fraction with the numerator and the denominator below 2^bound_bits that is congruent
+// to `u` modulo `m`, if there is one. There is at most one if 2^(2*bound_bits + 1) <= m
+std::optional<Fraction> reconstruct (const Big_int& u, const Big_int& m, size_t bound_bits)
+{
+	// The extended Euclidean algorithm on (m, u), stopped halfway: r1 = t1 * u modulo m throughout
+	Big_int r0 = m, r1 = u, t0 = 0, t1 = 1;
+	while (r1.bits() > bound_bits) {
+		const Big_int q = r0 / r1;
+		r0 = r0 - q * r1;
+		std::swap(r0, r1);
+		t0 = t0 - q * t1;
+		std::swap(t0, t1);
+	}
+	if (t1.bits() > bound_bits)
+		return std::nullopt;
+	Fraction result { t1.is_negative() ? -r1 : r1, t1.abs() };
+	if (gcd(result.numerator, result.denominator) != Big_int(1))
+		return std::nullopt;
+	return result;
+}
+
+std::optional<std::vector<Fraction>> reconstruct_all (const Chinese_remainders& crt, size_t bound_bits)
+{
+	std::vector<Fraction> result;
+	result.reserve(crt.residues.size());
+	// The components usually share most of their denominators: when `common` times a residue is
+	// small modulo the primes, that is the numerator over `common`, with no need for reconstruction
+	Big_int common = 1;
+	const Big_int half_modulus = crt.modulus / Big_int(2);
+	for (const Big_int& u: crt.residues) {
+		Big_int v = common * u % crt.modulus;
+		if (v > half_modulus)
+			v = v - crt.modulus;
+		if (v.bits() <= bound_bits && common.bits() <= bound_bits) {
+			const Big_int divisor = gcd(v, common);
+			result.push_back({ v / divisor, common / divisor });
+			continue;
+		}
+		auto fraction = reconstruct(u, crt.modulus, bound_bits);
+		if (!fraction)
+			return std::nullopt;
+		common = common / gcd(common, fraction->denominator) * fraction->denominator;
+		result.push_back(std::move(*fraction));
+	}
+	return result;
+}
+
+// Whether `fractions` are `solution` modulo p
+bool agree
+(const std::vector<Fraction>& fractions, std::uint32_t p, const std::vector<std::uint32_t>& solution)
+{
+	const Mod_p::Modulus_scope scope(p);
+	for (size_t i = 0; i < fractions.size(); i++) {
+		const Mod_p denominator = fractions[i].denominator.mod(p);
+		Mod_p numerator = fractions[i].numerator.mod(p);
+		if (fractions[i].numerator.is_negative())
+			numerator = -numerator;
+		if (denominator == 0 || numerator / denominator != Mod_p(solution[i]))
+			return false;
+	}
+	return true;
+}
+
+} // namespace
+
+double to_double (const Fraction& fraction)
+{
+	// Only the leading bits of each matter, and shifting them off keeps both in range
+	const auto leading = [] (const Big_int& x) -> std::pair<double, int> {
+		const size_t shift = x.bits() > 64 ? x.bits() - 64 : 0;
+		return { x.abs_shifted_right(shift).to_double(), int(shift) };
+	};
+	const auto [numerator, numerator_shift] = leading(fraction.numerator);
+	const auto [denominator, denominator_shift] = leading(fraction.denominator);
+	const double result = std::ldexp(numerator / denominator, numerator_shift - denominator_shift);
+	return fraction.numerator.is_negative() ? -result : result;
+}
+
+std::string to_string (const Fraction& fraction)
+{
+	if (fraction.denominator == Big_int(1))
+		return fraction.numerator.to_string();
+	return fraction.numerator.to_string() + "/" + fraction.denominator.to_string();
+}
+
+Exact_result exact_solve (Matrix_view<const double> system, const Exact_settings& settings)
+{
+	const size_t n = system.rows();
+	assert(n > 0 && system.cols() == n+1);
+	Exact_result result;
+
+	const auto integer_system = scale_to_integers(system);
+	if (!integer_system) {
+		result.status = Exact_status::not_finite;
+		return result;
+	}
+	// Past this, reconstruction is sure to succeed, and to be right (with a few bits to spare
+	// for the rounding in the bound)
+	const size_t certain_bits = 2 * size_t(std::ceil(integer_system->log2_bound)) + 8;
+
+	const unsigned batch = std::max(settings.threads, 1u);
+	std::vector<std::uint32_t> primes(batch);
+	std::vector<std::optional<std::vector<std::uint32_t>>> solutions(batch);
+	std::uint32_t next_prime = Mod_p::max_modulus - 1;
+
+	Chinese_remainders crt { 1, std::vector<Big_int>(n) };
+	size_t solved = 0, singular = 0;
+	// The solution is reconstructed in full once its first component has settled,
+	// then that candidate is checked against the primes that follow
+	std::optional<Fraction> first_component;
+	std::optional<std::vector<Fraction>> candidate;
+
+	while (true) {
+		for (std::uint32_t& p: primes) {
+			while (!is_prime(next_prime))
+				next_prime--;
+			p = next_prime--;
+		}
+		parallel_for(0, batch, batch, 1, [&] (size_t begin, size_t end) {
+			for (size_t i = begin; i < end; i++) {
+				const Mod_p::Modulus_scope scope(primes[i]);
+				solutions[i] = solve_modulo(*integer_system);
+			}
+		});
+		result.primes += batch;
+
+		bool checked = false;
+		for (size_t i = 0; i < batch; i++) {
+			// Without a solution, either A is singular, or the prime divides its determinant
+			if (!solutions[i]) {
+				if (solved == 0 && ++singular == max_singular_primes) {
+					result.status = Exact_status::singular;
+					return result;
+				}
+				continue;
+			}
+			solved++;
+			if (candidate && !agree(*candidate, primes[i], *solutions[i]))
+				candidate.reset();
+			checked |= candidate.has_value();
+			crt.add(primes[i], *solutions[i]);
+		}
+		if (candidate && checked) {
+			result.solution = std::move(*candidate);
+			return result;
+		}
+		if (solved == 0)
+			continue;
+
+		const size_t bound_bits = (crt.modulus.bits() - 2) / 2;
+		if (crt.modulus.bits() >= certain_bits) {
+			// Only a bound rounded the wrong way could make it fail, and more primes fix that
+			candidate = reconstruct_all(crt, bound_bits);
+			if (!candidate)
+				continue;
+			result.solution = std::move(*candidate);
+			return result;
+		}
+		if (!candidate) {
+			auto first = reconstruct(crt.residues[0], crt.modulus, bound_bits);
+			if (first && first == first_component)
+				candidate = reconstruct_all(crt, bound_bits);
+			first_component = std::move(first);
+		}
+	}
+}
+
+} // namespace math
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <gauss/big-int.hpp>
+#include <gauss/matrix.hpp>
+#include <string>
+#include <vector>
+
+// Exact solutions of square systems, as fractions, without rounding anywhere.
+// Every double is an integer times a power of two, so scaling each equation by a power of two
+// makes the system integer with the same solution. That is solved modulo primes below 2^31,
+// by gauss_triangulate_pivoting() on Mod_p with vectorized row operations, one prime per thread,
+// and the residues are combined by the Chinese remainder theorem. Once the product of the primes
+// is large enough, rational reconstruction recovers the fractions from the combined residues.
+//
+// Solving stops as soon as the fractions stabilize: when the residues for the next primes agree
+// with them. Hadamard's bound on their numerators and denominators caps how many primes that
+// can take, but the bound is usually far too pessimistic to wait for.
+// Elimination is O(n^3) per prime and the fractions of a well conditioned n by n system with
+// arbitrary doubles tend to have O(n) digits, so this is for integer systems of modest size,
+// or small ill-conditioned ones
+
+namespace math {
+
+// In lowest terms, with a positive denominator
+struct Fraction {
+	Big_int numerator, denominator = 1;
+
+	friend bool operator== (const Fraction&, const Fraction&) = default;
+};
+
+// Rounded to a double, or an infinity if out of range
+double to_double (const Fraction&);
+// "numerator/denominator", or just the numerator if the denominator is 1
+std::string to_string (const Fraction&);
+
+struct Exact_settings {
+	unsigned threads = 1; // also how many primes are solved with at once
+};
+
+enum class Exact_status { ok, singular, not_finite };
+
+struct Exact_result {
+	Exact_status status = Exact_status::ok;
+	size_t primes = 0; // solved modulo, including the ones that had to be skipped
+	std::vector<Fraction> solution; // only when the status is ok
+};
+
+// Solve the square system given as the augmented matrix [A | b].
+// A is found singular when it is so modulo the first few primes, which a nonsingular A is only
+// if its determinant is divisible by all of them
+Exact_result exact_solve (Matrix_view<const double> system, const Exact_settings& = {});
+
+} // namespace math
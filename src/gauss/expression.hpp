@@ -0,0 +1,273 @@
+#pragma once
+
+#include <concepts>
+#include <gauss/gemm.hpp>
+#include <gauss/kernels.hpp>
+#include <gauss/matrix.hpp>
+#include <vector>
+
+// Lazy arithmetic on vectors and matrices: the operators only build an expression, and evaluate()
+// computes it into a destination in a single pass, with no temporaries. Operands are wrapped by lazy():
+//   evaluate(std::span(r), lazy(a) * lazy(x) - lazy(b), threads);   // r = A*x - b
+//   evaluate(c, lazy(a) * lazy(b) + 2.0 * lazy(d), threads);       // C = A*B + 2*D
+// Expressions are linear combinations of vectors and matrices, of products of a matrix with
+// a vector and of products of two matrices. The operands of products can't be expressions.
+//
+// A vector expression is computed element by element, each product with a matrix by dot().
+// Of a matrix expression, everything but the products is computed element by element first,
+// then gemm() adds each product onto that, so products run cache-blocked.
+// The destination may be an operand as well, but not of a product.
+// Expressions refer to their operands, so they mustn't outlive them
+
+namespace math {
+
+namespace detail {
+struct Lazy_vector_shape {};
+struct Lazy_matrix_shape {};
+} // namespace detail
+
+template <typename E> concept Lazy_vector_expression = requires { typename E::lazy_shape; }
+		&& std::same_as<typename E::lazy_shape, detail::Lazy_vector_shape>;
+template <typename E> concept Lazy_matrix_expression = requires { typename E::lazy_shape; }
+		&& std::same_as<typename E::lazy_shape, detail::Lazy_matrix_shape>;
+template <typename E> concept Lazy_expression = Lazy_vector_expression<E> || Lazy_matrix_expression<E>;
+
+// Nodes of vector expressions have:
+//   size (), and operator[] for their elements;
+//   cost (): roughly how many elements are read for each element of the result.
+// Nodes of matrix expressions have:
+//   rows () and cols ();
+//   element (row, col): of the expression with all its products left out;
+//   has_elementwise: whether there is anything but products;
+//   for_each_product (factor, f): calls f(coefficient, product) for every product, with its
+//   coefficient in the expression times `factor`
+
+// A vector: a span, or a column of a matrix
+template <typename V> struct Lazy_vector {
+	using lazy_shape = detail::Lazy_vector_shape;
+	using value_type = std::remove_const_t<typename V::element_type>;
+
+	V v;
+
+	size_t size () const { return v.size(); }
+	size_t cost () const { return 1; }
+	value_type operator[] (size_t i) const { return v[i]; }
+};
+
+template <typename T> struct Lazy_matrix {
+	using lazy_shape = detail::Lazy_matrix_shape;
+	using value_type = T;
+	constexpr static bool has_elementwise = true;
+
+	Matrix_view<const T> view;
+
+	size_t rows () const { return view.rows(); }
+	size_t cols () const { return view.cols(); }
+	T element (size_t row, size_t col) const { return view[row][col]; }
+	template <typename F> void for_each_product (T, F&&) const {}
+};
+
+// The vector is a span or a column of a matrix, as in Lazy_vector
+template <typename T, typename V> struct Lazy_matrix_vector_product {
+	using lazy_shape = detail::Lazy_vector_shape;
+	using value_type = T;
+
+	Matrix_view<const T> a;
+	V x;
+
+	size_t size () const { return a.rows(); }
+	size_t cost () const { return x.size(); }
+	T operator[] (size_t i) const
+	{
+		if constexpr (std::same_as<V, std::span<const T>>) {
+			return dot(a[i], x);
+		} else {
+			// A column is strided, which dot() doesn't take
+			const auto row = a[i];
+			T sum = 0;
+			for (size_t k = 0; k < x.size(); k++)
+				sum += row[k] * x[k];
+			return sum;
+		}
+	}
+};
+
+template <typename T> struct Lazy_matrix_product {
+	using lazy_shape = detail::Lazy_matrix_shape;
+	using value_type = T;
+	constexpr static bool has_elementwise = false;
+
+	Matrix_view<const T> a, b;
+
+	size_t rows () const { return a.rows(); }
+	size_t cols () const { return b.cols(); }
+	T element (size_t, size_t) const { return 0; }
+	template <typename F> void for_each_product (T factor, F&& f) const { f(factor, *this); }
+};
+
+template <Lazy_expression L, Lazy_expression R, bool Subtract> struct Lazy_sum {
+	using lazy_shape = typename L::lazy_shape;
+	using value_type = typename L::value_type;
+	constexpr static bool has_elementwise = []{
+		if constexpr (Lazy_matrix_expression<L>)
+			return L::has_elementwise || R::has_elementwise;
+		return true;
+	}();
+
+	L l;
+	R r;
+
+	size_t size () const { return l.size(); }
+	size_t cost () const { return l.cost() + r.cost(); }
+	value_type operator[] (size_t i) const { return Subtract ? l[i] - r[i] : l[i] + r[i]; }
+
+	size_t rows () const { return l.rows(); }
+	size_t cols () const { return l.cols(); }
+	value_type element (size_t row, size_t col) const
+	{
+		if constexpr (!R::has_elementwise)
+			return l.element(row, col);
+		else if constexpr (!L::has_elementwise)
+			return Subtract ? -r.element(row, col) : r.element(row, col);
+		else if constexpr (Subtract)
+			return l.element(row, col) - r.element(row, col);
+		else
+			return l.element(row, col) + r.element(row, col);
+	}
+	template <typename F> void for_each_product (value_type factor, F&& f) const
+	{
+		l.for_each_product(factor, f);
+		r.for_each_product(Subtract ? -factor : factor, f);
+	}
+};
+
+template <Lazy_expression E> struct Lazy_scaled {
+	using lazy_shape = typename E::lazy_shape;
+	using value_type = typename E::value_type;
+	constexpr static bool has_elementwise = []{
+		if constexpr (Lazy_matrix_expression<E>)
+			return E::has_elementwise;
+		return true;
+	}();
+
+	value_type factor;
+	E e;
+
+	size_t size () const { return e.size(); }
+	size_t cost () const { return e.cost(); }
+	value_type operator[] (size_t i) const { return factor * e[i]; }
+
+	size_t rows () const { return e.rows(); }
+	size_t cols () const { return e.cols(); }
+	value_type element (size_t row, size_t col) const { return factor * e.element(row, col); }
+	template <typename F> void for_each_product (value_type f_factor, F&& f) const
+	{
+		e.for_each_product(f_factor * factor, f);
+	}
+};
+
+template <typename T> auto lazy (std::span<T> v)
+{
+	return Lazy_vector<std::span<const std::remove_const_t<T>>> { v };
+}
+template <typename T> auto lazy (const std::vector<T>& v) { return lazy(std::span<const T>(v)); }
+template <typename C> requires std::same_as<C, typename Matrix_view<typename C::element_type>::column_ref>
+auto lazy (C column)
+{
+	return Lazy_vector<C> { column };
+}
+template <typename T> auto lazy (Matrix_view<T> m) { return Lazy_matrix<std::remove_const_t<T>> { m }; }
+template <typename T> auto lazy (const Matrix<T>& m) { return lazy(Matrix_view<const T>(m)); }
+
+namespace detail {
+template <typename L, typename R> concept Lazy_compatible = Lazy_expression<L> && Lazy_expression<R>
+		&& std::same_as<typename L::lazy_shape, typename R::lazy_shape>
+		&& std::same_as<typename L::value_type, typename R::value_type>;
+
+template <typename L, typename R>
+void assert_same_shape ([[maybe_unused]] const L& l, [[maybe_unused]] const R& r)
+{
+	if constexpr (Lazy_vector_expression<L>)
+		assert(l.size() == r.size());
+	else
+		assert(l.rows() == r.rows() && l.cols() == r.cols());
+}
+} // namespace detail
+
+template <typename L, typename R> requires detail::Lazy_compatible<L, R>
+Lazy_sum<L, R, false> operator+ (const L& l, const R& r)
+{
+	detail::assert_same_shape(l, r);
+	return { l, r };
+}
+template <typename L, typename R> requires detail::Lazy_compatible<L, R>
+Lazy_sum<L, R, true> operator- (const L& l, const R& r)
+{
+	detail::assert_same_shape(l, r);
+	return { l, r };
+}
+
+template <Lazy_expression E> Lazy_scaled<E> operator* (typename E::value_type factor, const E& e)
+{
+	return { factor, e };
+}
+template <Lazy_expression E> Lazy_scaled<E> operator* (const E& e, typename E::value_type factor)
+{
+	return { factor, e };
+}
+template <Lazy_expression E> Lazy_scaled<E> operator- (const E& e) { return { -1, e }; }
+
+template <typename T, typename V> requires std::same_as<T, typename Lazy_vector<V>::value_type>
+Lazy_matrix_vector_product<T, V> operator* (const Lazy_matrix<T>& a, const Lazy_vector<V>& x)
+{
+	assert(a.cols() == x.size());
+	return { a.view, x.v };
+}
+template <typename T> Lazy_matrix_product<T> operator* (const Lazy_matrix<T>& a, const Lazy_matrix<T>& b)
+{
+	assert(a.cols() == b.rows());
+	return { a.view, b.view };
+}
+
+// Rows are split between up to `threads` threads, and so is every product of two matrices
+template <typename T, Lazy_vector_expression E> requires std::same_as<T, typename E::value_type>
+void evaluate (std::span<T> dest, const E& e, unsigned threads = 1)
+{
+	assert(dest.size() == e.size());
+	const size_t min_per_thread = 1 + parallel_min_elements / std::max<size_t>(e.cost(), 1);
+	parallel_for(0, dest.size(), threads, min_per_thread, [&] (size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++)
+			dest[i] = e[i];
+	});
+}
+
+template <typename T, Lazy_matrix_expression E> requires std::same_as<T, typename E::value_type>
+void evaluate (Matrix_view<T> dest, const E& e, unsigned threads = 1)
+{
+	assert(dest.rows() == e.rows() && dest.cols() == e.cols());
+	T beta = 0;
+	if constexpr (E::has_elementwise) {
+		const size_t min_rows_per_thread = 1 + parallel_min_elements / std::max<size_t>(dest.cols(), 1);
+		parallel_for(dest.begin(), dest.end(), threads, min_rows_per_thread, [&] (auto begin, auto end) {
+			for (auto it = begin; it != end; ++it) {
+				const size_t row = it - dest.begin();
+				const auto out = *it;
+				for (size_t col = 0; col < out.size(); col++)
+					out[col] = e.element(row, col);
+			}
+		});
+		beta = 1;
+	}
+	e.for_each_product(T(1), [&] (T factor, const Lazy_matrix_product<T>& product) {
+		gemm(dest, factor, product.a, Transpose::no, product.b, Transpose::no, beta, threads);
+		beta = 1;
+	});
+}
+
+template <typename T, Lazy_matrix_expression E> requires std::same_as<T, typename E::value_type>
+void evaluate (Matrix<T>& dest, const E& e, unsigned threads = 1)
+{
+	evaluate(Matrix_view<T>(dest), e, threads);
+}
+
+} // namespace math
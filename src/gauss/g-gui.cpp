@@ -1,8 +1,15 @@
+#include <cstdio>
 #include <fstream>
+#include <gauss/eigen.hpp>
+#include <gauss/expression.hpp>
 #include <gauss/g-gui.hpp>
+#include <gauss/kernels.hpp>
+#include <gauss/lu.hpp>
 #include <gauss/solve.hpp>
+#include <gauss/sparse.hpp>
 #include <gui.hpp>
 #include <imhelper.hpp>
+#include <util/thread-pool.hpp>
 #include <util/util.hpp>
 
 using namespace ImGui;
@@ -27,6 +34,18 @@ static auto matrix_table (const char* label, unsigned columns, float factor)
 			ImVec2(0, (1.0f - factor) * GetContentRegionAvail().y));
 }
 
+// Call `f(row)` for the rows of the current table that are in view; the others are only
+// accounted for in the scrolling range. All rows must be one line high
+template <typename F> static void for_visible_rows (size_t rows, F&& f)
+{
+	ImGuiListClipper clipper;
+	clipper.Begin(int(rows));
+	while (clipper.Step()) {
+		for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; row++)
+			f(size_t(row));
+	}
+}
+
 // ======================================= Input =======================================
 
 void Gauss::Input::widget ()
@@ -38,6 +57,14 @@ void Gauss::Input::widget ()
 			do_load_file |= Button("Загрузить");
 			if (do_load_file)
 				last_file_load_status = load_from_file(path_buf);
+			SameLine();
+			if (Button("Преобразовать в двоичный формат"))
+				last_file_load_status = convert_to_matrix_file(path_buf);
+			if (IsItemHovered()) {
+				auto tooltip = Tooltip();
+				TextFmt(FMT_STRING("Файл {}.bin будет загружаться без разбора текста и без копирования"),
+						path_buf);
+			}
 
 			switch (last_file_load_status) {
 			case File_load_status::ok:
@@ -45,6 +72,9 @@ void Gauss::Input::widget ()
 			case File_load_status::unreadable:
 				TextColored(gui::error_text_color, "Не удалось прочитать файл");
 				break;
+			case File_load_status::unwritable:
+				TextColored(gui::error_text_color, "Не удалось записать двоичный файл");
+				break;
 			case File_load_status::bad_dimensions:
 				TextColored(gui::error_text_color, "Некорректные размерности матрицы в файле");
 				break;
@@ -54,55 +84,143 @@ void Gauss::Input::widget ()
 			}
 		}
 
-		if (auto item = TabItem("Ввести матрицу")) {
-			Slider("строк",    &rows, 1u, max_rows, nullptr, ImGuiSliderFlags_AlwaysClamp);
-			Slider("столбцов", &cols, 2u, max_cols, nullptr, ImGuiSliderFlags_AlwaysClamp);
+		if (auto item = TabItem("Ввести матрицу"))
+			edit_widget();
+	}
+
+	SeparatorText("Уравнения");
+	equations_widget();
+}
 
-			if (auto table = matrix_table("input", cols, 0.5)) {
-				constexpr float col_width = 100;
-				for (unsigned col = 0; col < num_variables(); col++) {
-					TableSetupColumn(fmt::format(FMT_STRING("X{}"), col+1).c_str(),
-							ImGuiTableColumnFlags_WidthFixed, col_width);
-				}
-				TableSetupColumn("", ImGuiTableColumnFlags_WidthFixed, col_width);
-				BeginDisabled();
-				TableHeadersRow();
-				EndDisabled();
-
-				auto mat = view();
-				for (unsigned row = 0; row < rows; row++) {
-					TableNextRow();
-					for (unsigned col = 0; col < cols; col++) {
-						TableNextColumn();
-						InputNumber(GenerateId(row, col), &mat[row][col]);
-					}
-				}
-			}
+void Gauss::Input::edit_widget ()
+{
+	if (rows() > max_edit_rows || cols() > max_edit_cols) {
+		TextFmtWrapped(FMT_STRING("Матрица {}×{} слишком велика для ручного ввода."), rows(), cols());
+		if (Button("Начать с пустой матрицы"))
+			resize(4, 4);
+		return;
+	}
+
+	unsigned new_rows = rows(), new_cols = cols();
+	Slider("строк",    &new_rows, 1u, max_edit_rows, nullptr, ImGuiSliderFlags_AlwaysClamp);
+	Slider("столбцов", &new_cols, 2u, max_edit_cols, nullptr, ImGuiSliderFlags_AlwaysClamp);
+	if (new_rows != rows() || new_cols != cols())
+		resize(new_rows, new_cols);
+
+	if (auto table = matrix_table("input", cols(), 0.5)) {
+		constexpr float col_width = 100;
+		for (size_t col = 0; col < num_variables(); col++) {
+			TableSetupColumn(fmt::format(FMT_STRING("X{}"), col+1).c_str(),
+					ImGuiTableColumnFlags_WidthFixed, col_width);
 		}
+		TableSetupColumn("", ImGuiTableColumnFlags_WidthFixed, col_width);
+		TableSetupScrollFreeze(0, 1);
+		BeginDisabled();
+		TableHeadersRow();
+		EndDisabled();
+
+		auto mat = dense.view();
+		for_visible_rows(rows(), [&] (size_t row) {
+			TableNextRow();
+			for (size_t col = 0; col < cols(); col++) {
+				if (TableNextColumn())
+					InputNumber(GenerateId(row, col), &mat[row][col]);
+			}
+		});
 	}
+}
 
-	SeparatorText("Уравнения");
-	if (auto table = matrix_table("equations", cols, 1.0)) {
+void Gauss::Input::equations_widget () const
+{
+	if (!small_enough_to_show()) {
+		TextFmtWrapped(FMT_STRING("{} уравнений с {} неизвестными. Ненулевых элементов: {} ({:.2f}%), "
+				"наибольший по модулю: {}"), num_equations(), num_variables(),
+				nonzero_elements, 100.0 * nonzero_elements / (double(rows()) * cols()), max_abs_element);
+		if (sparse)
+			TextWrapped("Система слишком велика для плотного хранения и будет решена разреженным методом.");
+		return;
+	}
+
+	// Only the cells in view are formatted. The free term column keeps two texts apiece,
+	// the second one for rows without terms
+	if (auto table = matrix_table("equations", cols(), 1.0)) {
 		auto mat = view();
-		for (unsigned row = 0; row < rows; row++) {
+		for_visible_rows(rows(), [&] (size_t row) {
 			TableNextRow();
-			bool first_term = true;
-			for (unsigned col = 0; col+1 < cols; col++) {
-				TableNextColumn();
-				Number value = mat[row][col];
-				if (value == 0)
+			const auto terms = mat[row].first(num_variables());
+			const size_t first_term = std::find_if(terms.begin(), terms.end(),
+					[] (Number value) { return value != 0; }) - terms.begin();
+			for (size_t col = 0; col < num_variables(); col++) {
+				if (!TableNextColumn() || terms[col] == 0)
 					continue;
-				char sign = (value > 0) ? '+' : '-';
-				if (sign == '+' && first_term) {
-					sign = ' ';
-					first_term = false;
-				}
-				TextFmt(FMT_STRING("{} {}·X{} "), sign, std::abs(value), col+1);
+				const auto format = [col] (Number value) {
+					return fmt::format(FMT_STRING("{} {}·X{} "), value > 0 ? '+' : '-',
+							std::abs(value), col+1);
+				};
+				const std::string& text = equation_texts.get(row, col, terms[col], format);
+				// The first term goes without a plus, and the space after it
+				const size_t skip = col == first_term && terms[col] > 0 ? 2 : 0;
+				TextUnformatted(text.c_str() + skip, text.c_str() + text.size());
 			}
-			TableNextColumn();
-			TextFmt(FMT_STRING("{} = {}"), first_term ? "0" : "", mat[row][cols-1]);
-		}
+			if (TableNextColumn()) {
+				const bool no_terms = first_term == num_variables();
+				const auto format = [no_terms] (Number value) {
+					return fmt::format(FMT_STRING("{} = {}"), no_terms ? "0" : "", value);
+				};
+				const size_t key_col = cols()-1 + no_terms;
+				const std::string& text = equation_texts.get(row, key_col, mat[row].back(), format);
+				TextUnformatted(text.c_str(), text.c_str() + text.size());
+			}
+		});
+	}
+}
+
+void Gauss::Input::resize (size_t new_rows, size_t new_cols)
+{
+	Sized_matrix resized(new_rows, new_cols);
+	if (!sparse) {
+		const size_t keep_rows = std::min(rows(), new_rows);
+		const size_t keep_cols = std::min(cols(), new_cols);
+		math::copy_matrix(resized.view().subview(0, 0, keep_rows, keep_cols),
+				view().subview(0, 0, keep_rows, keep_cols));
 	}
+	dense = std::move(resized);
+	sparse.reset();
+	mapped.reset();
+	count_elements();
+}
+
+void Gauss::Input::count_elements ()
+{
+	nonzero_elements = 0;
+	max_abs_element = 0;
+	const auto count = [&] (Number value) {
+		nonzero_elements += (value != 0);
+		max_abs_element = std::max(max_abs_element, std::abs(value));
+	};
+	if (sparse) {
+		for (Number value: sparse->values)
+			count(value);
+	} else {
+		for (auto row: view())
+			std::for_each(row.begin(), row.end(), count);
+	}
+}
+
+bool Gauss::Input::is_sparse () const
+{
+	if (num_equations() != num_variables() || num_variables() < structured_min_variables)
+		return false;
+
+	size_t nonzero = 0;
+	if (sparse) {
+		for (size_t col: sparse->col_index)
+			nonzero += (col < num_variables());
+	} else {
+		for (auto row: view())
+			nonzero += std::count_if(row.begin(), row.end()-1, [] (Number x) { return x != 0; });
+	}
+	return nonzero <= sparse_max_density * num_variables() * num_variables();
 }
 
 auto Gauss::Input::load_from_file (const char* filename) -> File_load_status
@@ -111,108 +229,877 @@ auto Gauss::Input::load_from_file (const char* filename) -> File_load_status
 	if (!file)
 		return File_load_status::unreadable;
 
-	Sized_static_matrix temp;
-	if (!(file >> temp.rows >> temp.cols))
+	// Matrix Market files start with a "%%MatrixMarket" banner
+	if (file.peek() == '%')
+		return load_matrix_market(file);
+	if (math::is_matrix_file(file))
+		return load_matrix_file(filename);
+
+	size_t new_rows, new_cols;
+	if (!(file >> new_rows >> new_cols))
 		return File_load_status::bad_data;
-	if (temp.rows < 1 || temp.rows > max_rows || temp.cols < 2 || temp.cols > max_cols)
-	 	return File_load_status::bad_dimensions;
+	if (new_rows < 1 || new_cols < 2 || new_rows > max_file_elements / new_cols)
+		return File_load_status::bad_dimensions;
 
-	for (unsigned row = 0; row < temp.rows; row++) {
-		for (unsigned col = 0; col < temp.cols; col++) {
-			if (!(file >> temp.view()[row][col]))
+	math::Matrix<Number> temp(new_rows, new_cols);
+	for (auto row: math::Matrix_view<Number>(temp)) {
+		for (Number& value: row) {
+			if (!(file >> value))
 				return File_load_status::bad_data;
 		}
 	}
 
-	this->Sized_static_matrix::operator=(temp);
+	dense.matrix = std::move(temp);
+	sparse.reset();
+	mapped.reset();
+	count_elements();
 	return File_load_status::ok;
 }
 
+auto Gauss::Input::load_matrix_market (std::istream& file) -> File_load_status
+{
+	auto loaded = math::load_matrix_market(file);
+	if (!loaded)
+		return File_load_status::bad_data;
+	if (loaded->rows < 1 || loaded->cols < 2)
+		return File_load_status::bad_dimensions;
+
+	if (loaded->rows > max_file_elements / loaded->cols) {
+		sparse = std::move(loaded);
+		dense = Sized_matrix(0, 0);
+	} else {
+		Sized_matrix temp(loaded->rows, loaded->cols);
+		loaded->to_dense(temp.view());
+		dense = std::move(temp);
+		sparse.reset();
+	}
+	mapped.reset();
+	count_elements();
+	return File_load_status::ok;
+}
+
+auto Gauss::Input::load_matrix_file (const char* filename) -> File_load_status
+{
+	auto loaded = math::Mapped_matrix::open(filename);
+	if (!loaded)
+		return File_load_status::bad_data;
+	const auto mat = loaded->view();
+	if (mat.rows() < 1 || mat.cols() < 2)
+		return File_load_status::bad_dimensions;
+
+	// Small matrices are copied so that they can be edited
+	if (mat.rows() <= max_edit_rows && mat.cols() <= max_edit_cols) {
+		Sized_matrix temp(mat.rows(), mat.cols());
+		math::copy_matrix(temp.view(), mat);
+		dense = std::move(temp);
+		mapped.reset();
+	} else {
+		mapped = std::move(loaded);
+		mapped_path = filename;
+		dense = Sized_matrix(0, 0);
+	}
+	sparse.reset();
+	count_elements();
+	return File_load_status::ok;
+}
+
+auto Gauss::Input::convert_to_matrix_file (const char* filename) -> File_load_status
+{
+	std::ifstream text(filename);
+	if (!text)
+		return File_load_status::unreadable;
+	const std::string binary_name = std::string(filename) + ".bin";
+	std::ofstream binary(binary_name, std::ios::binary);
+	if (!binary)
+		return File_load_status::unwritable;
+
+	const auto status = math::convert_text_matrix(text, binary);
+	binary.close();
+	if (status != math::Text_conversion_status::ok) {
+		std::remove(binary_name.c_str()); // don't leave a partial file behind
+		switch (status) {
+		case math::Text_conversion_status::bad_dimensions:
+			return File_load_status::bad_dimensions;
+		case math::Text_conversion_status::bad_data:
+			return File_load_status::bad_data;
+		default:
+			return File_load_status::unwritable;
+		}
+	}
+	return load_matrix_file(binary_name.c_str());
+}
+
 // ======================================= Output =======================================
 
-Gauss::Output::Output (const Input& in): Sized_static_matrix(in.rows, in.cols)
+Gauss::Output::Output (const Input& in, const Settings& settings, const Output* previous)
+	: equations(in.num_equations()),
+	  variables(in.num_variables())
 {
+	const bool square = num_equations() == num_variables();
+
+	if (square && settings.engine == Engine::iterative) {
+		solve_iterative(in, settings, previous);
+		return;
+	}
+
+	// Without dense storage, only the sparse solver and the iterative methods are left,
+	// and both need a square system
+	if (!in.stored_densely() && !square) {
+		unsupported = true;
+		return;
+	}
+
+	if (num_equations() > num_variables() && in.stored_densely() && settings.least_squares) {
+		solve_least_squares(in, settings);
+		return;
+	}
+
+	// Exact solutions are asked for explicitly, so no structure is looked for
+	if (square && in.stored_densely() && settings.engine == Engine::exact) {
+		solve_exact(in, settings);
+		return;
+	}
+
+	if (square && in.stored_densely() && settings.detect_structure
+	&& num_variables() >= structured_min_variables) {
+		const auto band = math::detect_bandwidth(in.view().subview(0, 0, num_equations(), num_variables()));
+		if (band.lower + band.upper + 1 <= band_max_width * num_variables()) {
+			solve_banded(in, band);
+			if (!singular)
+				return;
+			singular = false;
+			band_stats.reset();
+		}
+	}
+
+	const bool use_sparse = square && (settings.engine == Engine::sparse || !in.stored_densely()
+			|| (settings.detect_structure && in.is_sparse()));
+
+	if (use_sparse) {
+		solve_sparse(in);
+		// The dense engines can tell an inconsistent system from an indeterminate one
+		if (!singular || !in.stored_densely())
+			return;
+		singular = false;
+		sparse_stats.reset();
+	}
+
+	const double dense_bytes = double(in.rows()) * in.cols() * sizeof(Number);
+	const bool out_of_core = in.matrix_file() && dense_bytes > double(settings.memory_limit_mib) * (1 << 20);
+	const bool lu_engine = settings.engine == Engine::pivoting || settings.engine == Engine::blocked;
+
+	if (square && !out_of_core && lu_engine && settings.detect_structure && !settings.update_factorization
+	&& math::maybe_positive_definite(in.view().subview(0, 0, num_equations(), num_variables()))) {
+		solve_cholesky(in, settings);
+		if (*cholesky)
+			return;
+	}
+
+	if (out_of_core)
+		solve_out_of_core(in, settings);
+	else if (square && settings.engine == Engine::mixed)
+		solve_mixed(in, settings);
+	else if (square && lu_engine && settings.update_factorization)
+		solve_updating(in, settings, previous);
+	else
+		solve_dense(in, settings);
+}
+
+void Gauss::Output::solve_dense (const Input& in, const Settings& settings)
+{
+	triangular.emplace(in.rows(), in.cols());
+	auto view = triangular->view();
+	permute.resize(num_variables());
+	permute_equations.resize(num_equations());
+
 	// gauss_gather() gives the solution in a meaningless "raw" pre-permutation order
-	auto raw_solution = std::make_unique<Number[]>(num_variables());
-	std::span raw_solution_span { raw_solution.get(), size_t(num_variables()) };
+	std::vector<Number> raw_solution(num_variables());
 
-	permutations = math::gauss_triangulate(view(), in.view(), permute_span());
-	num_indeterminate_variables = math::gauss_gather(raw_solution_span, view());
+	{
+		using clock = std::chrono::steady_clock;
+		const auto start = clock::now();
+		switch (settings.engine) {
+		case Engine::reference:
+			permutations = math::gauss_triangulate(view, in.view(), std::span(permute));
+			for (size_t i = 0; i < num_equations(); i++)
+				permute_equations[i] = i;
+			break;
+		case Engine::pivoting:
+			permutations = math::gauss_triangulate_pivoting(view, in.view(),
+					std::span(permute_equations), std::span(permute), settings.threads);
+			break;
+		case Engine::blocked:
+		case Engine::sparse:
+		case Engine::mixed:
+		case Engine::exact:
+		case Engine::iterative:
+			permutations = math::gauss_triangulate_blocked(view, in.view(),
+					std::span(permute_equations), std::span(permute),
+					math::default_lu_block_size, settings.threads);
+			break;
+		}
+		triangulation_time = clock::now() - start;
+	}
+	for (size_t row = 1; row < view.rows() && !triangulation_error; row++) {
+		const auto below_diagonal = view[row].first(std::min(row, view.cols()));
+		triangulation_error = std::ranges::any_of(below_diagonal, [] (Number value) { return value != 0; });
+	}
+	num_indeterminate_variables = math::gauss_gather(std::span(raw_solution), view);
 
-	auto variables_view = view().subview(0, 0, num_equations(), num_variables());
+	auto variables_view = view.subview(0, 0, num_equations(), num_variables());
 
 	if (num_equations() == num_variables()) {
 		determinant = math::triangular_determinant(variables_view);
 		if (permutations % 2 == 1)
-			determinant = -determinant;
+			determinant = -*determinant;
 	}
 
 	if (num_indeterminate_variables == 0) {
-		mul_matrix_vector(mismatch_span(), variables_view, raw_solution_span);
-		for (unsigned i = 0; i < num_equations(); i++)
-			mismatch[i] -= view()[i][cols-1];
-		for (unsigned i = 0; i < num_variables(); i++)
+		solution.resize(num_variables());
+		for (size_t i = 0; i < num_variables(); i++)
 			solution[permute[i]] = raw_solution[i];
+		// Both permutations are undone by measuring against the system as it was input
+		mismatch.resize(num_equations());
+		math::residual(std::span(mismatch), in.view(), std::span<const Number>(solution), settings.threads);
 	}
 }
 
-void Gauss::Output::widget () const
+void Gauss::Output::solve_out_of_core (const Input& in, const Settings& settings)
+{
+	out_of_core_stats = Out_of_core_stats {
+		.status = math::Out_of_core_status::ok,
+		.work_file = std::string(in.matrix_file()) + ".work",
+	};
+	const math::Out_of_core_settings oc_settings {
+		.memory_limit = size_t(settings.memory_limit_mib) << 20,
+		.threads = settings.threads,
+	};
+
+	using clock = std::chrono::steady_clock;
+	const auto start = clock::now();
+	auto result = math::out_of_core_solve(in.matrix_file(), out_of_core_stats->work_file.c_str(),
+			oc_settings);
+	triangulation_time = clock::now() - start;
+	out_of_core_stats->status = result.status;
+	if (result.status != math::Out_of_core_status::ok)
+		return;
+
+	permutations = result.permutations;
+	permute = std::move(result.permute_variables);
+	num_indeterminate_variables = result.classification;
+
+	if (num_equations() == num_variables()) {
+		// Only the main diagonal of the triangular matrix is needed, and it's cheap to map
+		if (const auto triangulated = math::Mapped_matrix::open(out_of_core_stats->work_file.c_str())) {
+			const auto view = triangulated->view();
+			determinant = math::triangular_determinant(view.subview(0, 0, num_equations(), num_variables()));
+			if (permutations % 2 == 1)
+				determinant = -*determinant;
+		}
+	}
+
+	if (num_indeterminate_variables == 0) {
+		solution.resize(num_variables());
+		for (size_t i = 0; i < num_variables(); i++)
+			solution[permute[i]] = result.raw_solution[i];
+		mismatch.resize(num_equations());
+		math::residual(std::span(mismatch), in.view(), std::span<const Number>(solution), settings.threads);
+	}
+}
+
+void Gauss::Output::solve_mixed (const Input& in, const Settings& settings)
+{
+	const auto coefficients = in.view().subview(0, 0, num_equations(), num_variables());
+	std::vector<Number> free_terms(num_equations());
+	for (size_t i = 0; i < num_equations(); i++)
+		free_terms[i] = in.view()[i][num_variables()];
+	solution.resize(num_variables());
+
+	using clock = std::chrono::steady_clock;
+	const auto start = clock::now();
+	refinement = math::mixed_precision_solve<float>(coefficients, std::span(solution),
+			std::span<const Number>(free_terms), {}, settings.threads);
+	triangulation_time = clock::now() - start;
+	singular = refinement->singular;
+	if (singular)
+		return;
+
+	mismatch.resize(num_equations());
+	const auto residual = math::lazy(coefficients) * math::lazy(solution) - math::lazy(free_terms);
+	math::evaluate(std::span(mismatch), residual, settings.threads);
+}
+
+void Gauss::Output::solve_exact (const Input& in, const Settings& settings)
+{
+	using clock = std::chrono::steady_clock;
+	const auto start = clock::now();
+	auto result = math::exact_solve(in.view(), { .threads = settings.threads });
+	triangulation_time = clock::now() - start;
+	exact_stats = Exact_stats { .status = result.status, .primes = result.primes, .fractions = {} };
+	if (result.status != math::Exact_status::ok) {
+		singular = result.status == math::Exact_status::singular;
+		return;
+	}
+
+	// Numerators and denominators of thousands of digits are common: show the ends of those
+	constexpr size_t max_digits = 40, kept_digits = 12;
+	const auto shorten = [] (const math::Big_int& x) {
+		const std::string digits = x.to_string();
+		if (digits.size() <= max_digits)
+			return digits;
+		return fmt::format(FMT_STRING("{}…{} ({} цифр)"), digits.substr(0, kept_digits),
+				digits.substr(digits.size() - kept_digits), digits.size());
+	};
+	const auto shorten_fraction = [&] (const math::Fraction& f) {
+		if (f.denominator == 1)
+			return shorten(f.numerator);
+		return shorten(f.numerator) + "/" + shorten(f.denominator);
+	};
+	solution.resize(num_variables());
+	for (size_t i = 0; i < num_variables(); i++) {
+		solution[i] = math::to_double(result.solution[i]);
+		if (i < max_shown_values)
+			exact_stats->fractions.push_back(shorten_fraction(result.solution[i]));
+	}
+
+	// Of the solution rounded to doubles: the exact one has none
+	mismatch.resize(num_equations());
+	math::residual(std::span(mismatch), in.view(), std::span<const Number>(solution), settings.threads);
+}
+
+void Gauss::Output::solve_least_squares (const Input& in, const Settings& settings)
+{
+	solution.resize(num_variables());
+
+	using clock = std::chrono::steady_clock;
+	const auto start = clock::now();
+	least_squares = math::least_squares_solve(std::span(solution), in.view(), settings.threads);
+	triangulation_time = clock::now() - start;
+	singular = least_squares->rank_deficient;
+	if (singular)
+		return;
+
+	mismatch.resize(num_equations());
+	math::residual(std::span(mismatch), in.view(), std::span<const Number>(solution), settings.threads);
+}
+
+void Gauss::Output::solve_cholesky (const Input& in, const Settings& settings)
+{
+	const auto coefficients = in.view().subview(0, 0, num_equations(), num_variables());
+	using clock = std::chrono::steady_clock;
+	const auto start = clock::now();
+	const math::Cholesky_factorization<Number> factorization(coefficients,
+			math::default_cholesky_block_size, settings.threads);
+	cholesky = factorization.positive_definite();
+	if (!*cholesky)
+		return;
+
+	std::vector<Number> free_terms(num_equations());
+	for (size_t i = 0; i < num_equations(); i++)
+		free_terms[i] = in.view()[i][num_variables()];
+	solution.resize(num_variables());
+	factorization.solve(std::span(solution), std::span<const Number>(free_terms));
+	triangulation_time = clock::now() - start;
+	determinant = factorization.determinant();
+
+	mismatch.resize(num_equations());
+	const auto residual = math::lazy(coefficients) * math::lazy(solution) - math::lazy(free_terms);
+	math::evaluate(std::span(mismatch), residual, settings.threads);
+
+	// The largest eigenvalue takes few Lanczos steps, unless it is in a cluster. Lanczos only
+	// finds the smallest one relative to the largest, so it comes from inverse iteration with
+	// the factorization instead, which gets it right when the condition number is huge
+	const math::Eigen_settings eigen_settings { .max_iterations = 100, .threads = settings.threads };
+	const auto extremes = math::lanczos<Number>(coefficients, 1, eigen_settings);
+	if (!extremes.converged || extremes.largest.empty())
+		return;
+	std::vector<Number> eigenvector(num_variables());
+	const auto solve = [&] (std::span<Number> x, std::span<const Number> b) { factorization.solve(x, b); };
+	const auto smallest = math::smallest_eigenvalue<Number>(solve, std::span(eigenvector), eigen_settings);
+	if (smallest.converged && smallest.eigenvalue > 0)
+		condition_number = extremes.largest.back() / smallest.eigenvalue;
+}
+
+void Gauss::Output::solve_updating (const Input& in, const Settings& settings, const Output* previous)
+{
+	const auto coefficients = in.view().subview(0, 0, num_equations(), num_variables());
+	std::vector<Number> free_terms(num_equations());
+	for (size_t i = 0; i < num_equations(); i++)
+		free_terms[i] = in.view()[i][num_variables()];
+	const math::Lu_update_settings update_settings { .threads = settings.threads };
+
+	using clock = std::chrono::steady_clock;
+	const auto start = clock::now();
+	update_stats = Update_stats {};
+
+	std::vector<size_t> changed_rows;
+	if (previous && previous->updatable && previous->updatable->size() == num_variables()) {
+		for (size_t row = 0; row < num_equations(); row++) {
+			if (!std::ranges::equal(previous->updatable->matrix()[row], coefficients[row]))
+				changed_rows.push_back(row);
+		}
+		// Past this many changes, factoring anew is cheaper. Otherwise the updates go to a copy:
+		// the previous output keeps its factorization as it was
+		if (changed_rows.size() <= update_settings.max_updates)
+			updatable = std::make_shared<math::Updatable_lu<Number>>(*previous->updatable);
+	}
+
+	if (updatable) {
+		const size_t refactorizations = updatable->refactorizations();
+		for (size_t row: changed_rows) {
+			const auto old_row = updatable->matrix()[row];
+			const auto new_row = coefficients[row];
+			const size_t changed = std::ranges::mismatch(old_row, new_row).in1 - old_row.begin();
+			const bool one_element = std::equal(old_row.begin() + changed+1, old_row.end(),
+					new_row.begin() + changed+1);
+			if (one_element)
+				updatable->update_element(row, changed, new_row[changed]);
+			else
+				updatable->update_row(row, new_row);
+		}
+		update_stats->changed_rows = changed_rows.size();
+		update_stats->factored = updatable->refactorizations() != refactorizations;
+	} else {
+		updatable = std::make_shared<math::Updatable_lu<Number>>(coefficients, update_settings);
+		update_stats->factored = true;
+	}
+
+	singular = updatable->singular();
+	if (!singular) {
+		solution.resize(num_variables());
+		const size_t refactorizations = updatable->refactorizations();
+		updatable->solve(std::span(solution), std::span<const Number>(free_terms));
+		update_stats->factored |= updatable->refactorizations() != refactorizations;
+		singular = updatable->singular();
+	}
+	determinant = updatable->determinant();
+	triangulation_time = clock::now() - start;
+	if (singular) {
+		solution.clear();
+		return;
+	}
+
+	mismatch.resize(num_equations());
+	const auto residual = math::lazy(coefficients) * math::lazy(solution) - math::lazy(free_terms);
+	math::evaluate(std::span(mismatch), residual, settings.threads);
+}
+
+void Gauss::Output::solve_banded (const Input& in, math::Bandwidth band)
 {
-	bool triangulation_error = false;
+	const auto coefficients = in.view().subview(0, 0, num_equations(), num_variables());
+	std::vector<Number> free_terms(num_equations());
+	for (size_t i = 0; i < num_equations(); i++)
+		free_terms[i] = in.view()[i][num_variables()];
+	solution.resize(num_variables());
+
+	using clock = std::chrono::steady_clock;
+	const auto start = clock::now();
+	band_stats = Band_stats { .band = band, .thomas = false };
+
+	if (band.lower == 1 && band.upper == 1) {
+		const size_t n = num_variables();
+		std::vector<Number> lower(n-1), diag(n), upper(n-1);
+		bool dominant = true;
+		for (size_t i = 0; i < n; i++) {
+			diag[i] = coefficients[i][i];
+			if (i+1 < n) {
+				lower[i] = coefficients[i+1][i];
+				upper[i] = coefficients[i][i+1];
+			}
+			const Number left = i > 0 ? lower[i-1] : 0;
+			const Number right = i+1 < n ? upper[i] : 0;
+			dominant &= std::abs(diag[i]) >= std::abs(left) + std::abs(right);
+		}
+		// Without pivoting, the Thomas algorithm is only stable on diagonally dominant matrices
+		if (dominant && math::thomas_solve<Number>(std::span(solution), lower, diag, upper, free_terms)) {
+			triangulation_time = clock::now() - start;
+			band_stats->thomas = true;
+			determinant = math::tridiagonal_determinant<Number>(lower, diag, upper);
+		}
+	}
+
+	if (!band_stats->thomas) {
+		const math::Band_lu<Number> lu(math::Band_matrix<Number>(coefficients, band));
+		singular = lu.singular();
+		determinant = lu.determinant();
+		if (!singular)
+			lu.solve(std::span(solution), std::span<const Number>(free_terms));
+		triangulation_time = clock::now() - start;
+		if (singular)
+			return;
+	}
+
+	mismatch.resize(num_equations());
+	const auto residual = math::lazy(coefficients) * math::lazy(solution) - math::lazy(free_terms);
+	math::evaluate(std::span(mismatch), residual);
+}
+
+void Gauss::Output::solve_sparse (const Input& in)
+{
+	std::optional<math::Csr_matrix<Number>> converted;
+	if (in.stored_densely())
+		converted = math::Csr_matrix<Number>::from_dense(in.view());
+	const auto& augmented = converted ? *converted : in.sparse_matrix();
+
+	const auto coefficients = augmented.leading_columns(num_variables());
+	std::vector<Number> free_terms(num_equations());
+	augmented.column(std::span(free_terms), num_variables());
 
+	using clock = std::chrono::steady_clock;
+	const auto start = clock::now();
+	const math::Sparse_lu<Number> lu(coefficients);
+	triangulation_time = clock::now() - start;
+
+	std::vector<size_t> identity(num_variables());
+	for (size_t i = 0; i < num_variables(); i++)
+		identity[i] = i;
+	sparse_stats = Sparse_stats {
+		.nonzeros = coefficients.nonzeros(),
+		.factor_nonzeros = lu.factor_nonzeros(),
+		.bandwidth = math::bandwidth(coefficients, std::span<const size_t>(identity)),
+		.reordered_bandwidth = math::bandwidth(coefficients, lu.ordering()),
+	};
+
+	determinant = lu.determinant();
+	singular = lu.singular();
+	if (singular)
+		return;
+
+	solution.resize(num_variables());
+	lu.solve(std::span(solution), std::span<const Number>(free_terms));
+	mismatch.resize(num_equations());
+	math::mul_matrix_vector(std::span(mismatch), coefficients, std::span<const Number>(solution));
+	for (size_t i = 0; i < num_equations(); i++)
+		mismatch[i] -= free_terms[i];
+}
+
+void Gauss::Output::solve_iterative (const Input& in, const Settings& settings, const Output* previous)
+{
+	method = settings.method;
+	solution.assign(num_variables(), 0);
+	if (settings.warm_start && previous && previous->solution.size() == solution.size())
+		solution = previous->solution;
+
+	std::vector<Number> free_terms(num_equations());
+	const auto solve = [&] (const auto& coefficients) {
+		const auto x = std::span(solution);
+		const auto b = std::span<const Number>(free_terms);
+		switch (method) {
+		case Iterative_method::jacobi:
+			return math::jacobi(coefficients, x, b, settings.iterative);
+		case Iterative_method::gauss_seidel:
+			return math::gauss_seidel(coefficients, x, b, settings.iterative);
+		case Iterative_method::sor:
+			return math::sor(coefficients, x, b, settings.iterative);
+		case Iterative_method::conjugate_gradient:
+			return math::conjugate_gradient(coefficients, x, b, settings.iterative);
+		}
+		return math::Iterative_result{};
+	};
+
+	using clock = std::chrono::steady_clock;
+	const auto start = clock::now();
+	if (in.stored_densely()) {
+		for (size_t i = 0; i < num_equations(); i++)
+			free_terms[i] = in.view()[i][num_variables()];
+		const auto coefficients = in.view().subview(0, 0, num_equations(), num_variables());
+		iterative_result = solve(coefficients);
+		triangulation_time = clock::now() - start;
+		mismatch.resize(num_equations());
+		math::mul_matrix_vector(std::span(mismatch), coefficients, std::span<const Number>(solution),
+				settings.threads);
+	} else {
+		in.sparse_matrix().column(std::span(free_terms), num_variables());
+		const auto coefficients = in.sparse_matrix().leading_columns(num_variables());
+		iterative_result = solve(coefficients);
+		triangulation_time = clock::now() - start;
+		mismatch.resize(num_equations());
+		math::mul_matrix_vector(std::span(mismatch), coefficients, std::span<const Number>(solution));
+	}
+	for (size_t i = 0; i < num_equations(); i++)
+		mismatch[i] -= free_terms[i];
+}
+
+void Gauss::Output::residual_widget () const
+{
+	constexpr static const char* method_names[] = {
+		"Метод Якоби", "Метод Гаусса-Зейделя", "Метод верхней релаксации", "Метод сопряжённых градиентов",
+	};
+	TextFmtWrapped(FMT_STRING("{}: {} итераций, {}."), method_names[size_t(method)],
+			iterative_result->iterations(),
+			iterative_result->converged ? "заданная точность достигнута" : "заданная точность НЕ достигнута");
+
+	// The residual spans many orders of magnitude, so plot its logarithm
+	std::vector<float> log_residual;
+	log_residual.reserve(iterative_result->residual_history.size());
+	for (double r: iterative_result->residual_history)
+		log_residual.push_back(std::log10(std::max(r, std::numeric_limits<double>::min())));
+	PlotLines("lg невязки", log_residual.data(), log_residual.size(), 0, nullptr,
+			FLT_MAX, FLT_MAX, ImVec2(0, 0.25f * GetContentRegionAvail().y));
+}
+
+void Gauss::Output::matrix_widget () const
+{
 	SeparatorText("Треугольный вид матрицы:");
-	if (auto table = matrix_table("output", cols, 0.5)) {
-		auto mat = view();
+	const size_t cols = triangular->cols();
+	if (auto table = matrix_table("output", cols+1, 0.5)) {
+		auto mat = triangular->view();
+		const auto format = [] (Number value) { return fmt::format(FMT_STRING("{}"), value); };
+		TableSetupScrollFreeze(1, 1);
 
 		TableNextRow();
 		BeginDisabled();
-		for (unsigned col = 0; col < num_variables(); col++) {
-			TableNextColumn();
-			TextFmt("X{}", permute[col]+1);
+		TableNextColumn();
+		for (size_t col = 0; col < num_variables(); col++) {
+			if (TableNextColumn())
+				TextFmt("X{}", permute[col]+1);
 		}
 		EndDisabled();
 
-		for (unsigned row = 0; row < rows; row++) {
+		for_visible_rows(triangular->rows(), [&] (size_t row) {
 			TableNextRow();
-			const unsigned diag = std::min(cols, row);
+			const size_t diag = std::min(cols, row);
 
-			for (unsigned col = 0; col < diag; col++) {
-				TableNextColumn();
-				if (mat[row][col] != 0) {
-					TextFmtColored(gui::error_text_color, FMT_STRING("{}"), mat[row][col]);
-					triangulation_error = true;
+			TableNextColumn();
+			BeginDisabled();
+			TextFmt(FMT_STRING("({})"), permute_equations[row]+1);
+			EndDisabled();
+
+			for (size_t col = 0; col < diag; col++) {
+				if (TableNextColumn() && mat[row][col] != 0) {
+					const std::string& text = triangular_texts.get(row, col, mat[row][col], format);
+					TextColored(gui::error_text_color, "%s", text.c_str());
 				}
 			}
 
-			for (unsigned col = diag; col < cols; col++) {
-				TableNextColumn();
-				TextFmt(FMT_STRING("{}"), mat[row][col]);
+			for (size_t col = diag; col < cols; col++) {
+				if (TableNextColumn()) {
+					const std::string& text = triangular_texts.get(row, col, mat[row][col], format);
+					TextUnformatted(text.c_str(), text.c_str() + text.size());
+				}
 			}
-		}
+		});
 	}
 
 	if (triangulation_error)
 		TextColored(gui::error_text_color, "Ошибка при триангуляции. Матрица не треугольная.");
+}
 
-	Separator();
+void Gauss::Output::widget () const
+{
+	if (unsupported) {
+		ImScoped::TextWrapPos wrap_pos;
+		TextColored(gui::error_text_color, "Система слишком велика для плотного хранения, а разреженным "
+				"методом решаются только квадратные системы");
+		return;
+	}
 
-	if (num_equations() == num_variables())
-		TextFmt(FMT_STRING("Определитель подматрицы коэффициентов: {}"), determinant);
-	else
+	const double time_ms = std::chrono::duration<double, std::milli>(triangulation_time).count();
+	if (iterative_result) {
+		residual_widget();
+		Separator();
+		TextFmt(FMT_STRING("Время решения: {:.3f} мс"), time_ms);
+	} else if (band_stats) {
+		const auto [lower, upper] = band_stats->band;
+		TextFmtWrapped(FMT_STRING("Ленточная матрица: {} диагоналей под главной, {} над ней. {}."),
+				lower, upper, band_stats->thomas ? "Метод прогонки" : "Ленточное LU-разложение");
+		Separator();
+		TextFmt(FMT_STRING("Время решения: {:.3f} мс"), time_ms);
+	} else if (sparse_stats) {
+		TextFmtWrapped(FMT_STRING("Разреженное LU-разложение. Ненулевых коэффициентов: {}, "
+				"ненулевых элементов в L и U: {}. Ширина ленты: {}, после упорядочения "
+				"Катхилла-Макки: {}."), sparse_stats->nonzeros, sparse_stats->factor_nonzeros,
+				sparse_stats->bandwidth, sparse_stats->reordered_bandwidth);
+		Separator();
+		TextFmt(FMT_STRING("Время разложения: {:.3f} мс"), time_ms);
+	} else if (refinement) {
+		if (refinement->fell_back) {
+			TextFmtWrapped(FMT_STRING("Уточнение решения, найденного в одинарной точности, не сошлось "
+					"за {} шагов. Система решена LU-разложением в двойной точности."), refinement->steps);
+		} else {
+			TextFmtWrapped(FMT_STRING("LU-разложение в одинарной точности, {} шагов уточнения "
+					"в двойной."), refinement->steps);
+		}
+		Separator();
+		TextFmt(FMT_STRING("Время решения: {:.3f} мс ({})"), time_ms, math::kernel_instruction_set());
+	} else if (exact_stats) {
+		switch (exact_stats->status) {
+		case math::Exact_status::ok:
+			TextFmtWrapped(FMT_STRING("Точное решение, найденное по модулям {} простых чисел: {}{}"),
+					exact_stats->primes, fmt::join(exact_stats->fractions, ", "),
+					num_variables() > max_shown_values ? ", ..." : "");
+			break;
+		case math::Exact_status::singular:
+			break;
+		case math::Exact_status::not_finite:
+			TextColored(gui::error_text_color, "В системе есть бесконечности или NaN");
+			return;
+		}
+		Separator();
+		TextFmt(FMT_STRING("Время решения: {:.3f} мс ({})"), time_ms, math::kernel_instruction_set());
+	} else if (cholesky && *cholesky) {
+		TextWrapped("Матрица коэффициентов симметричная положительно определённая: "
+				"использовано разложение Холецкого.");
+		if (condition_number)
+			TextFmt(FMT_STRING("Число обусловленности: {:.3g}"), *condition_number);
+		Separator();
+		TextFmt(FMT_STRING("Время решения: {:.3f} мс ({})"), time_ms, math::kernel_instruction_set());
+	} else if (least_squares) {
+		if (least_squares->rank_deficient) {
+			TextWrapped("Столбцы матрицы коэффициентов линейно зависимы: решение по методу наименьших "
+					"квадратов не единственно.");
+		} else {
+			TextFmtWrapped(FMT_STRING("Решение по методу наименьших квадратов (QR-разложение Хаусхолдера). "
+					"Норма невязки: {:.7}"), least_squares->residual_norm);
+		}
+		Separator();
+		TextFmt(FMT_STRING("Время решения: {:.3f} мс ({})"), time_ms, math::kernel_instruction_set());
+	} else if (update_stats) {
+		if (update_stats->factored) {
+			TextWrapped("LU-разложение вычислено заново.");
+		} else {
+			TextFmtWrapped(FMT_STRING("LU-разложение обновлено по формуле Шермана-Моррисона: изменено "
+					"строк {}, поправок с последнего разложения {}."),
+					update_stats->changed_rows, updatable->num_updates());
+		}
+		Separator();
+		TextFmt(FMT_STRING("Время решения: {:.3f} мс ({})"), time_ms, math::kernel_instruction_set());
+	} else if (out_of_core_stats) {
+		switch (out_of_core_stats->status) {
+		case math::Out_of_core_status::ok:
+			TextFmtWrapped(FMT_STRING("Система решена эталонным алгоритмом вне оперативной памяти. "
+					"Треугольный вид матрицы записан в {}."), out_of_core_stats->work_file);
+			break;
+		case math::Out_of_core_status::unreadable:
+			TextColored(gui::error_text_color, "Не удалось прочитать файл матрицы");
+			return;
+		case math::Out_of_core_status::unwritable:
+			TextColored(gui::error_text_color, "Не удалось записать рабочий файл");
+			return;
+		case math::Out_of_core_status::too_little_memory:
+			TextColored(gui::error_text_color, "Ограничение памяти меньше одной строки матрицы");
+			return;
+		}
+		Separator();
+		TextFmt(FMT_STRING("Время решения: {:.3f} мс"), time_ms);
+	} else {
+		if (cholesky) {
+			TextWrapped("Симметричная матрица коэффициентов не положительно определена: "
+					"разложение Холецкого не удалось.");
+		}
+		if (triangular->small_enough_to_show()) {
+			matrix_widget();
+		} else {
+			TextFmtWrapped(FMT_STRING("Треугольный вид матрицы {}×{} слишком велик для показа."),
+					triangular->rows(), triangular->cols());
+		}
+		Separator();
+		TextFmt(FMT_STRING("Время триангуляции: {:.3f} мс ({})"), time_ms, math::kernel_instruction_set());
+	}
+
+	if (determinant)
+		TextFmt(FMT_STRING("Определитель подматрицы коэффициентов: {}"), *determinant);
+	else if (num_equations() != num_variables())
 		TextWrapped("Подматрица коэффициентов не квадратная. Определитель не имеет смысла.");
 
-	if (num_indeterminate_variables < 0) {
+	if (singular) {
+		TextUnformatted("Матрица коэффициентов вырождена.");
+	} else if (num_indeterminate_variables < 0) {
 		TextUnformatted("Система несовместна.");
 	} else if (num_indeterminate_variables > 0) {
 		TextFmtWrapped(
 				FMT_STRING("Бесконечное количество решений: как минимум {} независимых переменных."),
 				num_indeterminate_variables);
 	} else {
-		TextFmtWrapped(FMT_STRING("Решение: {:.5}"), fmt::join(solution_span(), ", "));
-		TextFmtWrapped(FMT_STRING("Невязка: {:.7}"), fmt::join(mismatch_span(), ", "));
+		// Long vectors are cut short; the mismatch is then summarized by its largest element
+		const auto shown = [] (const std::vector<Number>& v) {
+			return std::span(v).first(std::min(v.size(), max_shown_values));
+		};
+		const auto ellipsis = [] (const std::vector<Number>& v) {
+			return v.size() > max_shown_values ? ", ..." : "";
+		};
+		TextFmtWrapped(FMT_STRING("Решение: {:.5}{}"), fmt::join(shown(solution), ", "), ellipsis(solution));
+		TextFmtWrapped(FMT_STRING("Невязка: {:.7}{}"), fmt::join(shown(mismatch), ", "), ellipsis(mismatch));
+		if (mismatch.size() > max_shown_values) {
+			Number max_abs = 0;
+			for (Number value: mismatch)
+				max_abs = std::max(max_abs, std::abs(value));
+			TextFmt(FMT_STRING("Наибольшая по модулю невязка: {:.7}"), max_abs);
+		}
 	}
 }
 
+void Gauss::settings_widget ()
+{
+	struct Engine_spec {
+		const char* name;
+		Engine engine;
+	};
+	constexpr static Engine_spec engines[] = {
+		{ "Эталонный", Engine::reference },
+		{ "С выбором главного элемента", Engine::pivoting },
+		{ "Блочный", Engine::blocked },
+		{ "Разреженный", Engine::sparse },
+		{ "Смешанная точность", Engine::mixed },
+		{ "Точный", Engine::exact },
+		{ "Итерационный", Engine::iterative },
+	};
+	for (auto [name, e]: engines) {
+		if (RadioButton(name, settings.engine == e))
+			settings.engine = e;
+		SameLine();
+	}
+	TextUnformatted("алгоритм");
+
+	if (settings.engine == Engine::iterative) {
+		struct Method_spec {
+			const char* name;
+			Iterative_method method;
+		};
+		constexpr static Method_spec methods[] = {
+			{ "Якоби", Iterative_method::jacobi },
+			{ "Гаусса-Зейделя", Iterative_method::gauss_seidel },
+			{ "Верхней релаксации", Iterative_method::sor },
+			{ "Сопряжённых градиентов", Iterative_method::conjugate_gradient },
+		};
+		for (auto [name, m]: methods) {
+			if (RadioButton(name, settings.method == m))
+				settings.method = m;
+			SameLine();
+		}
+		NewLine();
+
+		auto& it = settings.iterative;
+		InputDouble("точность", &it.tolerance, 0, 0, "%.1e");
+		it.tolerance = std::max(it.tolerance, 0.0);
+		unsigned max_iterations = it.max_iterations;
+		Slider("итераций не более", &max_iterations, 1u, 100000u, nullptr,
+				ImGuiSliderFlags_AlwaysClamp | ImGuiSliderFlags_Logarithmic);
+		it.max_iterations = max_iterations;
+		if (settings.method == Iterative_method::sor)
+			Slider("параметр релаксации", &it.relaxation, 0.05, 1.95, nullptr, ImGuiSliderFlags_AlwaysClamp);
+		Checkbox("Начинать с предыдущего решения", &settings.warm_start);
+	}
+	if (settings.engine == Engine::pivoting || settings.engine == Engine::blocked) {
+		Checkbox("Обновлять LU-разложение после правки строк", &settings.update_factorization);
+		if (IsItemHovered()) {
+			auto tooltip = Tooltip();
+			TextUnformatted("Изменение одной строки пересчитывает решение за O(n²) вместо O(n³). "
+					"Треугольный вид матрицы при этом не показывается.");
+		}
+	}
+	Checkbox("Распознавать ленточные и разреженные системы", &settings.detect_structure);
+	Checkbox("Переопределённые системы решать методом наименьших квадратов", &settings.least_squares);
+
+	if (input.matrix_file()) {
+		Slider("МиБ памяти, дальше — решение вне памяти", &settings.memory_limit_mib, 16u, 65536u, nullptr,
+				ImGuiSliderFlags_AlwaysClamp | ImGuiSliderFlags_Logarithmic);
+	}
+
+	const unsigned max_threads = shared_thread_pool().size();
+	Slider("потоков", &settings.threads, 1u, max_threads, nullptr, ImGuiSliderFlags_AlwaysClamp);
+}
+
 void Gauss::gui_frame ()
 {
 	const auto viewport = ImGui::GetMainViewport();
@@ -229,8 +1116,9 @@ void Gauss::gui_frame ()
 	ImGui::SetNextWindowPos({ x + width / 2, y });
 	ImGui::SetNextWindowSize({ width / 2, height });
 	if (auto w = ImScoped::Window("Вывод", nullptr, static_window_flags)) {
+		settings_widget();
 		if (ImGui::Button("Вычислить"))
-			output.emplace(input);
+			output = Output(input, settings, output ? &*output : nullptr);
 		if (output) {
 			ImGui::SameLine();
 			if (ImGui::Button("Сбросить"))
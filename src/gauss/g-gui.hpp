@@ -1,70 +1,287 @@
 #pragma once
 
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <gauss/banded.hpp>
+#include <gauss/cholesky.hpp>
+#include <gauss/exact.hpp>
+#include <gauss/iterative.hpp>
+#include <gauss/lu-update.hpp>
+#include <gauss/matrix-file.hpp>
 #include <gauss/matrix.hpp>
+#include <gauss/out-of-core.hpp>
+#include <gauss/qr.hpp>
+#include <gauss/refinement.hpp>
+#include <gauss/sparse.hpp>
+#include <memory>
 #include <optional>
+#include <string>
 #include <task.hpp>
+#include <unordered_map>
+#include <vector>
 
 class Gauss: public Task {
 	using Number = double;
 
-	constexpr static unsigned max_rows = 20;
-	constexpr static unsigned max_cols = 20;
+	// Bigger matrices can only be loaded from a file
+	constexpr static unsigned max_edit_rows = 20;
+	constexpr static unsigned max_edit_cols = 20;
 
-	constexpr static unsigned max_variables = max_cols-1;
+	// Bigger matrices are summarized instead of being shown in full. Tables only lay out
+	// the cells in view, so the limits are ImGui's: 512 columns in a table, and float positions
+	constexpr static size_t max_shown_rows = 100000;
+	constexpr static size_t max_shown_cols = 500;
+	constexpr static size_t max_shown_values = 20; // of the solution and the mismatch
 
-	struct Sized_static_matrix {
-		math::Static_matrix<Number, max_rows, max_cols> matrix{};
-		unsigned rows;
-		unsigned cols;
+	// Square systems at least this big are checked for being banded: the band is at most
+	// this share of the width. Failing that, for being sparse: at most this share of
+	// the coefficients is nonzero
+	constexpr static size_t structured_min_variables = 100;
+	constexpr static double band_max_width = 0.1;
+	constexpr static double sparse_max_density = 0.05;
 
-		Sized_static_matrix (unsigned r, unsigned c): rows{r}, cols{c} {}
-		Sized_static_matrix (): Sized_static_matrix(0, 0) {}
+	// Which implementation of the first step of the Gauss method to use, or an iterative method.
+	// The sparse solver, the mixed-precision one (LU in float, refined in double), the exact one
+	// (in fractions, by modular arithmetic) and the iterative methods only handle square systems;
+	// others go to the blocked engine
+	enum class Engine { reference, pivoting, blocked, sparse, mixed, exact, iterative };
+	enum class Iterative_method { jacobi, gauss_seidel, sor, conjugate_gradient };
 
-		auto view () { return matrix.subview(0, 0, rows, cols); }
-		auto view () const { return matrix.subview(0, 0, rows, cols); }
+	struct Settings {
+		Engine engine = Engine::blocked;
+		// Use the banded or sparse solvers when they fit, whatever the engine,
+		// and the Cholesky factorization for symmetric positive definite systems
+		bool detect_structure = true;
+		// Solve systems with more equations than variables by least squares, whatever the engine,
+		// instead of finding them inconsistent unless the extra equations happen to agree
+		bool least_squares = true;
+		unsigned threads = 1; // not used by the reference and sparse engines
+		// For the pivoting and blocked engines: keep the LU factorization of a square system,
+		// and after edits to a few rows update it instead of solving anew
+		bool update_factorization = false;
 
-		unsigned num_equations () const { return rows; }
-		unsigned num_variables () const { return cols-1; }
+		// Dense systems in matrix files that need more memory than this are solved out of core,
+		// with the reference engine's results
+		unsigned memory_limit_mib = 1024;
+
+		Iterative_method method = Iterative_method::gauss_seidel;
+		math::Iterative_settings iterative;
+		bool warm_start = true; // start iterating from the previous solution
+	};
+	Settings settings;
+
+	// Formatted cells of a table, kept until their values change, so that a frame only formats
+	// the cells that have just scrolled into view
+	class Cell_texts {
+		struct Cell {
+			Number value;
+			std::string text;
+		};
+		std::unordered_map<std::uint64_t, Cell> cells;
+		// Far more than fit on the screen: past that, the ones out of view are not worth keeping
+		constexpr static size_t max_cells = size_t(1) << 16;
+
+	public:
+		// The text of the cell, made by `format(value)` if it wasn't made from this value.
+		// The reference is valid until the next call
+		template <typename F> const std::string& get (size_t row, size_t col, Number value, F&& format)
+		{
+			if (cells.size() >= max_cells)
+				cells.clear();
+			auto [it, inserted] = cells.try_emplace(std::uint64_t(row) << 32 | col);
+			Cell& cell = it->second;
+			// NaNs are never equal, and are just formatted again
+			if (inserted || cell.value != value || std::signbit(cell.value) != std::signbit(value)) {
+				cell.value = value;
+				cell.text = format(value);
+			}
+			return cell.text;
+		}
+	};
+
+	struct Sized_matrix {
+		math::Matrix<Number> matrix;
+
+		Sized_matrix (size_t r, size_t c): matrix(r, c, 0) {}
+
+		auto view () { return math::Matrix_view<Number>(matrix); }
+		auto view () const { return math::Matrix_view<const Number>(matrix); }
+
+		size_t rows () const { return matrix.rows(); }
+		size_t cols () const { return matrix.cols(); }
+		size_t num_equations () const { return rows(); }
+		size_t num_variables () const { return cols()-1; }
+
+		bool small_enough_to_show () const { return rows() <= max_shown_rows && cols() <= max_shown_cols; }
 	};
 
-	class Input: public Sized_static_matrix {
-		enum class File_load_status { ok, unreadable, bad_dimensions, bad_data };
+	class Input {
+		// The system is stored densely, unless it was loaded from a Matrix Market file
+		// too big for that. Then only the sparse solver can handle it.
+		// Matrix files too big to edit are used where they are mapped, instead of `dense`
+		Sized_matrix dense { 4, 4 };
+		std::optional<math::Csr_matrix<Number>> sparse;
+		std::optional<math::Mapped_matrix> mapped;
+		std::string mapped_path;
+
+		enum class File_load_status { ok, unreadable, unwritable, bad_dimensions, bad_data };
 		File_load_status load_from_file (const char*);
+		File_load_status load_matrix_market (std::istream&);
+		File_load_status load_matrix_file (const char*);
+		// Convert a text matrix into a matrix file next to it, then load that
+		File_load_status convert_to_matrix_file (const char*);
 		File_load_status last_file_load_status;
 
+		// Dense matrices are read in full into memory, so keep the size sane
+		constexpr static size_t max_file_elements = size_t(1) << 27;
+
 		constexpr static size_t path_buf_size = 256;
 		char path_buf[path_buf_size] = "matrix";
 
+		void resize (size_t rows, size_t cols);
+		void edit_widget ();
+		void equations_widget () const;
+		mutable Cell_texts equation_texts;
+
+		// Shown for systems too big to show in full, so counted once on loading. Those are
+		// too big to edit as well, so editing doesn't change them
+		size_t nonzero_elements = 0;
+		Number max_abs_element = 0;
+		void count_elements ();
+
 	public:
-		Input (): Sized_static_matrix(4, 4) {}
+		size_t rows () const { return sparse ? sparse->rows : view().rows(); }
+		size_t cols () const { return sparse ? sparse->cols : view().cols(); }
+		size_t num_equations () const { return rows(); }
+		size_t num_variables () const { return cols()-1; }
+
+		bool small_enough_to_show () const { return rows() <= max_shown_rows && cols() <= max_shown_cols; }
+
+		bool stored_densely () const { return !sparse; }
+		math::Matrix_view<const Number> view () const
+		{
+			assert(stored_densely());
+			return mapped ? mapped->view() : dense.view();
+		}
+		const auto& sparse_matrix () const { assert(!stored_densely()); return *sparse; }
+		// The matrix file the system is used from, if any
+		const char* matrix_file () const { return mapped ? mapped_path.c_str() : nullptr; }
+
+		// Whether the system is better solved by the sparse solver
+		bool is_sparse () const;
+
 		void widget ();
 	};
 
-	class Output: public Sized_static_matrix {
-		int num_indeterminate_variables;
+	class Output {
+		size_t equations, variables;
 
-		// Only calculated when the variable coefficient matrix is square
-		Number determinant;
+		int num_indeterminate_variables = 0;
+		bool singular = false; // found by the banded or sparse solvers, which can't tell the two cases apart
+		// The system is only stored sparsely and is not square: none of the solvers takes that
+		bool unsupported = false;
 
-		// Only calculated when the solution is unique
-		Number solution[max_variables]; // in correct order (permutation applied)
-		size_t permute[max_variables];  // for displaying columns in the pre-permutation order
-		Number mismatch[max_rows];
+		// Only calculated when the variable coefficient matrix is square, and not by iterative methods
+		std::optional<Number> determinant;
+
+		// Only produced by the dense engines
+		std::optional<Sized_matrix> triangular;
+		std::vector<size_t> permute;           // for displaying columns in the pre-permutation order
+		std::vector<size_t> permute_equations; // for displaying the original order of rows
 		unsigned permutations = 0;
+		bool triangulation_error = false;      // nonzeros were left below the main diagonal
+		mutable Cell_texts triangular_texts;
+
+		// Only produced by the banded solvers
+		struct Band_stats {
+			math::Bandwidth band;
+			bool thomas; // or banded LU
+		};
+		std::optional<Band_stats> band_stats;
+
+		// Only produced by the sparse solver
+		struct Sparse_stats {
+			size_t nonzeros, factor_nonzeros;
+			size_t bandwidth, reordered_bandwidth;
+		};
+		std::optional<Sparse_stats> sparse_stats;
+
+		// Only produced by the out-of-core solver
+		struct Out_of_core_stats {
+			math::Out_of_core_status status;
+			std::string work_file;
+		};
+		std::optional<Out_of_core_stats> out_of_core_stats;
+
+		// Set when the system looked symmetric positive definite: whether the Cholesky
+		// factorization succeeded, or the dense engine had to be used after all
+		std::optional<bool> cholesky;
+		// Of a matrix the Cholesky factorization succeeded on, from its extreme eigenvalues,
+		// if they converged
+		std::optional<Number> condition_number;
+
+		// Only produced by the least squares solver
+		std::optional<math::Least_squares_result> least_squares;
+
+		// Only produced by the mixed-precision solver
+		std::optional<math::Refinement_result> refinement;
 
-		auto solution_span () const { return std::span{ solution, size_t(num_variables()) }; }
-		auto permute_span () { return std::span{ permute, size_t(num_variables()) }; }
-		auto mismatch_span () const { return std::span{ mismatch, size_t(num_equations()) }; }
-		auto mismatch_span ()       { return std::span{ mismatch, size_t(num_equations()) }; }
+		// Only produced by the exact solver. The fractions are kept as text, shortened if long
+		struct Exact_stats {
+			math::Exact_status status;
+			size_t primes;
+			std::vector<std::string> fractions; // only the first max_shown_values
+		};
+		std::optional<Exact_stats> exact_stats;
+
+		// Only produced when updating the factorization. The next Output carries on with a copy,
+		// so this one stays as it was
+		std::shared_ptr<math::Updatable_lu<Number>> updatable;
+		struct Update_stats {
+			size_t changed_rows = 0;
+			bool factored = false; // from scratch, instead of being updated
+		};
+		std::optional<Update_stats> update_stats;
+
+		// Only produced by the iterative methods
+		Iterative_method method;
+		std::optional<math::Iterative_result> iterative_result;
+
+		// Only calculated when the solution is unique
+		std::vector<Number> solution; // in correct order (permutation applied)
+		std::vector<Number> mismatch; // of the original system, in the original order
+
+		std::chrono::nanoseconds triangulation_time;
+
+		size_t num_equations () const { return equations; }
+		size_t num_variables () const { return variables; }
+
+		void solve_dense (const Input&, const Settings&);
+		void solve_banded (const Input&, math::Bandwidth);
+		void solve_sparse (const Input&);
+		void solve_out_of_core (const Input&, const Settings&);
+		void solve_mixed (const Input&, const Settings&);
+		void solve_exact (const Input&, const Settings&);
+		void solve_least_squares (const Input&, const Settings&);
+		void solve_cholesky (const Input&, const Settings&);
+		void solve_updating (const Input&, const Settings&, const Output* previous);
+		void solve_iterative (const Input&, const Settings&, const Output* previous);
+		void residual_widget () const;
+		void matrix_widget () const;
 
 	public:
-		explicit Output (const Input& in);
+		// The solution in `previous` is the initial guess for iterative methods,
+		// and its factorization is updated when that is enabled
+		Output (const Input& in, const Settings&, const Output* previous = nullptr);
 		void widget () const;
 	};
 
 	Input input;
 	std::optional<Output> output;
 
+	void settings_widget ();
+
 public:
 	void gui_frame () override;
 	~Gauss () override = default;
@@ -0,0 +1,152 @@
+#include <array>
+#include <gauss/gemm.hpp>
+
+// The GotoBLAS scheme: op(B) is packed in panels of kc rows by nc columns, which stay in L3,
+// and op(A) in blocks of mc rows by kc columns, which stay in L2. The packed panels are laid
+// out in the order gemm_kernel() reads them, so it streams through them without strides
+
+namespace math {
+namespace {
+
+// In doubles, a sliver of B (kc by nr) takes 16 KiB with AVX2 and 32 KiB with AVX-512, within
+// a 48 KiB L1; a block of A takes 192 KiB of L2, and a panel of B 8 MiB of L3. Larger or smaller
+// blocks measured no faster with either kernel
+constexpr size_t block_k = 256;  // kc
+constexpr size_t block_m = 96;   // mc, a multiple of every kernel's mr
+constexpr size_t block_n = 4096; // nc, a multiple of every kernel's nr
+
+// Rows [row0, row0+rows) by columns [col0, col0+kc) of alpha*op(A), in slivers of `mr` rows
+// stored column by column. The last sliver is padded with zeros
+template <typename T> void pack_a (T* dest, Matrix_view<const T> a, Transpose ta, T alpha,
+		size_t row0, size_t rows, size_t col0, size_t kc, size_t mr)
+{
+	for (size_t ir = 0; ir < rows; ir += mr, dest += mr * kc) {
+		const size_t sliver_rows = std::min(mr, rows - ir);
+		if (ta == Transpose::no) {
+			for (size_t i = 0; i < sliver_rows; i++) {
+				const T* const src = a[row0 + ir + i].data() + col0;
+				for (size_t p = 0; p < kc; p++)
+					dest[p * mr + i] = alpha * src[p];
+			}
+		} else {
+			for (size_t p = 0; p < kc; p++) {
+				const T* const src = a[col0 + p].data() + row0 + ir;
+				for (size_t i = 0; i < sliver_rows; i++)
+					dest[p * mr + i] = alpha * src[i];
+			}
+		}
+		for (size_t p = 0; p < kc; p++)
+			std::fill(dest + p * mr + sliver_rows, dest + (p+1) * mr, T(0));
+	}
+}
+
+// Rows [row0, row0+kc) by columns [col0, col0+cols) of op(B), in slivers of `nr` columns
+// stored row by row. The last sliver is padded with zeros
+template <typename T> void pack_b (T* dest, Matrix_view<const T> b, Transpose tb,
+		size_t row0, size_t kc, size_t col0, size_t cols, size_t nr)
+{
+	for (size_t jr = 0; jr < cols; jr += nr, dest += nr * kc) {
+		const size_t sliver_cols = std::min(nr, cols - jr);
+		if (tb == Transpose::no) {
+			for (size_t p = 0; p < kc; p++) {
+				const T* const src = b[row0 + p].data() + col0 + jr;
+				std::copy_n(src, sliver_cols, dest + p * nr);
+				std::fill(dest + p * nr + sliver_cols, dest + (p+1) * nr, T(0));
+			}
+		} else {
+			for (size_t j = 0; j < nr; j++) {
+				if (j >= sliver_cols) {
+					for (size_t p = 0; p < kc; p++)
+						dest[p * nr + j] = 0;
+					continue;
+				}
+				const T* const src = b[col0 + jr + j].data() + row0;
+				for (size_t p = 0; p < kc; p++)
+					dest[p * nr + j] = src[p];
+			}
+		}
+	}
+}
+
+template <typename T> void gemm_blocked
+(Matrix_view<T> c, T alpha, Matrix_view<const T> a, Transpose ta,
+ Matrix_view<const T> b, Transpose tb, T beta, unsigned threads)
+{
+	const size_t m = c.rows(), n = c.cols(), k = detail::op_cols(a, ta);
+	assert(detail::op_rows(a, ta) == m && detail::op_cols(b, tb) == n);
+	assert(detail::op_rows(b, tb) == k);
+
+	for (auto row: c)
+		detail::scale(row, beta);
+	if (m == 0 || n == 0 || k == 0 || alpha == 0)
+		return;
+
+	const Gemm_kernel<T>& kernel = gemm_kernel<T>();
+	const size_t mr = kernel.mr, nr = kernel.nr;
+	assert(block_m % mr == 0 && block_n % nr == 0);
+
+	const size_t max_kc = std::min(k, block_k);
+	const size_t max_nc = std::min(block_n, (n + nr-1) / nr * nr);
+	Matrix<T> packed_b(1, max_kc * max_nc);
+
+	for (size_t jc = 0; jc < n; jc += block_n) {
+		const size_t nc = std::min(block_n, n - jc);
+		for (size_t pc = 0; pc < k; pc += block_k) {
+			const size_t kc = std::min(block_k, k - pc);
+			pack_b(packed_b[0].data(), b, tb, pc, kc, jc, nc, nr);
+
+			const size_t row_blocks = (m + block_m-1) / block_m;
+			const size_t min_blocks_per_thread = 1 + parallel_min_elements / (block_m * nc);
+			parallel_for(0, row_blocks, threads, min_blocks_per_thread, [&] (size_t begin, size_t end) {
+				Matrix<T> packed_a(1, block_m * kc);
+				// Edge tiles are computed here, then added to C
+				alignas(64) std::array<T, 12 * 32> tile;
+				assert(mr * nr <= tile.size());
+
+				for (size_t ib = begin; ib < end; ib++) {
+					const size_t ic = ib * block_m;
+					const size_t mc = std::min(block_m, m - ic);
+					pack_a(packed_a[0].data(), a, ta, alpha, ic, mc, pc, kc, mr);
+
+					for (size_t jr = 0; jr < nc; jr += nr) {
+						const T* const b_sliver = packed_b[0].data() + jr * kc;
+						const size_t tile_cols = std::min(nr, nc - jr);
+						for (size_t ir = 0; ir < mc; ir += mr) {
+							const T* const a_sliver = packed_a[0].data() + ir * kc;
+							const size_t tile_rows = std::min(mr, mc - ir);
+							T* const c_tile = c[ic + ir].data() + jc + jr;
+							if (tile_rows == mr && tile_cols == nr) {
+								kernel.fn(kc, a_sliver, b_sliver, c_tile, c.stride());
+								continue;
+							}
+							std::fill_n(tile.begin(), mr * nr, T(0));
+							kernel.fn(kc, a_sliver, b_sliver, tile.data(), nr);
+							for (size_t i = 0; i < tile_rows; i++) {
+								for (size_t j = 0; j < tile_cols; j++)
+									c_tile[i * c.stride() + j] += tile[i * nr + j];
+							}
+						}
+					}
+				}
+			});
+		}
+	}
+}
+
+} // namespace
+
+template <> void gemm<double>
+(Matrix_view<double> c, double alpha, Matrix_view<const double> a, Transpose ta,
+ Matrix_view<const double> b, Transpose tb, double beta, unsigned threads)
+{
+	gemm_blocked(c, alpha, a, ta, b, tb, beta, threads);
+}
+
+template <> void gemm<float>
+(Matrix_view<float> c, float alpha, Matrix_view<const float> a, Transpose ta,
+ Matrix_view<const float> b, Transpose tb, float beta, unsigned threads)
+{
+	gemm_blocked(c, alpha, a, ta, b, tb, beta, threads);
+}
+
+} // namespace math
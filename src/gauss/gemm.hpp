@@ -0,0 +1,108 @@
+#pragma once
+
+#include <gauss/kernels.hpp>
+#include <gauss/matrix.hpp>
+#include <gauss/solve.hpp>
+#include <optional>
+
+// Matrix products in the manner of BLAS:
+//   gemm(): C = alpha * op(A) * op(B) + beta * C
+//   gemv(): y = alpha * op(A) * x + beta * y
+// where op(A) is either A or its transpose. A transposed operand is read through its view with
+// the roles of rows and columns swapped, and never copied as a whole.
+// As in BLAS, C and y are not read when beta is 0, so they may hold garbage then.
+// The results do not depend on the number of threads
+
+namespace math {
+
+enum class Transpose : bool { no, yes };
+
+namespace detail {
+// The dimensions of op(A)
+template <typename E> size_t op_rows (Matrix_view<E> a, Transpose t)
+{
+	return t == Transpose::no ? a.rows() : a.cols();
+}
+template <typename E> size_t op_cols (Matrix_view<E> a, Transpose t)
+{
+	return t == Transpose::no ? a.cols() : a.rows();
+}
+
+template <typename T> void scale (std::span<T> v, T beta)
+{
+	if (beta == 0)
+		std::fill(v.begin(), v.end(), T(0));
+	else if (beta != 1)
+		for (T& value: v)
+			value *= beta;
+}
+} // namespace detail
+
+template <typename T> void gemv
+(std::span<T> y, std::type_identity_t<T> alpha, Matrix_view<const std::type_identity_t<T>> a, Transpose ta,
+ std::span<const std::type_identity_t<T>> x, std::type_identity_t<T> beta, unsigned threads = 1)
+{
+	assert(detail::op_rows(a, ta) == y.size() && detail::op_cols(a, ta) == x.size());
+	const size_t min_per_thread = 1 + parallel_min_elements / std::max<size_t>(x.size(), 1);
+
+	if (ta == Transpose::no) {
+		parallel_for(0, y.size(), threads, min_per_thread, [&] (size_t begin, size_t end) {
+			for (size_t i = begin; i < end; i++) {
+				const T sum = alpha * dot(a[i], x);
+				y[i] = beta == 0 ? sum : sum + beta * y[i];
+			}
+		});
+	} else {
+		// The rows of A are the columns of op(A): each thread adds up its part of all of them
+		parallel_for(0, y.size(), threads, min_per_thread, [&] (size_t begin, size_t end) {
+			const auto part = y.subspan(begin, end - begin);
+			detail::scale(part, beta);
+			for (size_t p = 0; p < x.size(); p++)
+				axpy(part, alpha * x[p], a[p].subspan(begin, end - begin));
+		});
+	}
+}
+
+// The generic version goes row by row of C; `double` and `float` have a cache-blocked one
+// in gemm.cpp, built on the register-blocked gemm_kernel()
+template <typename T> void gemm
+(Matrix_view<T> c, std::type_identity_t<T> alpha,
+ Matrix_view<const std::type_identity_t<T>> a, Transpose ta,
+ Matrix_view<const std::type_identity_t<T>> b, Transpose tb,
+ std::type_identity_t<T> beta, unsigned threads = 1)
+{
+	const size_t k = detail::op_cols(a, ta);
+	assert(detail::op_rows(a, ta) == c.rows() && detail::op_cols(b, tb) == c.cols());
+	assert(detail::op_rows(b, tb) == k);
+
+	// Rows of op(B) must be contiguous for axpy()
+	std::optional<Matrix<T>> b_transposed;
+	if (tb == Transpose::yes) {
+		b_transposed.emplace(k, c.cols());
+		for (size_t p = 0; p < k; p++) {
+			for (size_t j = 0; j < c.cols(); j++)
+				(*b_transposed)[p][j] = b[j][p];
+		}
+		b = *b_transposed;
+	}
+
+	const size_t min_rows_per_thread = 1 + parallel_min_elements / std::max<size_t>(k * c.cols(), 1);
+	parallel_for(0, c.rows(), threads, min_rows_per_thread, [&] (size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++) {
+			detail::scale(c[i], T(beta));
+			for (size_t p = 0; p < k; p++) {
+				const T a_ip = ta == Transpose::no ? a[i][p] : a[p][i];
+				axpy(c[i], alpha * a_ip, b[p]);
+			}
+		}
+	});
+}
+
+template <> void gemm<double>
+(Matrix_view<double> c, double alpha, Matrix_view<const double> a, Transpose ta,
+ Matrix_view<const double> b, Transpose tb, double beta, unsigned threads);
+template <> void gemm<float>
+(Matrix_view<float> c, float alpha, Matrix_view<const float> a, Transpose ta,
+ Matrix_view<const float> b, Transpose tb, float beta, unsigned threads);
+
+} // namespace math
@@ -0,0 +1,219 @@
+#pragma once
+
+#include <cmath>
+#include <gauss/kernels.hpp>
+#include <gauss/matrix.hpp>
+#include <gauss/sparse.hpp>
+#include <limits>
+#include <vector>
+
+// Iterative methods for square systems A*x = b. They work on dense (Matrix_view) and
+// sparse (Csr_matrix) matrices alike. `x` holds the initial guess on entry, so repeated
+// solves of a slightly changed system can start from the previous solution
+
+namespace math {
+
+struct Iterative_settings {
+	double tolerance = 1e-10; // on the relative residual, |b - A*x| / |b|
+	size_t max_iterations = 1000;
+	double relaxation = 1.5;  // for SOR, in (0, 2)
+};
+
+struct Iterative_result {
+	bool converged = false;
+	// The relative residual of the initial guess, then after every iteration
+	std::vector<double> residual_history;
+
+	size_t iterations () const { return residual_history.empty() ? 0 : residual_history.size()-1; }
+};
+
+namespace detail {
+
+// Call f(col, value) for the stored elements of a row
+template <typename E, typename F> void for_each_in_row (Matrix_view<E> mat, size_t row, F&& f)
+{
+	auto r = mat[row];
+	for (size_t col = 0; col < r.size(); col++)
+		f(col, r[col]);
+}
+template <typename T, typename F> void for_each_in_row (const Csr_matrix<T>& mat, size_t row, F&& f)
+{
+	const auto cs = mat.row_cols(row);
+	const auto vs = mat.row_values(row);
+	for (size_t i = 0; i < cs.size(); i++)
+		f(cs[i], vs[i]);
+}
+
+template <typename E> size_t matrix_size (Matrix_view<E> mat)
+{
+	assert(mat.rows() == mat.cols());
+	return mat.rows();
+}
+template <typename T> size_t matrix_size (const Csr_matrix<T>& mat)
+{
+	assert(mat.rows == mat.cols);
+	return mat.rows;
+}
+
+template <typename T> double norm (std::span<const T> v)
+{
+	return std::sqrt(double(dot(v, v)));
+}
+
+template <typename Mat, typename T> double relative_residual
+(const Mat& mat, std::span<const T> x, std::span<const T> b, double b_norm)
+{
+	const size_t n = matrix_size(mat);
+	double sum = 0;
+	for (size_t row = 0; row < n; row++) {
+		T r = b[row];
+		for_each_in_row(mat, row, [&] (size_t col, T value) { r -= value * x[col]; });
+		sum += double(r) * double(r);
+	}
+	return std::sqrt(sum) / b_norm;
+}
+
+// Stationary methods differ in the sweep only, which updates `x` in place.
+// It returns false on a zero diagonal element
+template <typename Mat, typename T, typename Sweep> Iterative_result stationary_iteration
+(const Mat& mat, std::span<T> x, std::span<const T> b, const Iterative_settings& settings,
+ Sweep&& sweep)
+{
+	assert(x.size() == matrix_size(mat) && b.size() == x.size());
+
+	Iterative_result result;
+	const double b_norm = std::max(norm(b), std::numeric_limits<double>::min());
+	result.residual_history.push_back(relative_residual(mat, std::span<const T>(x), b, b_norm));
+
+	for (size_t it = 0; it < settings.max_iterations; it++) {
+		if (result.residual_history.back() <= settings.tolerance || !sweep())
+			break;
+		const double residual = relative_residual(mat, std::span<const T>(x), b, b_norm);
+		result.residual_history.push_back(residual);
+		if (!std::isfinite(residual))
+			break; // diverged
+	}
+	result.converged = result.residual_history.back() <= settings.tolerance;
+	return result;
+}
+
+// One Gauss-Seidel sweep, over-relaxed by `relaxation`. Returns false on a zero diagonal element
+template <typename Mat, typename T> bool sor_sweep
+(const Mat& mat, std::span<T> x, std::span<const T> b, T relaxation)
+{
+	for (size_t row = 0; row < x.size(); row++) {
+		T sum = b[row], diag = 0;
+		for_each_in_row(mat, row, [&] (size_t col, T value) {
+			if (col == row)
+				diag = value;
+			else
+				sum -= value * x[col];
+		});
+		if (diag == 0)
+			return false;
+		x[row] += relaxation * (sum / diag - x[row]);
+	}
+	return true;
+}
+
+} // namespace detail
+
+// Converges for strictly diagonally dominant matrices
+template <typename Mat, typename T> Iterative_result jacobi
+(const Mat& mat, std::span<T> x, std::span<const std::type_identity_t<T>> b,
+ const Iterative_settings& settings)
+{
+	std::vector<T> next(x.size());
+	return detail::stationary_iteration(mat, x, b, settings, [&] {
+		for (size_t row = 0; row < x.size(); row++) {
+			T sum = b[row], diag = 0;
+			detail::for_each_in_row(mat, row, [&] (size_t col, T value) {
+				if (col == row)
+					diag = value;
+				else
+					sum -= value * x[col];
+			});
+			if (diag == 0)
+				return false;
+			next[row] = sum / diag;
+		}
+		std::copy(next.begin(), next.end(), x.begin());
+		return true;
+	});
+}
+
+// Converges for strictly diagonally dominant and for symmetric positive definite matrices
+template <typename Mat, typename T> Iterative_result gauss_seidel
+(const Mat& mat, std::span<T> x, std::span<const std::type_identity_t<T>> b,
+ const Iterative_settings& settings)
+{
+	return detail::stationary_iteration(mat, x, b, settings, [&] {
+		return detail::sor_sweep(mat, x, b, T(1));
+	});
+}
+
+// Successive over-relaxation: Gauss-Seidel with the step scaled by `settings.relaxation`
+template <typename Mat, typename T> Iterative_result sor
+(const Mat& mat, std::span<T> x, std::span<const std::type_identity_t<T>> b,
+ const Iterative_settings& settings)
+{
+	assert(settings.relaxation > 0 && settings.relaxation < 2);
+	return detail::stationary_iteration(mat, x, b, settings, [&] {
+		return detail::sor_sweep(mat, x, b, T(settings.relaxation));
+	});
+}
+
+// Conjugate gradients, for symmetric positive definite matrices only.
+// Stops early, unconverged, if the matrix turns out not to be positive definite
+template <typename Mat, typename T> Iterative_result conjugate_gradient
+(const Mat& mat, std::span<T> x, std::span<const std::type_identity_t<T>> b,
+ const Iterative_settings& settings)
+{
+	const size_t n = detail::matrix_size(mat);
+	assert(x.size() == n && b.size() == n);
+
+	const auto multiply = [&] (std::span<T> dest, std::span<const T> vec) {
+		for (size_t row = 0; row < n; row++) {
+			T sum = 0;
+			detail::for_each_in_row(mat, row, [&] (size_t col, T value) { sum += value * vec[col]; });
+			dest[row] = sum;
+		}
+	};
+
+	std::vector<T> residual(n), direction(n), product(n);
+	multiply(residual, std::span<const T>(x));
+	for (size_t i = 0; i < n; i++)
+		residual[i] = b[i] - residual[i];
+	direction = residual;
+
+	Iterative_result result;
+	const double b_norm = std::max(detail::norm(b), std::numeric_limits<double>::min());
+	T residual_square = dot(std::span<const T>(residual), residual);
+	result.residual_history.push_back(std::sqrt(double(residual_square)) / b_norm);
+
+	for (size_t it = 0; it < settings.max_iterations; it++) {
+		if (result.residual_history.back() <= settings.tolerance)
+			break;
+
+		multiply(product, std::span<const T>(direction));
+		const T curvature = dot(std::span<const T>(direction), product);
+		if (!(curvature > 0))
+			break;
+
+		const T step = residual_square / curvature;
+		axpy(x, step, direction);
+		axpy(std::span(residual), -step, product);
+
+		const T next_residual_square = dot(std::span<const T>(residual), residual);
+		const T beta = next_residual_square / residual_square;
+		residual_square = next_residual_square;
+		for (size_t i = 0; i < n; i++)
+			direction[i] = residual[i] + beta * direction[i];
+
+		result.residual_history.push_back(std::sqrt(double(residual_square)) / b_norm);
+	}
+	result.converged = result.residual_history.back() <= settings.tolerance;
+	return result;
+}
+
+} // namespace math
@@ -0,0 +1,643 @@
+#include <algorithm>
+#include <cstdint>
+#include <gauss/kernels.hpp>
+#include <gauss/modular.hpp>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define KERNELS_X86 1
+#include <immintrin.h>
+#else
+#define KERNELS_X86 0
+#endif
+
+namespace math {
+namespace {
+
+template <typename T> using Axpy_fn = void (*) (T*, T, const T*, size_t);
+template <typename T> using Dot_fn = T (*) (const T*, const T*, size_t);
+using Axpy_mod_fn = void (*) (std::uint32_t*, std::uint32_t, const std::uint32_t*, size_t, std::uint32_t);
+template <typename T> using Eliminate_fn = void (*) (T*, const T*, const T*, size_t, size_t, size_t);
+
+template <typename T> void axpy_scalar (T* y, T a, const T* x, size_t n)
+{
+	for (size_t i = 0; i < n; i++)
+		y[i] += a * x[i];
+}
+
+template <typename T> T dot_scalar (const T* x, const T* y, size_t n)
+{
+	T result = 0;
+	for (size_t i = 0; i < n; i++)
+		result += x[i] * y[i];
+	return result;
+}
+
+// y = (y + a*x) mod p, for residues modulo p < 2^31. a*x mod p is found without dividing by
+// Shoup's method: with a' = floor(a * 2^32 / p), q = floor(a' * x / 2^32) is the quotient
+// or one less, so a*x - q*p, computed modulo 2^32, is in [0, 2p).
+// min(r, r - p) is r - p if that doesn't wrap around, which is how the results are reduced
+std::uint32_t shoup_multiplier (std::uint32_t a, std::uint32_t p)
+{
+	return std::uint32_t((std::uint64_t(a) << 32) / p);
+}
+
+void axpy_mod_scalar (std::uint32_t* y, std::uint32_t a, const std::uint32_t* x, size_t n, std::uint32_t p)
+{
+	const std::uint32_t a_shoup = shoup_multiplier(a, p);
+	for (size_t i = 0; i < n; i++) {
+		const auto q = std::uint32_t((std::uint64_t(a_shoup) * x[i]) >> 32);
+		std::uint32_t r = a * x[i] - q * p;
+		r = std::min(r, r - p);
+		const std::uint32_t sum = y[i] + r;
+		y[i] = std::min(sum, sum - p);
+	}
+}
+
+// The same loops as gemm_avx2(), left to the compiler to vectorize
+template <size_t Mr, size_t Nr, typename T>
+void gemm_scalar (size_t k, const T* a, const T* b, T* c, size_t c_stride)
+{
+	T acc[Mr][Nr] = {};
+	for (size_t p = 0; p < k; p++, a += Mr, b += Nr) {
+		for (size_t i = 0; i < Mr; i++) {
+			for (size_t j = 0; j < Nr; j++)
+				acc[i][j] += a[i] * b[j];
+		}
+	}
+	for (size_t i = 0; i < Mr; i++) {
+		for (size_t j = 0; j < Nr; j++)
+			c[i * c_stride + j] += acc[i][j];
+	}
+}
+
+// See eliminate_batch(). Elements `col` of the rows are `stride` apart, and there are
+// `count` systems. Column by column, so that the compiler vectorizes it across systems
+template <typename T>
+void eliminate_scalar (T* row, const T* main_row, const T* inverse, size_t width, size_t count, size_t stride)
+{
+	for (size_t col = 1; col < width; col++) {
+		T* const target = row + col * stride;
+		const T* const main = main_row + col * stride;
+		for (size_t s = 0; s < count; s++)
+			target[s] -= (row[s] * inverse[s]) * main[s];
+	}
+	std::fill_n(row, count, T(0));
+}
+
+#if KERNELS_X86
+// How many leading elements to process separately so that `p + result` is aligned
+template <size_t Alignment, typename T> size_t misaligned_head (const T* p, size_t n)
+{
+	const auto addr = reinterpret_cast<std::uintptr_t>(p);
+	const size_t head = ((Alignment - addr % Alignment) % Alignment) / sizeof(T);
+	return std::min(head, n);
+}
+
+// ----------------------------------------- AVX2 -----------------------------------------
+
+[[gnu::target("avx2,fma")]] void axpy_avx2 (double* y, double a, const double* x, size_t n)
+{
+	// `y` is both read and written, so that is the one to align
+	const size_t head = misaligned_head<32>(y, n);
+	axpy_scalar(y, a, x, head);
+
+	const __m256d va = _mm256_set1_pd(a);
+	size_t i = head;
+	for (; i + 8 <= n; i += 8) {
+		__m256d y0 = _mm256_load_pd(y + i);
+		__m256d y1 = _mm256_load_pd(y + i + 4);
+		y0 = _mm256_fmadd_pd(va, _mm256_loadu_pd(x + i), y0);
+		y1 = _mm256_fmadd_pd(va, _mm256_loadu_pd(x + i + 4), y1);
+		_mm256_store_pd(y + i, y0);
+		_mm256_store_pd(y + i + 4, y1);
+	}
+	for (; i + 4 <= n; i += 4)
+		_mm256_store_pd(y + i, _mm256_fmadd_pd(va, _mm256_loadu_pd(x + i), _mm256_load_pd(y + i)));
+
+	axpy_scalar(y + i, a, x + i, n - i);
+}
+
+[[gnu::target("avx2,fma")]] double dot_avx2 (const double* x, const double* y, size_t n)
+{
+	__m256d acc0 = _mm256_setzero_pd();
+	__m256d acc1 = _mm256_setzero_pd();
+	size_t i = 0;
+	for (; i + 8 <= n; i += 8) {
+		acc0 = _mm256_fmadd_pd(_mm256_loadu_pd(x + i), _mm256_loadu_pd(y + i), acc0);
+		acc1 = _mm256_fmadd_pd(_mm256_loadu_pd(x + i + 4), _mm256_loadu_pd(y + i + 4), acc1);
+	}
+	for (; i + 4 <= n; i += 4)
+		acc0 = _mm256_fmadd_pd(_mm256_loadu_pd(x + i), _mm256_loadu_pd(y + i), acc0);
+
+	const __m256d acc = _mm256_add_pd(acc0, acc1);
+	const __m128d half = _mm_add_pd(_mm256_castpd256_pd128(acc), _mm256_extractf128_pd(acc, 1));
+	const double sum = _mm_cvtsd_f64(_mm_add_sd(half, _mm_unpackhi_pd(half, half)));
+	return sum + dot_scalar(x + i, y + i, n - i);
+}
+
+// 6 rows by 8 columns of C: 12 accumulators, plus 2 registers for B and 1 for A
+[[gnu::target("avx2,fma")]]
+void gemm_avx2 (size_t k, const double* a, const double* b, double* c, size_t c_stride)
+{
+	constexpr size_t mr = 6;
+	// C is only touched at the end: start bringing its rows into cache now
+	for (size_t i = 0; i < mr; i++) {
+		_mm_prefetch(reinterpret_cast<const char*>(c + i * c_stride), _MM_HINT_T0);
+		_mm_prefetch(reinterpret_cast<const char*>(c + i * c_stride + 7), _MM_HINT_T0);
+	}
+	__m256d acc[mr][2];
+	#pragma GCC unroll 6
+	for (size_t i = 0; i < mr; i++)
+		acc[i][0] = acc[i][1] = _mm256_setzero_pd();
+
+	for (size_t p = 0; p < k; p++, a += mr, b += 8) {
+		const __m256d b0 = _mm256_load_pd(b);
+		const __m256d b1 = _mm256_load_pd(b + 4);
+		#pragma GCC unroll 6
+		for (size_t i = 0; i < mr; i++) {
+			const __m256d ai = _mm256_broadcast_sd(a + i);
+			acc[i][0] = _mm256_fmadd_pd(ai, b0, acc[i][0]);
+			acc[i][1] = _mm256_fmadd_pd(ai, b1, acc[i][1]);
+		}
+	}
+
+	#pragma GCC unroll 6
+	for (size_t i = 0; i < mr; i++) {
+		double* const row = c + i * c_stride;
+		_mm256_storeu_pd(row, _mm256_add_pd(_mm256_loadu_pd(row), acc[i][0]));
+		_mm256_storeu_pd(row + 4, _mm256_add_pd(_mm256_loadu_pd(row + 4), acc[i][1]));
+	}
+}
+
+// The same for `float`, with twice the elements per vector
+
+[[gnu::target("avx2,fma")]] void axpy_avx2 (float* y, float a, const float* x, size_t n)
+{
+	const size_t head = misaligned_head<32>(y, n);
+	axpy_scalar(y, a, x, head);
+
+	const __m256 va = _mm256_set1_ps(a);
+	size_t i = head;
+	for (; i + 16 <= n; i += 16) {
+		__m256 y0 = _mm256_load_ps(y + i);
+		__m256 y1 = _mm256_load_ps(y + i + 8);
+		y0 = _mm256_fmadd_ps(va, _mm256_loadu_ps(x + i), y0);
+		y1 = _mm256_fmadd_ps(va, _mm256_loadu_ps(x + i + 8), y1);
+		_mm256_store_ps(y + i, y0);
+		_mm256_store_ps(y + i + 8, y1);
+	}
+	for (; i + 8 <= n; i += 8)
+		_mm256_store_ps(y + i, _mm256_fmadd_ps(va, _mm256_loadu_ps(x + i), _mm256_load_ps(y + i)));
+
+	axpy_scalar(y + i, a, x + i, n - i);
+}
+
+[[gnu::target("avx2,fma")]] float dot_avx2 (const float* x, const float* y, size_t n)
+{
+	__m256 acc0 = _mm256_setzero_ps();
+	__m256 acc1 = _mm256_setzero_ps();
+	size_t i = 0;
+	for (; i + 16 <= n; i += 16) {
+		acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(x + i), _mm256_loadu_ps(y + i), acc0);
+		acc1 = _mm256_fmadd_ps(_mm256_loadu_ps(x + i + 8), _mm256_loadu_ps(y + i + 8), acc1);
+	}
+	for (; i + 8 <= n; i += 8)
+		acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(x + i), _mm256_loadu_ps(y + i), acc0);
+
+	alignas(32) float lanes[8];
+	_mm256_store_ps(lanes, _mm256_add_ps(acc0, acc1));
+	float sum = 0;
+	for (float lane: lanes)
+		sum += lane;
+	return sum + dot_scalar(x + i, y + i, n - i);
+}
+
+// 6 rows by 16 columns
+[[gnu::target("avx2,fma")]]
+void gemm_avx2 (size_t k, const float* a, const float* b, float* c, size_t c_stride)
+{
+	constexpr size_t mr = 6;
+	for (size_t i = 0; i < mr; i++) {
+		_mm_prefetch(reinterpret_cast<const char*>(c + i * c_stride), _MM_HINT_T0);
+		_mm_prefetch(reinterpret_cast<const char*>(c + i * c_stride + 15), _MM_HINT_T0);
+	}
+	__m256 acc[mr][2];
+	#pragma GCC unroll 6
+	for (size_t i = 0; i < mr; i++)
+		acc[i][0] = acc[i][1] = _mm256_setzero_ps();
+
+	for (size_t p = 0; p < k; p++, a += mr, b += 16) {
+		const __m256 b0 = _mm256_load_ps(b);
+		const __m256 b1 = _mm256_load_ps(b + 8);
+		#pragma GCC unroll 6
+		for (size_t i = 0; i < mr; i++) {
+			const __m256 ai = _mm256_broadcast_ss(a + i);
+			acc[i][0] = _mm256_fmadd_ps(ai, b0, acc[i][0]);
+			acc[i][1] = _mm256_fmadd_ps(ai, b1, acc[i][1]);
+		}
+	}
+
+	#pragma GCC unroll 6
+	for (size_t i = 0; i < mr; i++) {
+		float* const row = c + i * c_stride;
+		_mm256_storeu_ps(row, _mm256_add_ps(_mm256_loadu_ps(row), acc[i][0]));
+		_mm256_storeu_ps(row + 8, _mm256_add_ps(_mm256_loadu_ps(row + 8), acc[i][1]));
+	}
+}
+
+// 4 systems at a time, a column after another, so the factor of each system stays in a register
+[[gnu::target("avx2,fma")]] void eliminate_avx2
+(double* row, const double* main_row, const double* inverse, size_t width, size_t count, size_t stride)
+{
+	size_t s = 0;
+	for (; s + 4 <= count; s += 4) {
+		const __m256d factor = _mm256_mul_pd(_mm256_loadu_pd(row + s), _mm256_loadu_pd(inverse + s));
+		for (size_t col = 1; col < width; col++) {
+			double* const target = row + col * stride + s;
+			const __m256d main = _mm256_loadu_pd(main_row + col * stride + s);
+			_mm256_storeu_pd(target, _mm256_fnmadd_pd(factor, main, _mm256_loadu_pd(target)));
+		}
+		_mm256_storeu_pd(row + s, _mm256_setzero_pd());
+	}
+	eliminate_scalar(row + s, main_row + s, inverse + s, width, count - s, stride);
+}
+
+[[gnu::target("avx2,fma")]] void eliminate_avx2
+(float* row, const float* main_row, const float* inverse, size_t width, size_t count, size_t stride)
+{
+	size_t s = 0;
+	for (; s + 8 <= count; s += 8) {
+		const __m256 factor = _mm256_mul_ps(_mm256_loadu_ps(row + s), _mm256_loadu_ps(inverse + s));
+		for (size_t col = 1; col < width; col++) {
+			float* const target = row + col * stride + s;
+			const __m256 main = _mm256_loadu_ps(main_row + col * stride + s);
+			_mm256_storeu_ps(target, _mm256_fnmadd_ps(factor, main, _mm256_loadu_ps(target)));
+		}
+		_mm256_storeu_ps(row + s, _mm256_setzero_ps());
+	}
+	eliminate_scalar(row + s, main_row + s, inverse + s, width, count - s, stride);
+}
+
+[[gnu::target("avx2")]]
+void axpy_mod_avx2 (std::uint32_t* y, std::uint32_t a, const std::uint32_t* x, size_t n, std::uint32_t p)
+{
+	const __m256i va = _mm256_set1_epi32(int(a));
+	const __m256i va_shoup = _mm256_set1_epi32(int(shoup_multiplier(a, p)));
+	const __m256i vp = _mm256_set1_epi32(int(p));
+	size_t i = 0;
+	for (; i + 8 <= n; i += 8) {
+		const __m256i vx = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(x + i));
+		// The high halves of a' * x, from the products of the even lanes and of the odd ones
+		const __m256i even = _mm256_srli_epi64(_mm256_mul_epu32(vx, va_shoup), 32);
+		const __m256i odd = _mm256_mul_epu32(_mm256_srli_epi64(vx, 32), va_shoup);
+		const __m256i q = _mm256_blend_epi32(even, odd, 0b10101010);
+		__m256i r = _mm256_sub_epi32(_mm256_mullo_epi32(vx, va), _mm256_mullo_epi32(q, vp));
+		r = _mm256_min_epu32(r, _mm256_sub_epi32(r, vp));
+		__m256i sum = _mm256_add_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(y + i)), r);
+		sum = _mm256_min_epu32(sum, _mm256_sub_epi32(sum, vp));
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(y + i), sum);
+	}
+	axpy_mod_scalar(y + i, a, x + i, n - i, p);
+}
+
+// ---------------------------------------- AVX-512 ----------------------------------------
+
+// Fewer than 8 elements, done with masked operations instead of a scalar loop
+[[gnu::target("avx512f")]] void axpy_avx512_masked (double* y, double a, const double* x, size_t n)
+{
+	const __mmask8 mask = (1u << n) - 1;
+	const __m512d vy = _mm512_maskz_loadu_pd(mask, y);
+	const __m512d vx = _mm512_maskz_loadu_pd(mask, x);
+	_mm512_mask_storeu_pd(y, mask, _mm512_fmadd_pd(_mm512_set1_pd(a), vx, vy));
+}
+
+[[gnu::target("avx512f")]] void axpy_avx512 (double* y, double a, const double* x, size_t n)
+{
+	const __m512d va = _mm512_set1_pd(a);
+
+	const size_t head = misaligned_head<64>(y, n);
+	if (head > 0)
+		axpy_avx512_masked(y, a, x, head);
+
+	size_t i = head;
+	for (; i + 16 <= n; i += 16) {
+		__m512d y0 = _mm512_load_pd(y + i);
+		__m512d y1 = _mm512_load_pd(y + i + 8);
+		y0 = _mm512_fmadd_pd(va, _mm512_loadu_pd(x + i), y0);
+		y1 = _mm512_fmadd_pd(va, _mm512_loadu_pd(x + i + 8), y1);
+		_mm512_store_pd(y + i, y0);
+		_mm512_store_pd(y + i + 8, y1);
+	}
+	for (; i + 8 <= n; i += 8)
+		_mm512_store_pd(y + i, _mm512_fmadd_pd(va, _mm512_loadu_pd(x + i), _mm512_load_pd(y + i)));
+
+	if (i < n)
+		axpy_avx512_masked(y + i, a, x + i, n - i);
+}
+
+[[gnu::target("avx512f")]] double dot_avx512 (const double* x, const double* y, size_t n)
+{
+	__m512d acc0 = _mm512_setzero_pd();
+	__m512d acc1 = _mm512_setzero_pd();
+	size_t i = 0;
+	for (; i + 16 <= n; i += 16) {
+		acc0 = _mm512_fmadd_pd(_mm512_loadu_pd(x + i), _mm512_loadu_pd(y + i), acc0);
+		acc1 = _mm512_fmadd_pd(_mm512_loadu_pd(x + i + 8), _mm512_loadu_pd(y + i + 8), acc1);
+	}
+	if (i < n) {
+		const size_t count = std::min<size_t>(n - i, 8);
+		const __mmask8 mask = (1u << count) - 1;
+		acc0 = _mm512_fmadd_pd(_mm512_maskz_loadu_pd(mask, x + i), _mm512_maskz_loadu_pd(mask, y + i), acc0);
+		i += count;
+	}
+	if (i < n) {
+		const __mmask8 mask = (1u << (n - i)) - 1;
+		acc1 = _mm512_fmadd_pd(_mm512_maskz_loadu_pd(mask, x + i), _mm512_maskz_loadu_pd(mask, y + i), acc1);
+	}
+	alignas(64) double lanes[8];
+	_mm512_store_pd(lanes, _mm512_add_pd(acc0, acc1));
+	double sum = 0;
+	for (double lane: lanes)
+		sum += lane;
+	return sum;
+}
+[[gnu::target("avx512f")]] void axpy_avx512_masked (float* y, float a, const float* x, size_t n)
+{
+	const __mmask16 mask = (1u << n) - 1;
+	const __m512 vy = _mm512_maskz_loadu_ps(mask, y);
+	const __m512 vx = _mm512_maskz_loadu_ps(mask, x);
+	_mm512_mask_storeu_ps(y, mask, _mm512_fmadd_ps(_mm512_set1_ps(a), vx, vy));
+}
+
+[[gnu::target("avx512f")]] void axpy_avx512 (float* y, float a, const float* x, size_t n)
+{
+	const __m512 va = _mm512_set1_ps(a);
+
+	const size_t head = misaligned_head<64>(y, n);
+	if (head > 0)
+		axpy_avx512_masked(y, a, x, head);
+
+	size_t i = head;
+	for (; i + 32 <= n; i += 32) {
+		__m512 y0 = _mm512_load_ps(y + i);
+		__m512 y1 = _mm512_load_ps(y + i + 16);
+		y0 = _mm512_fmadd_ps(va, _mm512_loadu_ps(x + i), y0);
+		y1 = _mm512_fmadd_ps(va, _mm512_loadu_ps(x + i + 16), y1);
+		_mm512_store_ps(y + i, y0);
+		_mm512_store_ps(y + i + 16, y1);
+	}
+	for (; i + 16 <= n; i += 16)
+		_mm512_store_ps(y + i, _mm512_fmadd_ps(va, _mm512_loadu_ps(x + i), _mm512_load_ps(y + i)));
+
+	if (i < n)
+		axpy_avx512_masked(y + i, a, x + i, n - i);
+}
+
+[[gnu::target("avx512f")]] float dot_avx512 (const float* x, const float* y, size_t n)
+{
+	__m512 acc0 = _mm512_setzero_ps();
+	__m512 acc1 = _mm512_setzero_ps();
+	size_t i = 0;
+	for (; i + 32 <= n; i += 32) {
+		acc0 = _mm512_fmadd_ps(_mm512_loadu_ps(x + i), _mm512_loadu_ps(y + i), acc0);
+		acc1 = _mm512_fmadd_ps(_mm512_loadu_ps(x + i + 16), _mm512_loadu_ps(y + i + 16), acc1);
+	}
+	if (i < n) {
+		const size_t count = std::min<size_t>(n - i, 16);
+		const __mmask16 mask = (1u << count) - 1;
+		acc0 = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(mask, x + i), _mm512_maskz_loadu_ps(mask, y + i), acc0);
+		i += count;
+	}
+	if (i < n) {
+		const __mmask16 mask = (1u << (n - i)) - 1;
+		acc1 = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(mask, x + i), _mm512_maskz_loadu_ps(mask, y + i), acc1);
+	}
+	alignas(64) float lanes[16];
+	_mm512_store_ps(lanes, _mm512_add_ps(acc0, acc1));
+	float sum = 0;
+	for (float lane: lanes)
+		sum += lane;
+	return sum;
+}
+
+// 12 rows by 16 columns of C: 24 accumulators, plus 2 registers for B and 1 for A
+[[gnu::target("avx512f")]]
+void gemm_avx512 (size_t k, const double* a, const double* b, double* c, size_t c_stride)
+{
+	constexpr size_t mr = 12;
+	// As in gemm_avx2()
+	for (size_t i = 0; i < mr; i++) {
+		_mm_prefetch(reinterpret_cast<const char*>(c + i * c_stride), _MM_HINT_T0);
+		_mm_prefetch(reinterpret_cast<const char*>(c + i * c_stride + 15), _MM_HINT_T0);
+	}
+	__m512d acc[mr][2];
+	#pragma GCC unroll 12
+	for (size_t i = 0; i < mr; i++)
+		acc[i][0] = acc[i][1] = _mm512_setzero_pd();
+
+	for (size_t p = 0; p < k; p++, a += mr, b += 16) {
+		const __m512d b0 = _mm512_load_pd(b);
+		const __m512d b1 = _mm512_load_pd(b + 8);
+		#pragma GCC unroll 12
+		for (size_t i = 0; i < mr; i++) {
+			const __m512d ai = _mm512_set1_pd(a[i]);
+			acc[i][0] = _mm512_fmadd_pd(ai, b0, acc[i][0]);
+			acc[i][1] = _mm512_fmadd_pd(ai, b1, acc[i][1]);
+		}
+	}
+
+	#pragma GCC unroll 12
+	for (size_t i = 0; i < mr; i++) {
+		double* const row = c + i * c_stride;
+		_mm512_storeu_pd(row, _mm512_add_pd(_mm512_loadu_pd(row), acc[i][0]));
+		_mm512_storeu_pd(row + 8, _mm512_add_pd(_mm512_loadu_pd(row + 8), acc[i][1]));
+	}
+}
+
+// 12 rows by 32 columns
+[[gnu::target("avx512f")]]
+void gemm_avx512 (size_t k, const float* a, const float* b, float* c, size_t c_stride)
+{
+	constexpr size_t mr = 12;
+	for (size_t i = 0; i < mr; i++) {
+		_mm_prefetch(reinterpret_cast<const char*>(c + i * c_stride), _MM_HINT_T0);
+		_mm_prefetch(reinterpret_cast<const char*>(c + i * c_stride + 31), _MM_HINT_T0);
+	}
+	__m512 acc[mr][2];
+	#pragma GCC unroll 12
+	for (size_t i = 0; i < mr; i++)
+		acc[i][0] = acc[i][1] = _mm512_setzero_ps();
+
+	for (size_t p = 0; p < k; p++, a += mr, b += 32) {
+		const __m512 b0 = _mm512_load_ps(b);
+		const __m512 b1 = _mm512_load_ps(b + 16);
+		#pragma GCC unroll 12
+		for (size_t i = 0; i < mr; i++) {
+			const __m512 ai = _mm512_set1_ps(a[i]);
+			acc[i][0] = _mm512_fmadd_ps(ai, b0, acc[i][0]);
+			acc[i][1] = _mm512_fmadd_ps(ai, b1, acc[i][1]);
+		}
+	}
+
+	#pragma GCC unroll 12
+	for (size_t i = 0; i < mr; i++) {
+		float* const row = c + i * c_stride;
+		_mm512_storeu_ps(row, _mm512_add_ps(_mm512_loadu_ps(row), acc[i][0]));
+		_mm512_storeu_ps(row + 16, _mm512_add_ps(_mm512_loadu_ps(row + 16), acc[i][1]));
+	}
+}
+
+// As eliminate_avx2()
+[[gnu::target("avx512f")]] void eliminate_avx512
+(double* row, const double* main_row, const double* inverse, size_t width, size_t count, size_t stride)
+{
+	size_t s = 0;
+	for (; s + 8 <= count; s += 8) {
+		const __m512d factor = _mm512_mul_pd(_mm512_loadu_pd(row + s), _mm512_loadu_pd(inverse + s));
+		for (size_t col = 1; col < width; col++) {
+			double* const target = row + col * stride + s;
+			const __m512d main = _mm512_loadu_pd(main_row + col * stride + s);
+			_mm512_storeu_pd(target, _mm512_fnmadd_pd(factor, main, _mm512_loadu_pd(target)));
+		}
+		_mm512_storeu_pd(row + s, _mm512_setzero_pd());
+	}
+	eliminate_scalar(row + s, main_row + s, inverse + s, width, count - s, stride);
+}
+
+[[gnu::target("avx512f")]] void eliminate_avx512
+(float* row, const float* main_row, const float* inverse, size_t width, size_t count, size_t stride)
+{
+	size_t s = 0;
+	for (; s + 16 <= count; s += 16) {
+		const __m512 factor = _mm512_mul_ps(_mm512_loadu_ps(row + s), _mm512_loadu_ps(inverse + s));
+		for (size_t col = 1; col < width; col++) {
+			float* const target = row + col * stride + s;
+			const __m512 main = _mm512_loadu_ps(main_row + col * stride + s);
+			_mm512_storeu_ps(target, _mm512_fnmadd_ps(factor, main, _mm512_loadu_ps(target)));
+		}
+		_mm512_storeu_ps(row + s, _mm512_setzero_ps());
+	}
+	eliminate_scalar(row + s, main_row + s, inverse + s, width, count - s, stride);
+}
+
+// GCC 12 warns about the _mm512_undefined_epi32() in its own integer intrinsics
+#ifndef __clang__
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+[[gnu::target("avx512f")]]
+void axpy_mod_avx512 (std::uint32_t* y, std::uint32_t a, const std::uint32_t* x, size_t n, std::uint32_t p)
+{
+	const __m512i va = _mm512_set1_epi32(int(a));
+	const __m512i va_shoup = _mm512_set1_epi32(int(shoup_multiplier(a, p)));
+	const __m512i vp = _mm512_set1_epi32(int(p));
+	size_t i = 0;
+	for (; i + 16 <= n; i += 16) {
+		const __m512i vx = _mm512_loadu_si512(x + i);
+		const __m512i even = _mm512_srli_epi64(_mm512_mul_epu32(vx, va_shoup), 32);
+		const __m512i odd = _mm512_mul_epu32(_mm512_srli_epi64(vx, 32), va_shoup);
+		const __m512i q = _mm512_mask_blend_epi32(0xAAAA, even, odd);
+		__m512i r = _mm512_sub_epi32(_mm512_mullo_epi32(vx, va), _mm512_mullo_epi32(q, vp));
+		r = _mm512_min_epu32(r, _mm512_sub_epi32(r, vp));
+		__m512i sum = _mm512_add_epi32(_mm512_loadu_si512(y + i), r);
+		sum = _mm512_min_epu32(sum, _mm512_sub_epi32(sum, vp));
+		_mm512_storeu_si512(y + i, sum);
+	}
+	axpy_mod_scalar(y + i, a, x + i, n - i, p);
+}
+#ifndef __clang__
+#pragma GCC diagnostic pop
+#endif
+#endif
+
+struct Kernels {
+	Axpy_fn<double> axpy;
+	Dot_fn<double> dot;
+	Axpy_fn<float> axpy_float;
+	Dot_fn<float> dot_float;
+	Gemm_kernel<double> gemm;
+	Gemm_kernel<float> gemm_float;
+	Axpy_mod_fn axpy_mod;
+	Eliminate_fn<double> eliminate;
+	Eliminate_fn<float> eliminate_float;
+	const char* name;
+};
+
+Kernels select_kernels ()
+{
+#if KERNELS_X86
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx512f"))
+		return { axpy_avx512, dot_avx512, axpy_avx512, dot_avx512,
+			{ 12, 16, gemm_avx512 }, { 12, 32, gemm_avx512 }, axpy_mod_avx512,
+			eliminate_avx512, eliminate_avx512, "AVX-512" };
+	if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+		return { axpy_avx2, dot_avx2, axpy_avx2, dot_avx2,
+			{ 6, 8, gemm_avx2 }, { 6, 16, gemm_avx2 }, axpy_mod_avx2,
+			eliminate_avx2, eliminate_avx2, "AVX2" };
+#endif
+	return { axpy_scalar<double>, dot_scalar<double>, axpy_scalar<float>, dot_scalar<float>,
+		{ 4, 4, gemm_scalar<4, 4> }, { 4, 4, gemm_scalar<4, 4> }, axpy_mod_scalar,
+		eliminate_scalar<double>, eliminate_scalar<float>, "scalar" };
+}
+
+const Kernels kernels = select_kernels();
+
+} // namespace
+
+template <> void axpy<double> (std::span<double> y, double a, std::span<const double> x)
+{
+	assert(y.size() == x.size());
+	kernels.axpy(y.data(), a, x.data(), y.size());
+}
+
+template <> double dot<double> (std::span<const double> x, std::span<const double> y)
+{
+	assert(x.size() == y.size());
+	return kernels.dot(x.data(), y.data(), x.size());
+}
+
+template <> void axpy<float> (std::span<float> y, float a, std::span<const float> x)
+{
+	assert(y.size() == x.size());
+	kernels.axpy_float(y.data(), a, x.data(), y.size());
+}
+
+template <> float dot<float> (std::span<const float> x, std::span<const float> y)
+{
+	assert(x.size() == y.size());
+	return kernels.dot_float(x.data(), y.data(), x.size());
+}
+
+// Mod_p is a standard-layout wrapper of its residue, so an array of them is one of residues
+static_assert(std::is_standard_layout_v<Mod_p> && sizeof(Mod_p) == sizeof(std::uint32_t));
+
+template <> void axpy<Mod_p> (std::span<Mod_p> y, Mod_p a, std::span<const Mod_p> x)
+{
+	assert(y.size() == x.size());
+	kernels.axpy_mod(reinterpret_cast<std::uint32_t*>(y.data()), a.residue(),
+			reinterpret_cast<const std::uint32_t*>(x.data()), y.size(), Mod_p::modulus());
+}
+
+template <> void eliminate_batch<double>
+(std::span<double> row, std::span<const double> main_row, std::span<const double> inverse)
+{
+	assert(row.size() == main_row.size() && !inverse.empty() && row.size() % inverse.size() == 0);
+	kernels.eliminate(row.data(), main_row.data(), inverse.data(), row.size() / inverse.size(),
+			inverse.size(), inverse.size());
+}
+
+template <> void eliminate_batch<float>
+(std::span<float> row, std::span<const float> main_row, std::span<const float> inverse)
+{
+	assert(row.size() == main_row.size() && !inverse.empty() && row.size() % inverse.size() == 0);
+	kernels.eliminate_float(row.data(), main_row.data(), inverse.data(), row.size() / inverse.size(),
+			inverse.size(), inverse.size());
+}
+
+template <> const Gemm_kernel<double>& gemm_kernel<double> () { return kernels.gemm; }
+template <> const Gemm_kernel<float>& gemm_kernel<float> () { return kernels.gemm_float; }
+
+const char* kernel_instruction_set () { return kernels.name; }
+
+} // namespace math
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cassert>
+#include <span>
+#include <type_traits>
+
+namespace math {
+// Vector kernels for the inner loops of the solvers.
+// The generic versions are plain loops; `double` and `float` have vectorized versions
+// (see kernels.cpp) which pick the widest instruction set the CPU supports at runtime.
+
+// y += a*x
+template <typename T> void axpy
+(std::span<T> y, std::type_identity_t<T> a, std::span<const std::type_identity_t<T>> x)
+{
+	assert(y.size() == x.size());
+	for (size_t i = 0; i < y.size(); i++)
+		y[i] += a * x[i];
+}
+
+// Sum of x[i]*y[i]
+template <typename T> T dot
+(std::span<const T> x, std::span<const std::type_identity_t<T>> y)
+{
+	assert(x.size() == y.size());
+	T result = 0;
+	for (size_t i = 0; i < x.size(); i++)
+		result += x[i] * y[i];
+	return result;
+}
+
+// One elimination step in `inverse.size()` systems at once, stored as in Matrix_batch
+// (see batch.hpp): element `col` of a row of system `s` is row[col * inverse.size() + s].
+// Subtracts main_row times row[0] / main_row[0] from the row, with `inverse` holding
+// 1 / main_row[0] for every system, and leaves the row's first element zero
+template <typename T> void eliminate_batch (std::span<T> row,
+		std::span<const std::type_identity_t<T>> main_row, std::span<const std::type_identity_t<T>> inverse)
+{
+	assert(row.size() == main_row.size() && !inverse.empty() && row.size() % inverse.size() == 0);
+	const size_t count = inverse.size();
+	for (size_t col = 1; col < row.size() / count; col++) {
+		for (size_t s = 0; s < count; s++)
+			row[col * count + s] -= (row[s] * inverse[s]) * main_row[col * count + s];
+	}
+	for (size_t s = 0; s < count; s++)
+		row[s] = 0;
+}
+
+template <> void axpy<double> (std::span<double>, double, std::span<const double>);
+template <> double dot<double> (std::span<const double>, std::span<const double>);
+template <> void axpy<float> (std::span<float>, float, std::span<const float>);
+template <> float dot<float> (std::span<const float>, std::span<const float>);
+template <> void eliminate_batch<double>
+(std::span<double>, std::span<const double>, std::span<const double>);
+template <> void eliminate_batch<float>
+(std::span<float>, std::span<const float>, std::span<const float>);
+
+// The inner kernel of gemm() (see gemm.cpp), on a tile of `mr` rows by `nr` columns:
+// c[i*c_stride + j] += sum of a[p*mr + i] * b[p*nr + j] over p in [0, k).
+// `b` must be aligned to 64 bytes
+template <typename T> struct Gemm_kernel {
+	size_t mr, nr;
+	void (*fn) (size_t k, const T* a, const T* b, T* c, size_t c_stride);
+};
+template <typename T> const Gemm_kernel<T>& gemm_kernel ();
+template <> const Gemm_kernel<double>& gemm_kernel<double> ();
+template <> const Gemm_kernel<float>& gemm_kernel<float> ();
+
+// Which implementation the vectorized kernels have chosen, for display purposes
+const char* kernel_instruction_set ();
+
+} // namespace math
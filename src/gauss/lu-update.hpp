@@ -0,0 +1,170 @@
+#pragma once
+
+#include <cmath>
+#include <gauss/gemm.hpp>
+#include <gauss/lu.hpp>
+#include <limits>
+#include <optional>
+#include <vector>
+
+// Solving a square system again after small changes to its matrix, without factoring it anew.
+// Changing one element or one row adds a rank-one term to the matrix: A' = A + u*v^T.
+// By the Sherman-Morrison formula,
+//   A'^-1 * b = A^-1 * b - z * (v^T * A^-1 * b) / (1 + v^T * z), where z = A^-1 * u,
+// so after k changes a solve costs the solve with the original LU factorization plus O(k*n),
+// and a change costs one such solve. Every solve measures its residual, and when the updates
+// have cost too much accuracy, the current matrix is factored anew and solved again
+
+namespace math {
+
+struct Lu_update_settings {
+	// After this many changes the solves have become slow enough to be worth factoring anew
+	size_t max_updates = 32;
+	// How many times larger than that of a backward stable solve the residual may grow
+	// before the matrix is factored anew
+	double drift_tolerance = 1000;
+	unsigned threads = 1;
+};
+
+template <typename T> class Updatable_lu {
+	struct Update {
+		std::vector<T> z, v; // solves get x -= z * (v^T * x) * scale
+		T scale;             // 1 / (1 + v^T * z)
+	};
+
+	Matrix<T> a; // with all the changes
+	std::optional<Lu_factorization<T>> lu; // of `a` as it was before `updates`
+	std::vector<Update> updates;
+	T determinant_ = 0;
+	size_t refactorizations_ = 0;
+	Lu_update_settings settings;
+
+	void factorize ()
+	{
+		lu.emplace(Matrix_view<const T>(a), default_lu_block_size, settings.threads);
+		updates.clear();
+		determinant_ = lu->determinant();
+	}
+
+	// x = A^-1 * b for the current A
+	void solve_updated (std::span<T> x, std::span<const T> b) const
+	{
+		lu->solve(x, b);
+		for (const Update& update: updates)
+			axpy(x, -dot(std::span<const T>(update.v), std::span<const T>(x)) * update.scale,
+					std::span<const T>(update.z));
+	}
+
+	// The matrix has had u*v^T added to it already
+	void add_update (std::vector<T> u, std::vector<T> v)
+	{
+		using std::abs, std::sqrt;
+		if (lu->singular() || updates.size() == settings.max_updates) {
+			refactorizations_++;
+			factorize();
+			return;
+		}
+
+		std::vector<T> z(size());
+		solve_updated(std::span(z), std::span<const T>(u));
+		const T denominator = 1 + dot(std::span<const T>(v), std::span<const T>(z));
+
+		// A small denominator comes from cancellation, and takes the accuracy with it.
+		// When the changed matrix is singular, it is exactly zero in exact arithmetic
+		const auto max_norm = [] (const std::vector<T>& w) {
+			T norm = 0;
+			for (const T& value: w)
+				norm = std::max(norm, abs(value));
+			return norm;
+		};
+		const T scale_of_terms = std::max(T(1), max_norm(v) * max_norm(z));
+		if (!(abs(denominator) > sqrt(std::numeric_limits<T>::epsilon()) * scale_of_terms)) {
+			refactorizations_++;
+			factorize();
+			return;
+		}
+
+		determinant_ *= denominator;
+		updates.push_back({ std::move(z), std::move(v), T(1) / denominator });
+	}
+
+public:
+	explicit Updatable_lu (Matrix_view<const T> initial, const Lu_update_settings& update_settings = {})
+		: a(initial), settings(update_settings)
+	{
+		assert(a.rows() == a.cols() && a.rows() > 0);
+		factorize();
+	}
+
+	[[nodiscard]] size_t size () const { return a.rows(); }
+	[[nodiscard]] Matrix_view<const T> matrix () const { return a; }
+
+	// The solve() function must not be called then
+	[[nodiscard]] bool singular () const { return lu->singular(); }
+	[[nodiscard]] T determinant () const { return determinant_; }
+
+	// Changes since the matrix was last factored
+	[[nodiscard]] size_t num_updates () const { return updates.size(); }
+	// Times the matrix was factored anew, not counting the first time
+	[[nodiscard]] size_t refactorizations () const { return refactorizations_; }
+
+	void update_element (size_t row, size_t col, T value)
+	{
+		assert(row < size() && col < size());
+		std::vector<T> u(size()), v(size());
+		u[row] = value - a[row][col];
+		v[col] = 1;
+		a[row][col] = value;
+		add_update(std::move(u), std::move(v));
+	}
+
+	void update_row (size_t row, std::span<const std::type_identity_t<T>> values)
+	{
+		assert(row < size() && values.size() == size());
+		std::vector<T> u(size()), v(size());
+		u[row] = 1;
+		for (size_t col = 0; col < size(); col++)
+			v[col] = values[col] - a[row][col];
+		std::ranges::copy(values, a[row].begin());
+		add_update(std::move(u), std::move(v));
+	}
+
+	// Solve A*x = b for the current A. `x` and `b` must not overlap.
+	// If the drift check has the matrix factored anew, it may turn out singular after all:
+	// `x` is meaningless then
+	void solve (std::span<T> x, std::span<const std::type_identity_t<T>> b)
+	{
+		assert(!singular());
+		assert(x.size() == size() && b.size() == size());
+		using std::abs, std::sqrt;
+
+		solve_updated(x, b);
+		if (updates.empty())
+			return;
+
+		// The drift check: |b - A*x| <= tolerance * sqrt(n) * epsilon * |A| * |x| in max-norms
+		std::vector<T> residual(b.begin(), b.end());
+		gemv(std::span(residual), T(-1), matrix(), Transpose::no, std::span<const T>(x), T(1),
+				settings.threads);
+		T residual_norm = 0, x_norm = 0, a_norm = 0;
+		for (size_t i = 0; i < size(); i++) {
+			residual_norm = std::max(residual_norm, abs(residual[i]));
+			x_norm = std::max(x_norm, abs(x[i]));
+			T row_sum = 0;
+			for (const T& value: a[i])
+				row_sum += abs(value);
+			a_norm = std::max(a_norm, row_sum);
+		}
+		const T allowed = T(settings.drift_tolerance) * sqrt(T(size()))
+				* std::numeric_limits<T>::epsilon() * a_norm * x_norm;
+		if (residual_norm <= allowed)
+			return;
+
+		refactorizations_++;
+		factorize();
+		if (!singular())
+			lu->solve(x, b);
+	}
+};
+
+} // namespace math
@@ -0,0 +1,325 @@
+#pragma once
+
+#include <gauss/gemm.hpp>
+#include <gauss/matrix.hpp>
+#include <gauss/solve.hpp>
+#include <cmath>
+#include <memory_resource>
+#include <vector>
+
+namespace math {
+
+// Blocked ("right-looking") variant of the first step of the Gauss method.
+// The matrix is processed in panels of `block_size` columns: a panel is eliminated
+// column by column, then the rest of the matrix receives the whole panel's update at once,
+// tile by tile, so that the panel rows stay in cache instead of the whole matrix being
+// re-streamed from memory for every pivot.
+//
+// Like gauss_triangulate_pivoting(), rows are physically swapped to bring the element of the
+// largest magnitude onto the diagonal (partial pivoting). Only when a column has no nonzero
+// element left does the rest of the matrix get handed to gauss_triangulate_pivoting(),
+// so the variables may still be permuted in degenerate cases.
+
+namespace detail {
+// Update the columns [col_begin, mat.cols()) with the eliminations from panel columns
+// [k0, k0+kb), whose multipliers are stored below the diagonal of the panel.
+// Rows below the panel are split between threads; each row is computed the same way
+// regardless of which thread gets it.
+template <typename T> void lu_apply_panel
+(Matrix_view<T> mat, size_t k0, size_t kb, size_t col_begin, size_t block_size, unsigned threads)
+{
+	const size_t k_end = k0 + kb;
+	if (col_begin >= mat.cols())
+		return;
+
+	// Rows of the panel itself: forward substitution with the unit-diagonal L
+	for (size_t k = k0; k < k_end; k++) {
+		auto pivot_part = mat[k].subspan(col_begin);
+		for (size_t row = k+1; row < k_end; row++)
+			axpy(mat[row].subspan(col_begin), -mat[row][k], pivot_part);
+	}
+
+	// Rows below the panel: a matrix product of the multipliers and the panel rows,
+	// for the types that have a fast one
+	if constexpr (std::is_same_v<T, double> || std::is_same_v<T, float>) {
+		const size_t below = mat.rows() - k_end, width = mat.cols() - col_begin;
+		if (below == 0 || kb == 0)
+			return;
+		const Matrix_view<const T> multipliers(mat[k_end].data() + k0, below, kb, mat.stride());
+		const Matrix_view<const T> panel_rows(mat[k0].data() + col_begin, kb, width, mat.stride());
+		const Matrix_view<T> rest(mat[k_end].data() + col_begin, below, width, mat.stride());
+		gemm(rest, T(-1), multipliers, Transpose::no, panel_rows, Transpose::no, T(1), threads);
+		return;
+	}
+
+	// Otherwise the tile of panel rows is reused for every one of them,
+	// as wide as possible while the panel rows of a tile still fit in L2
+	constexpr size_t tile_bytes = 256 << 10;
+	const size_t tile_width = std::max(block_size, tile_bytes / sizeof(T) / std::max<size_t>(kb, 1));
+	const size_t tile_elements = (mat.cols() - col_begin) * std::max<size_t>(kb, 1);
+	const size_t min_rows_per_thread = 1 + parallel_min_elements / tile_elements;
+	parallel_for(k_end, mat.rows(), threads, min_rows_per_thread, [&] (size_t begin, size_t end) {
+		for (size_t col0 = col_begin; col0 < mat.cols(); col0 += tile_width) {
+			const size_t tile_cols = std::min(tile_width, mat.cols() - col0);
+			for (size_t row = begin; row < end; row++) {
+				auto target = mat[row];
+				for (size_t k = k0; k < k_end; k++)
+					axpy(target.subspan(col0, tile_cols), -target[k], mat[k].subspan(col0, tile_cols));
+			}
+		}
+	});
+}
+} // namespace detail
+
+constexpr size_t default_lu_block_size = 64;
+
+struct Lu_info {
+	unsigned permutations = 0;   // swaps made, between rows and between variables
+	size_t factored_columns = 0; // leading columns with elimination multipliers below the diagonal
+};
+
+namespace detail {
+// Blocked LU with partial pivoting of the first `num_pivots` columns of `mat`, with the rest
+// of the columns receiving the updates. Stops at the first column that has no nonzero
+// element left, having brought the rest of the matrix up to date with the columns before it
+template <typename T> Lu_info lu_factor_columns
+(Matrix_view<T> mat, size_t num_pivots, std::span<size_t> permute_equations,
+ size_t block_size, unsigned threads)
+{
+	assert(num_pivots <= std::min(mat.rows(), mat.cols()));
+	assert(block_size > 0);
+	assert(permute_equations.size() == mat.rows());
+
+	for (size_t i = 0; i < mat.rows(); i++)
+		permute_equations[i] = i;
+
+	Lu_info info;
+
+	for (size_t k0 = 0; k0 < num_pivots; k0 += block_size) {
+		const size_t kb = std::min(block_size, num_pivots - k0);
+		const size_t panel_end = k0 + kb;
+
+		for (size_t k = k0; k < panel_end; k++) {
+			using std::abs;
+			size_t pivot = k;
+			for (size_t row = k+1; row < mat.rows(); row++) {
+				if (abs(mat[row][k]) > abs(mat[pivot][k]))
+					pivot = row;
+			}
+
+			if (mat[pivot][k] == 0) {
+				lu_apply_panel(mat, k0, k-k0, panel_end, block_size, threads);
+				info.factored_columns = k;
+				return info;
+			}
+
+			if (pivot != k) {
+				std::swap_ranges(mat[k].begin(), mat[k].end(), mat[pivot].begin());
+				std::swap(permute_equations[k], permute_equations[pivot]);
+				info.permutations++;
+			}
+
+			auto pivot_row = mat[k];
+			const T inv_main_element = T(1) / pivot_row[k];
+			const size_t min_rows_per_thread = 1 + parallel_min_elements / (panel_end - k);
+			parallel_for(k+1, mat.rows(), threads, min_rows_per_thread, [&] (size_t begin, size_t end) {
+				for (size_t row = begin; row < end; row++) {
+					auto target = mat[row];
+					const T multiplier = (target[k] *= inv_main_element);
+					const size_t width = panel_end-k-1;
+					axpy(target.subspan(k+1, width), -multiplier, pivot_row.subspan(k+1, width));
+				}
+			});
+		}
+
+		lu_apply_panel(mat, k0, kb, panel_end, block_size, threads);
+	}
+
+	info.factored_columns = num_pivots;
+	return info;
+}
+} // namespace detail
+
+// Triangulate `mat` in place, leaving the elimination multipliers below the diagonal
+// in the columns that were eliminated with partial pivoting.
+// `permute_equations`, `permute_variables` and `threads` have the same meaning
+// as in gauss_triangulate_pivoting().
+// Only a degenerate matrix needs scratch memory, O(rows + cols) of it, taken from `scratch`.
+template <typename T> Lu_info lu_triangulate_in_place
+(Matrix_view<T> mat, std::span<size_t> permute_equations, std::span<size_t> permute_variables,
+ size_t block_size = default_lu_block_size, unsigned threads = 1,
+ std::pmr::memory_resource* scratch = std::pmr::get_default_resource())
+{
+	assert(mat.cols() > 1 && mat.rows() > 0);
+
+	const size_t num_equations = mat.rows();
+	const size_t num_variables = mat.cols()-1;
+	const size_t num_pivots = std::min(num_equations, num_variables);
+	assert(permute_variables.size() == num_variables);
+
+	for (size_t i = 0; i < num_variables; i++)
+		permute_variables[i] = i;
+
+	Lu_info info = detail::lu_factor_columns(mat, num_pivots, permute_equations, block_size, threads);
+	const size_t k = info.factored_columns;
+	if (k == num_pivots)
+		return info;
+
+	// Zero column: let the unblocked algorithm, which can also permute variables,
+	// deal with the rest of the matrix
+	auto rest = mat.subview(k, k, num_equations-k, mat.cols()-k);
+	std::pmr::vector<size_t> rest_permute_equations(num_equations - k, scratch);
+	auto rest_permute_variables = permute_variables.subspan(k);
+	info.permutations += gauss_triangulate_pivoting(rest,
+			std::span(rest_permute_equations), rest_permute_variables, threads);
+
+	// The rows and columns of `rest` have been permuted; do the same for the parts
+	// of the matrix outside it, and make the permutations refer to the whole matrix
+	std::pmr::vector<T> reordered(std::max(num_variables, num_equations) - k, scratch);
+	for (size_t row = 0; row < k; row++) {
+		auto r = mat[row];
+		for (size_t i = 0; i < num_variables-k; i++)
+			reordered[i] = r[k + rest_permute_variables[i]];
+		std::copy_n(reordered.begin(), num_variables-k, r.begin() + k);
+	}
+	for (size_t& p: rest_permute_variables)
+		p += k;
+
+	const std::pmr::vector<size_t> old_permute_equations(permute_equations.begin() + k,
+			permute_equations.end(), scratch);
+	for (size_t col = 0; col < k; col++) {
+		for (size_t i = 0; i < num_equations-k; i++)
+			reordered[i] = mat[k + rest_permute_equations[i]][col];
+		for (size_t i = 0; i < num_equations-k; i++)
+			mat[k+i][col] = reordered[i];
+	}
+	for (size_t i = 0; i < num_equations-k; i++)
+		permute_equations[k+i] = old_permute_equations[rest_permute_equations[i]];
+
+	return info;
+}
+
+// Same contract as gauss_triangulate_pivoting(), but uses the blocked algorithm above.
+// In place: the input is destroyed, and no memory is allocated except for degenerate matrices
+template <typename T> unsigned gauss_triangulate_blocked
+(Matrix_view<T> mat, std::span<size_t> permute_equations, std::span<size_t> permute_variables,
+ size_t block_size = default_lu_block_size, unsigned threads = 1,
+ std::pmr::memory_resource* scratch = std::pmr::get_default_resource())
+{
+	const Lu_info info = lu_triangulate_in_place(mat, permute_equations, permute_variables,
+			block_size, threads, scratch);
+
+	// Multipliers are not part of the triangular form
+	for (size_t row = 1; row < mat.rows(); row++)
+		std::fill_n(mat[row].begin(), std::min(row, info.factored_columns), T(0));
+
+	return info.permutations;
+}
+
+// Same as above, but the input is left intact.
+// `dest` and `src` must not overlap.
+template <typename T> unsigned gauss_triangulate_blocked
+(Matrix_view<T> dest, Matrix_view<const T> src,
+ std::span<size_t> permute_equations, std::span<size_t> permute_variables,
+ size_t block_size = default_lu_block_size, unsigned threads = 1,
+ std::pmr::memory_resource* scratch = std::pmr::get_default_resource())
+{
+	copy_matrix(dest, src, threads);
+	return gauss_triangulate_blocked(dest, permute_equations, permute_variables,
+			block_size, threads, scratch);
+}
+
+// LU factorization of a square matrix with partial pivoting: P*A = L*U.
+// Factorizing takes O(n^3) once, after which every right-hand side is solved in O(n^2).
+template <typename T> class Lu_factorization {
+	Matrix<T> lu; // U on and above the diagonal, L below it (L's unit diagonal is implied)
+	std::vector<size_t> permute_equations; // row i of `lu` comes from row permute_equations[i] of A
+	Lu_info info;
+
+	void factorize (size_t block_size, unsigned threads)
+	{
+		assert(lu.rows() == lu.cols() && lu.rows() > 0);
+		info = detail::lu_factor_columns(Matrix_view<T>(lu), size(), std::span(permute_equations),
+				block_size, threads);
+	}
+
+public:
+	explicit Lu_factorization
+	(Matrix_view<const T> a, size_t block_size = default_lu_block_size, unsigned threads = 1)
+		: lu(a), permute_equations(a.rows())
+	{
+		factorize(block_size, threads);
+	}
+
+	// Factorize in the storage of `a` itself, without making a copy
+	explicit Lu_factorization
+	(Matrix<T>&& a, size_t block_size = default_lu_block_size, unsigned threads = 1)
+		: lu(std::move(a)), permute_equations(lu.rows())
+	{
+		factorize(block_size, threads);
+	}
+
+	[[nodiscard]] size_t size () const { return lu.rows(); }
+
+	// The matrix has no unique inverse; the solve() functions must not be called then
+	[[nodiscard]] bool singular () const { return info.factored_columns < size(); }
+
+	[[nodiscard]] T determinant () const
+	{
+		if (singular())
+			return 0;
+		const T det = triangular_determinant(Matrix_view<const T>(lu));
+		return info.permutations % 2 == 0 ? det : -det;
+	}
+
+	// Solve A*x = b. `x` and `b` must not overlap
+	void solve (std::span<T> x, std::span<const T> b) const
+	{
+		assert(!singular());
+		assert(x.size() == size() && b.size() == size());
+		const size_t n = size();
+
+		// L*y = P*b
+		for (size_t i = 0; i < n; i++)
+			x[i] = b[permute_equations[i]] - dot(lu[i].first(i), std::span<const T>(x.first(i)));
+
+		// U*x = y
+		for (size_t i = n-1; i != size_t(-1); i--) {
+			auto row = lu[i];
+			x[i] = (x[i] - dot(row.subspan(i+1), std::span<const T>(x.subspan(i+1)))) / row[i];
+		}
+	}
+
+	// Solve A*X = B for every column of B at once. `x` and `b` must not overlap
+	void solve (Matrix_view<T> x, Matrix_view<const T> b, unsigned threads = 1) const
+	{
+		assert(!singular());
+		assert(x.rows() == size() && b.rows() == size() && x.cols() == b.cols());
+		const size_t n = size();
+
+		// Columns of X are independent, so they are split between threads
+		const size_t min_cols_per_thread = 1 + parallel_min_elements / (n * n);
+		parallel_for(0, x.cols(), threads, min_cols_per_thread, [&] (size_t begin, size_t end) {
+			auto xs = x.subview(0, begin, n, end-begin);
+			auto bs = b.subview(0, begin, n, end-begin);
+
+			for (size_t i = 0; i < n; i++) {
+				auto row = xs[i];
+				std::ranges::copy(bs[permute_equations[i]], row.begin());
+				for (size_t j = 0; j < i; j++)
+					axpy(row, -lu[i][j], std::span<const T>(xs[j]));
+			}
+
+			for (size_t i = n-1; i != size_t(-1); i--) {
+				auto row = xs[i];
+				for (size_t j = i+1; j < n; j++)
+					axpy(row, -lu[i][j], std::span<const T>(xs[j]));
+				const T inv_main_element = T(1) / lu[i][i];
+				for (T& value: row)
+					value *= inv_main_element;
+			}
+		});
+	}
+};
+
+} // namespace math
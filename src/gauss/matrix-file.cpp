@@ -0,0 +1,221 @@
+#include <cctype>
+#include <charconv>
+#include <cstring>
+#include <gauss/matrix-file.hpp>
+#include <istream>
+#include <limits>
+#include <ostream>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define MATRIX_FILE_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#define MATRIX_FILE_MMAP 0
+#endif
+
+namespace math {
+namespace {
+
+// Reads whitespace separated numbers in big chunks, which is many times faster than `>>`
+class Number_reader {
+	std::streambuf& in;
+	std::vector<char> buffer = std::vector<char>(size_t(1) << 20);
+	size_t begin = 0, end = 0; // the unread part of `buffer`
+	bool eof = false;
+
+	// Move the unread part to the front of the buffer and read more after it
+	void refill ()
+	{
+		std::memmove(buffer.data(), buffer.data() + begin, end - begin);
+		end -= begin;
+		begin = 0;
+		if (end == buffer.size())
+			buffer.resize(2 * buffer.size());
+		const auto got = in.sgetn(buffer.data() + end, buffer.size() - end);
+		end += got;
+		eof = got == 0;
+	}
+
+	static bool is_space (char c) { return std::isspace(static_cast<unsigned char>(c)); }
+
+public:
+	explicit Number_reader (std::streambuf& in_): in{in_} {}
+
+	template <typename N> bool read (N& value)
+	{
+		while (true) {
+			while (begin < end && is_space(buffer[begin]))
+				begin++;
+			if (begin < end)
+				break;
+			if (eof)
+				return false;
+			refill();
+		}
+
+		// The whole number must be in the buffer
+		size_t token_end = begin;
+		while (true) {
+			while (token_end < end && !is_space(buffer[token_end]))
+				token_end++;
+			if (token_end < end || eof)
+				break;
+			const size_t scanned = token_end - begin;
+			refill();
+			token_end = begin + scanned;
+		}
+
+		const char* first = buffer.data() + begin;
+		const char* const last = buffer.data() + token_end;
+		if (*first == '+') // accepted by `>>`, but not by from_chars()
+			first++;
+		const auto [ptr, error] = std::from_chars(first, last, value);
+		begin = token_end;
+		return error == std::errc() && ptr == last;
+	}
+};
+
+} // namespace
+
+Matrix_file_header make_matrix_file_header (size_t rows, size_t cols, size_t stride)
+{
+	Matrix_file_header header {};
+	std::memcpy(header.magic, Matrix_file_header::expected_magic, sizeof(header.magic));
+	header.version = Matrix_file_header::current_version;
+	header.dtype = Matrix_dtype::float64;
+	header.rows = rows;
+	header.cols = cols;
+	header.stride = stride;
+	header.data_offset = sizeof(Matrix_file_header);
+	return header;
+}
+
+bool valid_matrix_file_header (const Matrix_file_header& header, size_t file_size)
+{
+	if (std::memcmp(header.magic, Matrix_file_header::expected_magic, sizeof(header.magic)) != 0
+	|| header.version != Matrix_file_header::current_version || header.dtype != Matrix_dtype::float64)
+		return false;
+	if (header.stride < header.cols || header.data_offset < sizeof(header)
+	|| header.data_offset % alignof(double) != 0 || header.data_offset > file_size)
+		return false;
+	if (header.rows == 0 || header.cols == 0)
+		return true;
+	const std::uint64_t available = (file_size - header.data_offset) / sizeof(double);
+	return header.rows-1 <= available / header.stride
+		&& (header.rows-1) * header.stride + header.cols <= available;
+}
+
+bool is_matrix_file (std::istream& in)
+{
+	const auto start = in.tellg();
+	char magic[sizeof(Matrix_file_header::expected_magic)];
+	const bool result = in.read(magic, sizeof(magic))
+		&& std::memcmp(magic, Matrix_file_header::expected_magic, sizeof(magic)) == 0;
+	in.clear();
+	in.seekg(start);
+	return result;
+}
+
+auto Mapped_matrix::open (const char* path) -> std::optional<Mapped_matrix>
+{
+#if MATRIX_FILE_MMAP
+	const int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+	if (fd < 0)
+		return {};
+	struct stat file_stat;
+	if (fstat(fd, &file_stat) != 0 || size_t(file_stat.st_size) < sizeof(Matrix_file_header)) {
+		close(fd);
+		return {};
+	}
+	const size_t size = file_stat.st_size;
+	void* const memory = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd); // the mapping stays valid
+	if (memory == MAP_FAILED)
+		return {};
+
+	Mapped_matrix result;
+	result.mapping = memory;
+	result.mapping_size = size;
+
+	Matrix_file_header header;
+	std::memcpy(&header, memory, sizeof(header));
+	if (!valid_matrix_file_header(header, size))
+		return {};
+	// The solvers start by copying the matrix front to back
+	madvise(memory, size, MADV_SEQUENTIAL);
+
+	const auto* const elements = reinterpret_cast<const double*>(static_cast<const char*>(memory)
+			+ header.data_offset);
+	result.view_ = Matrix_view<const double>(elements, header.rows, header.cols, header.stride);
+	return result;
+#else
+	(void)path;
+	return {}; // no mmap()
+#endif
+}
+
+Mapped_matrix::Mapped_matrix (Mapped_matrix&& lhs) noexcept
+{
+	*this = std::move(lhs);
+}
+
+Mapped_matrix& Mapped_matrix::operator= (Mapped_matrix&& lhs) noexcept
+{
+	std::swap(mapping, lhs.mapping);
+	std::swap(mapping_size, lhs.mapping_size);
+	std::swap(view_, lhs.view_);
+	return *this;
+}
+
+Mapped_matrix::~Mapped_matrix ()
+{
+#if MATRIX_FILE_MMAP
+	if (mapping)
+		munmap(mapping, mapping_size);
+#endif
+}
+
+bool write_matrix_file (std::ostream& out, Matrix_view<const double> mat)
+{
+	const size_t stride = matrix_stride<double>(mat.cols(), {});
+	const auto header = make_matrix_file_header(mat.rows(), mat.cols(), stride);
+	out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+	std::vector<double> row_buf(stride, 0);
+	for (auto row: mat) {
+		std::copy(row.begin(), row.end(), row_buf.begin());
+		out.write(reinterpret_cast<const char*>(row_buf.data()), stride * sizeof(double));
+	}
+	return bool(out.flush());
+}
+
+Text_conversion_status convert_text_matrix (std::istream& text, std::ostream& binary)
+{
+	Number_reader reader(*text.rdbuf());
+	size_t rows, cols;
+	if (!reader.read(rows) || !reader.read(cols))
+		return Text_conversion_status::bad_data;
+	const size_t stride = matrix_stride<double>(cols, {});
+	if (rows < 1 || cols < 1 || rows > std::numeric_limits<std::int64_t>::max() / sizeof(double) / stride)
+		return Text_conversion_status::bad_dimensions;
+
+	const auto header = make_matrix_file_header(rows, cols, stride);
+	binary.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+	std::vector<double> row_buf(stride, 0);
+	for (size_t row = 0; row < rows; row++) {
+		for (size_t col = 0; col < cols; col++) {
+			if (!reader.read(row_buf[col]))
+				return Text_conversion_status::bad_data;
+		}
+		if (!binary.write(reinterpret_cast<const char*>(row_buf.data()), stride * sizeof(double)))
+			return Text_conversion_status::write_error;
+	}
+	return binary.flush() ? Text_conversion_status::ok : Text_conversion_status::write_error;
+}
+
+} // namespace math
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstdint>
+#include <gauss/matrix.hpp>
+#include <iosfwd>
+#include <optional>
+
+// A binary matrix file format that is mapped into memory as is, so loading a matrix costs
+// page faults instead of parsing. The file is a Matrix_file_header followed by the rows,
+// `stride` elements apart, in the byte order of the machine that wrote it
+
+namespace math {
+
+enum class Matrix_dtype : std::uint32_t { float64 = 1 };
+
+struct Matrix_file_header {
+	constexpr static char expected_magic[8] = { 'G', 'A', 'U', 'S', 'S', 'M', 'A', 'T' };
+	constexpr static std::uint32_t current_version = 1;
+
+	char magic[8];
+	std::uint32_t version;
+	Matrix_dtype dtype;
+	std::uint64_t rows, cols, stride; // stride is in elements
+	std::uint64_t data_offset;        // from the start of the file, in bytes
+	char reserved[16];
+};
+static_assert(sizeof(Matrix_file_header) == 64);
+
+// A header for a `rows` by `cols` matrix whose data follows it right away
+Matrix_file_header make_matrix_file_header (size_t rows, size_t cols, size_t stride);
+// Whether the header is ours, and the elements it describes fit in a file of `file_size` bytes
+bool valid_matrix_file_header (const Matrix_file_header&, size_t file_size);
+
+// Whether the stream starts with a Matrix_file_header. The stream position is left unchanged
+bool is_matrix_file (std::istream&);
+
+// A matrix file mapped read-only into memory
+class Mapped_matrix {
+	void* mapping = nullptr;
+	size_t mapping_size = 0;
+	Matrix_view<const double> view_ { nullptr, 0, 0, 0 };
+
+	Mapped_matrix () = default;
+
+public:
+	// Empty if the file can't be read or is not a valid matrix file
+	static std::optional<Mapped_matrix> open (const char* path);
+
+	Mapped_matrix (Mapped_matrix&&) noexcept;
+	Mapped_matrix& operator= (Mapped_matrix&&) noexcept;
+	~Mapped_matrix ();
+
+	// Valid as long as this object is
+	Matrix_view<const double> view () const { return view_; }
+};
+
+// Rows are padded like Matrix pads them, so the rows of the mapped file are aligned too.
+// Returns: false on a write error
+bool write_matrix_file (std::ostream&, Matrix_view<const double>);
+
+enum class Text_conversion_status { ok, bad_dimensions, bad_data, write_error };
+
+// Convert a text matrix ("<rows> <cols>", then the elements row by row) into a matrix file.
+// The rows are converted one by one, so the matrix needn't fit in memory
+Text_conversion_status convert_text_matrix (std::istream& text, std::ostream& binary);
+
+} // namespace math
@@ -0,0 +1,68 @@
+#include <cstdint>
+#include <gauss/matrix.hpp>
+#include <new>
+
+#if defined(__linux__)
+#define MATRIX_HUGE_PAGES 1
+#include <sys/mman.h>
+#else
+#define MATRIX_HUGE_PAGES 0
+#endif
+
+namespace math {
+namespace detail {
+
+#if MATRIX_HUGE_PAGES
+namespace {
+constexpr size_t huge_page_size = size_t(2) << 20;
+
+// An anonymous mapping trimmed to start on a huge page boundary, or nullptr
+void* map_huge_pages (size_t bytes)
+{
+	const size_t size = (bytes + huge_page_size-1) / huge_page_size * huge_page_size;
+	void* const mapped = mmap(nullptr, size + huge_page_size, PROT_READ | PROT_WRITE,
+			MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (mapped == MAP_FAILED)
+		return nullptr;
+
+	const auto addr = reinterpret_cast<std::uintptr_t>(mapped);
+	const size_t head = (huge_page_size - addr % huge_page_size) % huge_page_size;
+	char* const begin = static_cast<char*>(mapped) + head;
+	if (head > 0)
+		munmap(mapped, head);
+	munmap(begin + size, huge_page_size - head);
+	// Only a hint: without transparent huge pages, this is ordinary memory
+	madvise(begin, size, MADV_HUGEPAGE);
+	return begin;
+}
+} // namespace
+#endif
+
+void* allocate_matrix_memory
+(size_t bytes, size_t alignment, [[maybe_unused]] size_t huge_pages_from, bool& huge_pages)
+{
+	huge_pages = false;
+#if MATRIX_HUGE_PAGES
+	if (bytes >= huge_pages_from && alignment <= huge_page_size) {
+		if (void* const memory = map_huge_pages(bytes)) {
+			huge_pages = true;
+			return memory;
+		}
+	}
+#endif
+	return ::operator new(bytes, std::align_val_t(alignment));
+}
+
+void free_matrix_memory (void* ptr, size_t bytes, size_t alignment, [[maybe_unused]] bool huge_pages) noexcept
+{
+#if MATRIX_HUGE_PAGES
+	if (huge_pages) {
+		munmap(ptr, (bytes + huge_page_size-1) / huge_page_size * huge_page_size);
+		return;
+	}
+#endif
+	::operator delete(ptr, bytes, std::align_val_t(alignment));
+}
+
+} // namespace detail
+} // namespace math
@@ -1,51 +1,125 @@
 #pragma once
 
 #include <algorithm>
+#include <bit>
 #include <memory>
 #include <span>
+#include <util/thread-pool.hpp>
 #include <util/util.hpp>
 
 namespace math {
 // All matrices are presumed row-major. Triangular means upper triangular.
 
+// Splitting work on fewer matrix elements than this between threads is not worth the barrier
+constexpr size_t parallel_min_elements = 1 << 14;
+
+template <typename T> class Matrix_tiles;
+
 template <typename T> class Matrix_view {
 	T* ptr_;
 	size_t rows_, cols_, stride_;
 
 	template <typename E> friend class Matrix;
+	template <typename E> friend class Matrix_view;
 
 	using Row_reference = std::span<T>;
 
+	// Random access, so that rows can be split between threads and fed to standard algorithms.
+	// Dereferencing makes a span, so there is no real reference to return: the iterator category
+	// of the old standard library requirements is only input, but the C++20 concept is met
 	class Row_iterator {
-		T* ptr_;
-		size_t cols_, stride_;
+		T* ptr_ = nullptr;
+		size_t cols_ = 0, stride_ = 0;
 
 	public:
-		using iterator_category = std::bidirectional_iterator_tag;
+		using iterator_concept = std::random_access_iterator_tag;
+		using iterator_category = std::input_iterator_tag;
 		using difference_type = ptrdiff_t;
 		using value_type = Row_reference;
 		using reference = Row_reference;
 		using size_type = size_t;
 
+		Row_iterator () = default;
 		Row_iterator (T* ptr, size_t cols, size_t stride)
 			: ptr_{ptr}, cols_{cols}, stride_{stride} {}
 		Row_iterator (const Row_iterator&) = default;
+		Row_iterator& operator= (const Row_iterator&) = default;
 
 		Row_iterator& operator++ () { ptr_ += stride_; return *this; }
 		Row_iterator& operator-- () { ptr_ -= stride_; return *this; }
+		Row_iterator operator++ (int) { auto old = *this; ++*this; return old; }
+		Row_iterator operator-- (int) { auto old = *this; --*this; return old; }
+
+		Row_iterator& operator+= (ptrdiff_t n) { ptr_ += n * ptrdiff_t(stride_); return *this; }
+		Row_iterator& operator-= (ptrdiff_t n) { ptr_ -= n * ptrdiff_t(stride_); return *this; }
+		friend Row_iterator operator+ (Row_iterator it, ptrdiff_t n) { return it += n; }
+		friend Row_iterator operator+ (ptrdiff_t n, Row_iterator it) { return it += n; }
+		friend Row_iterator operator- (Row_iterator it, ptrdiff_t n) { return it -= n; }
 
 		Row_reference operator* () const { return { ptr_, cols_ }; }
+		Row_reference operator[] (ptrdiff_t n) const { return *(*this + n); }
 
 		bool operator== (const Row_iterator& lhs) const { return this->ptr_ == lhs.ptr_; }
+		auto operator<=> (const Row_iterator& lhs) const { return this->ptr_ <=> lhs.ptr_; }
 
 		ptrdiff_t operator- (const Row_iterator lhs) const {
 			assert(this->cols_ == lhs.cols_ && this->stride_ == lhs.stride_);
 			ptrdiff_t dist = this->ptr_ - lhs.ptr_;
-			assert(dist % stride_ == 0);
-			return dist / stride_;
+			assert(dist % ptrdiff_t(stride_) == 0);
+			return dist / ptrdiff_t(stride_);
 		}
 	};
 
+	// One column, `stride` elements apart in memory
+	class Column_view {
+		T* ptr_;
+		size_t size_, stride_;
+
+	public:
+		using element_type = T;
+
+		class iterator {
+			T* ptr_ = nullptr;
+			size_t stride_ = 0;
+
+		public:
+			using iterator_concept = std::random_access_iterator_tag;
+			using iterator_category = std::random_access_iterator_tag;
+			using difference_type = ptrdiff_t;
+			using value_type = std::remove_cv_t<T>;
+			using reference = T&;
+			using pointer = T*;
+
+			iterator () = default;
+			iterator (T* ptr, size_t stride): ptr_{ptr}, stride_{stride} {}
+
+			iterator& operator++ () { ptr_ += stride_; return *this; }
+			iterator& operator-- () { ptr_ -= stride_; return *this; }
+			iterator operator++ (int) { auto old = *this; ++*this; return old; }
+			iterator operator-- (int) { auto old = *this; --*this; return old; }
+
+			iterator& operator+= (ptrdiff_t n) { ptr_ += n * ptrdiff_t(stride_); return *this; }
+			iterator& operator-= (ptrdiff_t n) { ptr_ -= n * ptrdiff_t(stride_); return *this; }
+			friend iterator operator+ (iterator it, ptrdiff_t n) { return it += n; }
+			friend iterator operator+ (ptrdiff_t n, iterator it) { return it += n; }
+			friend iterator operator- (iterator it, ptrdiff_t n) { return it -= n; }
+			ptrdiff_t operator- (const iterator& lhs) const { return (ptr_ - lhs.ptr_) / ptrdiff_t(stride_); }
+
+			T& operator* () const { return *ptr_; }
+			T& operator[] (ptrdiff_t n) const { return *(*this + n); }
+
+			bool operator== (const iterator& lhs) const { return ptr_ == lhs.ptr_; }
+			auto operator<=> (const iterator& lhs) const { return ptr_ <=> lhs.ptr_; }
+		};
+
+		Column_view (T* ptr, size_t size, size_t stride): ptr_{ptr}, size_{size}, stride_{stride} {}
+
+		[[nodiscard]] size_t size () const { return size_; }
+		T& operator[] (size_t i) const { assert(i < size_); return ptr_[i * stride_]; }
+		iterator begin () const { return { ptr_, stride_ }; }
+		iterator end () const { return { ptr_ + size_ * stride_, stride_ }; }
+	};
+
 public:
 	[[nodiscard]] size_t rows () const { return rows_; }
 	[[nodiscard]] size_t cols () const { return cols_; }
@@ -58,8 +132,14 @@ public:
 	Matrix_view& operator= (Matrix_view&&) noexcept = default;
 	Matrix_view& operator= (const Matrix_view&) = default;
 
+	// Matrix_view<T> -> Matrix_view<const T>
+	template <typename E> requires std::is_convertible_v<E*, T*>
+	Matrix_view (const Matrix_view<E>& lhs)
+		: ptr_{lhs.ptr_}, rows_{lhs.rows_}, cols_{lhs.cols_}, stride_{lhs.stride_} {}
+
 	using row_ref = Row_reference;
 	using iterator = Row_iterator;
+	using column_ref = Column_view;
 
 	row_ref operator[] (size_t row) const {
 		assert(row < rows_);
@@ -74,14 +154,94 @@ public:
 		assert(start_row + rows <= rows_ && start_col + cols <= cols_);
 		return Matrix_view { ptr_ + start_row * stride_ + start_col, rows, cols, stride_ };
 	}
+
+	Column_view column (size_t col) const {
+		assert(col < cols_);
+		return { ptr_ + col, rows_, stride_ };
+	}
+
+	// The matrix cut into blocks of `tile_rows` by `tile_cols`
+	Matrix_tiles<T> tiles (size_t tile_rows, size_t tile_cols) const {
+		return { *this, tile_rows, tile_cols };
+	}
+};
+
+// A block of a matrix and where it starts
+template <typename T> struct Matrix_tile {
+	size_t row, col;
+	Matrix_view<T> view;
+};
+
+// The blocks of a matrix, row of blocks by row of blocks. The blocks at the bottom and right
+// edges are smaller when the sizes don't divide evenly
+template <typename T> class Matrix_tiles {
+	Matrix_view<T> mat_;
+	size_t tile_rows_, tile_cols_, tiles_per_row_, size_;
+
+public:
+	class iterator {
+		const Matrix_tiles* tiles_ = nullptr;
+		size_t index_ = 0;
+
+	public:
+		using iterator_concept = std::random_access_iterator_tag;
+		using iterator_category = std::input_iterator_tag;
+		using difference_type = ptrdiff_t;
+		using value_type = Matrix_tile<T>;
+		using reference = Matrix_tile<T>;
+
+		iterator () = default;
+		iterator (const Matrix_tiles* tiles, size_t index): tiles_{tiles}, index_{index} {}
+
+		iterator& operator++ () { index_++; return *this; }
+		iterator& operator-- () { index_--; return *this; }
+		iterator operator++ (int) { auto old = *this; ++*this; return old; }
+		iterator operator-- (int) { auto old = *this; --*this; return old; }
+
+		iterator& operator+= (ptrdiff_t n) { index_ += n; return *this; }
+		iterator& operator-= (ptrdiff_t n) { index_ -= n; return *this; }
+		friend iterator operator+ (iterator it, ptrdiff_t n) { return it += n; }
+		friend iterator operator+ (ptrdiff_t n, iterator it) { return it += n; }
+		friend iterator operator- (iterator it, ptrdiff_t n) { return it -= n; }
+		ptrdiff_t operator- (const iterator& lhs) const { return ptrdiff_t(index_ - lhs.index_); }
+
+		Matrix_tile<T> operator* () const { return (*tiles_)[index_]; }
+		Matrix_tile<T> operator[] (ptrdiff_t n) const { return *(*this + n); }
+
+		bool operator== (const iterator& lhs) const { return index_ == lhs.index_; }
+		auto operator<=> (const iterator& lhs) const { return index_ <=> lhs.index_; }
+	};
+
+	Matrix_tiles (Matrix_view<T> mat, size_t tile_rows, size_t tile_cols)
+		: mat_{mat}, tile_rows_{tile_rows}, tile_cols_{tile_cols},
+		  tiles_per_row_{(mat.cols() + tile_cols-1) / tile_cols},
+		  size_{(mat.rows() + tile_rows-1) / tile_rows * tiles_per_row_}
+	{
+		assert(tile_rows > 0 && tile_cols > 0);
+	}
+
+	[[nodiscard]] size_t size () const { return size_; }
+	Matrix_tile<T> operator[] (size_t i) const {
+		assert(i < size_);
+		const size_t row = i / tiles_per_row_ * tile_rows_, col = i % tiles_per_row_ * tile_cols_;
+		const size_t rows = std::min(tile_rows_, mat_.rows() - row);
+		const size_t cols = std::min(tile_cols_, mat_.cols() - col);
+		return { row, col, mat_.subview(row, col, rows, cols) };
+	}
+	iterator begin () const { return { this, 0 }; }
+	iterator end () const { return { this, size_ }; }
 };
 
 template <typename T, size_t Rows, size_t Cols> class Static_matrix {
-	T storage[Rows * Cols];
+	T storage[Rows * Cols] {};
 public:
 	[[nodiscard]] constexpr size_t rows () const { return Rows; }
 	[[nodiscard]] constexpr size_t cols () const { return Cols; }
 
+	// Element access that is usable in constant expressions, unlike the views
+	constexpr T& operator() (size_t row, size_t col) { return storage[row * Cols + col]; }
+	constexpr const T& operator() (size_t row, size_t col) const { return storage[row * Cols + col]; }
+
 	operator Matrix_view<const T> () const { return { storage, Rows, Cols, Cols }; }
 	operator Matrix_view<T> () { return { storage, Rows, Cols, Cols }; }
 
@@ -97,38 +257,108 @@ public:
 	}
 };
 
+// How a Matrix allocates its elements
+struct Matrix_allocation {
+	// Every row starts at a multiple of this many bytes (a power of two), so rows begin on
+	// a cache line and vector loads of a row line up the same way in every row
+	size_t alignment = 64;
+	// Rows that are a multiple of a page long map to the same cache sets, which makes column
+	// accesses thrash the cache; such rows get one more alignment unit of padding
+	bool pad_stride = true;
+	// Allocations of at least this many bytes are backed by transparent huge pages where
+	// the system has them, which saves TLB misses when the whole matrix is traversed
+	size_t huge_pages_from = size_t(32) << 20;
+
+	// Rows right after each other, with no padding, e.g. for matrices of a few elements per row
+	static constexpr Matrix_allocation packed () { return { 1, false, size_t(-1) }; }
+};
+
+namespace detail {
+// Memory for matrix elements, aligned to `alignment` bytes. On return, `huge_pages` tells
+// whether huge pages back it; free_matrix_memory() needs that and the same size and alignment
+void* allocate_matrix_memory (size_t bytes, size_t alignment, size_t huge_pages_from, bool& huge_pages);
+void free_matrix_memory (void* ptr, size_t bytes, size_t alignment, bool huge_pages) noexcept;
+
+template <typename T> struct Matrix_deleter {
+	size_t count = 0, alignment = 0;
+	bool huge_pages = false;
+
+	void operator() (T* ptr) const noexcept
+	{
+		std::destroy_n(ptr, count);
+		free_matrix_memory(ptr, count * sizeof(T), alignment, huge_pages);
+	}
+};
+} // namespace detail
+
+// The distance between rows of a `cols` wide Matrix allocated with `allocation`
+template <typename T> size_t matrix_stride (size_t cols, const Matrix_allocation& allocation)
+{
+	assert(std::has_single_bit(allocation.alignment));
+	const size_t unit = allocation.alignment % sizeof(T) == 0 ? allocation.alignment / sizeof(T) : 1;
+	size_t stride = (cols + unit-1) / unit * unit;
+	constexpr size_t page_size = 4096;
+	if (allocation.pad_stride && stride > 0 && stride * sizeof(T) % page_size == 0)
+		stride += unit;
+	return stride;
+}
+
 template <typename T> class Matrix {
-	size_t rows_, cols_;
-	std::unique_ptr<T[]> storage;
+	size_t rows_, cols_, stride_;
+	Matrix_allocation allocation_;
+	using Storage = std::unique_ptr<T, detail::Matrix_deleter<T>>;
+	Storage storage;
+
+	static Storage allocate (size_t count, const Matrix_allocation& allocation)
+	{
+		const size_t alignment = std::max(allocation.alignment, alignof(T));
+		bool huge_pages;
+		void* const memory = detail::allocate_matrix_memory(count * sizeof(T), alignment,
+				allocation.huge_pages_from, huge_pages);
+		std::uninitialized_default_construct_n(static_cast<T*>(memory), count);
+		return { static_cast<T*>(memory), { count, alignment, huge_pages } };
+	}
+
+	template <typename E> void copy_rows (const Matrix_view<E>& lhs)
+	{
+		for (size_t row = 0; row < rows_; row++)
+			std::copy_n(lhs.ptr_ + row * lhs.stride_, cols_, storage.get() + row * stride_);
+	}
+
 public:
 	[[nodiscard]] size_t rows () const { return rows_; }
 	[[nodiscard]] size_t cols () const { return cols_; }
+	[[nodiscard]] size_t stride () const { return stride_; }
+	[[nodiscard]] const Matrix_allocation& allocation () const { return allocation_; }
 
-	Matrix (size_t rows, size_t cols)
-		: rows_{rows}, cols_{cols}, storage{ new T[rows * cols] } {}
+	// The elements are left uninitialized
+	Matrix (size_t rows, size_t cols, const Matrix_allocation& allocation = {})
+		: rows_{rows}, cols_{cols}, stride_{matrix_stride<T>(cols, allocation)}, allocation_{allocation},
+		  storage{ allocate(rows * stride_, allocation) } {}
+
+	Matrix (size_t rows, size_t cols, const T& fill, const Matrix_allocation& allocation = {})
+		: Matrix(rows, cols, allocation)
+	{
+		std::fill_n(storage.get(), rows_ * stride_, fill);
+	}
 
 	Matrix (Matrix&&) noexcept = default;
-	Matrix (const Matrix& lhs): Matrix(lhs.rows(), lhs.cols()) {
-		std::copy_n(lhs.storage.get(), rows_ * cols_, this->storage.get());
+	Matrix (const Matrix& lhs): Matrix(lhs.rows(), lhs.cols(), lhs.allocation()) {
+		copy_rows(Matrix_view<const T>(lhs));
 	}
 
+	Matrix& operator= (Matrix&&) noexcept = default;
+	Matrix& operator= (const Matrix& lhs) { return *this = Matrix(lhs); }
+
 	template <typename E>
-	explicit Matrix (const Matrix_view<E>& lhs): Matrix(lhs.rows(), lhs.cols()) {
-		T* const d = this->storage.get();
-		E* const s = lhs.ptr_;
-		if (lhs.stride_ == cols_) {
-			std::copy_n(s, cols_ * rows_, d);
-		} else {
-			for (size_t row = 0; row < rows_; row++) {
-				T* const dst = d + row * cols_;
-				E* const src = s + row * lhs.stride_;
-				std::copy_n(src, cols_, dst);
-			}
-		}
+	explicit Matrix (const Matrix_view<E>& lhs, const Matrix_allocation& allocation = {})
+		: Matrix(lhs.rows(), lhs.cols(), allocation)
+	{
+		copy_rows(lhs);
 	}
 
-	operator Matrix_view<const T> () const { return { storage.get(), rows_, cols_, cols_ }; }
-	operator Matrix_view<T> () { return { storage.get(), rows_, cols_, cols_ }; }
+	operator Matrix_view<const T> () const { return { storage.get(), rows_, cols_, stride_ }; }
+	operator Matrix_view<T> () { return { storage.get(), rows_, cols_, stride_ }; }
 
 	decltype(auto) operator[] (size_t row) { return Matrix_view<T>{*this}[row]; }
 	decltype(auto) operator[] (size_t row) const { return Matrix_view<const T>{*this}[row]; }
@@ -141,4 +371,16 @@ public:
 		return Matrix_view<const T>{*this}.subview(start_row, start_col, rows, cols);
 	}
 };
+// `dest` and `src` must be of the same size. Rows are split between up to `threads` threads
+template <typename T> void copy_matrix
+(Matrix_view<T> dest, Matrix_view<const std::type_identity_t<T>> src, unsigned threads = 1)
+{
+	assert(dest.rows() == src.rows() && dest.cols() == src.cols());
+	const size_t min_rows_per_thread = 1 + parallel_min_elements / std::max<size_t>(src.cols(), 1);
+	parallel_for(src.begin(), src.end(), threads, min_rows_per_thread, [&] (auto begin, auto end) {
+		auto out = dest.begin() + (begin - src.begin());
+		for (auto row = begin; row != end; ++row, ++out)
+			std::ranges::copy(*row, (*out).begin());
+	});
+}
 } // namespace math
\ No newline at end of file
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <cassert>
+#include <concepts>
+#include <cstdint>
+#include <gauss/kernels.hpp>
+#include <utility>
+
+// Arithmetic modulo a prime, as a number type for the templated solvers: eliminating modulo p
+// has no rounding, so it is exact, and several primes are recombined into the exact rational
+// solution (see exact.hpp).
+// The prime is set per thread by a Modulus_scope, so that every thread can work with its own
+// without every element carrying it around
+
+namespace math {
+
+class Mod_p {
+	std::uint32_t value = 0; // in [0, modulus())
+
+	static inline thread_local std::uint32_t current_modulus = 0;
+
+	static Mod_p from_residue (std::uint32_t residue)
+	{
+		Mod_p result;
+		result.value = residue;
+		return result;
+	}
+
+public:
+	// The primes must be below this, so that sums of two residues fit in 32 bits
+	constexpr static std::uint32_t max_modulus = std::uint32_t(1) << 31;
+
+	// Sets the modulus for the current thread while it exists. Values are only meaningful
+	// under the modulus they were made with
+	class Modulus_scope {
+		std::uint32_t saved;
+	public:
+		explicit Modulus_scope (std::uint32_t p): saved(current_modulus)
+		{
+			assert(p > 1 && p < max_modulus);
+			current_modulus = p;
+		}
+		~Modulus_scope () { current_modulus = saved; }
+		Modulus_scope (const Modulus_scope&) = delete;
+		Modulus_scope& operator= (const Modulus_scope&) = delete;
+	};
+
+	[[nodiscard]] static std::uint32_t modulus () { return current_modulus; }
+
+	Mod_p () = default;
+	template <std::integral I> Mod_p (I x)
+	{
+		const std::uint32_t p = modulus();
+		assert(p > 1);
+		if constexpr (std::is_signed_v<I>) {
+			const auto r = static_cast<std::int64_t>(x) % std::int64_t(p);
+			value = std::uint32_t(r < 0 ? r + p : r);
+		} else {
+			value = std::uint32_t(static_cast<std::uint64_t>(x) % p);
+		}
+	}
+
+	[[nodiscard]] std::uint32_t residue () const { return value; }
+
+	friend bool operator== (Mod_p, Mod_p) = default;
+
+	friend Mod_p operator+ (Mod_p a, Mod_p b)
+	{
+		const std::uint32_t sum = a.value + b.value;
+		return from_residue(sum >= modulus() ? sum - modulus() : sum);
+	}
+	friend Mod_p operator- (Mod_p a, Mod_p b)
+	{
+		return from_residue(a.value >= b.value ? a.value - b.value : a.value + modulus() - b.value);
+	}
+	Mod_p operator- () const { return from_residue(value == 0 ? 0 : modulus() - value); }
+	friend Mod_p operator* (Mod_p a, Mod_p b)
+	{
+		return from_residue(std::uint32_t(std::uint64_t(a.value) * b.value % modulus()));
+	}
+	friend Mod_p operator/ (Mod_p a, Mod_p b) { return a * inverse(b); }
+
+	Mod_p& operator+= (Mod_p b) { return *this = *this + b; }
+	Mod_p& operator-= (Mod_p b) { return *this = *this - b; }
+	Mod_p& operator*= (Mod_p b) { return *this = *this * b; }
+	Mod_p& operator/= (Mod_p b) { return *this = *this / b; }
+
+	// By the extended Euclidean algorithm; `a` must not be zero
+	friend Mod_p inverse (Mod_p a)
+	{
+		assert(a.value != 0);
+		std::int64_t r0 = modulus(), r1 = a.value, t0 = 0, t1 = 1;
+		while (r1 != 0) {
+			const std::int64_t q = r0 / r1;
+			r0 -= q * r1;
+			std::swap(r0, r1);
+			t0 -= q * t1;
+			std::swap(t0, t1);
+		}
+		return from_residue(std::uint32_t(t0 < 0 ? t0 + modulus() : t0));
+	}
+
+	// Residues have no magnitude. This is only for gauss_triangulate_pivoting(), which then
+	// picks the largest residue as the main element: in exact arithmetic any nonzero one will do
+	friend std::uint32_t abs (Mod_p a) { return a.value; }
+};
+
+// Vectorized in kernels.cpp
+template <> void axpy<Mod_p> (std::span<Mod_p>, Mod_p, std::span<const Mod_p>);
+
+} // namespace math
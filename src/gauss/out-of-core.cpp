@@ -0,0 +1,366 @@
+#include <future>
+#include <gauss/out-of-core.hpp>
+#include <gauss/solve.hpp>
+#include <optional>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define OUT_OF_CORE_PREAD 1
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#define OUT_OF_CORE_PREAD 0
+#endif
+
+namespace math {
+namespace {
+
+#if OUT_OF_CORE_PREAD
+// A file descriptor, read and written at explicit offsets, so that several threads can use it
+class File {
+	int fd = -1;
+
+public:
+	explicit File (int fd_): fd{fd_} {}
+	File (File&& lhs) noexcept: fd{std::exchange(lhs.fd, -1)} {}
+	File& operator= (File&&) = delete;
+	~File () { if (fd >= 0) close(fd); }
+
+	bool valid () const { return fd >= 0; }
+
+	std::optional<size_t> size () const
+	{
+		struct stat file_stat;
+		if (fstat(fd, &file_stat) != 0)
+			return {};
+		return file_stat.st_size;
+	}
+
+	bool resize (size_t bytes) const { return ftruncate(fd, bytes) == 0; }
+
+	bool read (void* dest, size_t bytes, size_t offset) const
+	{
+		char* p = static_cast<char*>(dest);
+		while (bytes > 0) {
+			const ssize_t got = pread(fd, p, bytes, offset);
+			if (got <= 0)
+				return false;
+			p += got, offset += got, bytes -= got;
+		}
+		return true;
+	}
+
+	bool write (const void* src, size_t bytes, size_t offset) const
+	{
+		const char* p = static_cast<const char*>(src);
+		while (bytes > 0) {
+			const ssize_t put = pwrite(fd, p, bytes, offset);
+			if (put <= 0)
+				return false;
+			p += put, offset += put, bytes -= put;
+		}
+		return true;
+	}
+};
+#endif
+
+// The main element of gauss_triangulate() at row `equ`, column `var`
+struct Pivot {
+	size_t equ, var;
+};
+
+// A permutation of the columns [begin, begin + order.size()): column begin+i receives
+// what was in column begin+order[i]
+struct Column_permutation {
+	size_t begin;
+	std::vector<size_t> order;
+};
+
+// A strip of whole rows, [begin, end) of the matrix, in memory
+struct Strip {
+	std::vector<double> data;
+	size_t begin = 0, end = 0;
+	size_t stride = 0, cols = 0;
+
+	size_t rows () const { return end - begin; }
+	Matrix_view<double> view () { return { data.data(), rows(), cols, stride }; }
+};
+
+// The column permutations strips have to catch up with, in order
+void permute_columns (Strip& strip, std::span<const Column_permutation> permutations)
+{
+	std::vector<double> reordered;
+	for (const auto& p: permutations) {
+		reordered.resize(p.order.size());
+		for (auto row: strip.view()) {
+			for (size_t i = 0; i < p.order.size(); i++)
+				reordered[i] = row[p.begin + p.order[i]];
+			std::copy(reordered.begin(), reordered.end(), row.begin() + p.begin);
+		}
+	}
+}
+
+// Apply the eliminations of gauss_triangulate() with the `pivots` (which are all in `main`,
+// and have consecutive variables) to the rows of `target`, which come after them.
+// Each element gets the same operations in the same order as in gauss_triangulate(),
+// but the rows of `main` are reused from cache for many target rows
+void eliminate (Strip& target, Strip& main, std::span<const Pivot> pivots, unsigned threads)
+{
+	if (pivots.empty())
+		return;
+	const size_t cols = target.cols;
+	const size_t var_end = pivots.back().var + 1;
+	assert(var_end - pivots.front().var == pivots.size());
+
+	// Tiles of this many main rows by this many columns should stay in L2
+	constexpr size_t pivot_block = 64;
+	constexpr size_t tile_bytes = 256 << 10;
+	constexpr size_t tile_cols = tile_bytes / sizeof(double) / pivot_block;
+
+	auto mat = target.view();
+	auto main_mat = main.view();
+	const auto main_row = [&] (const Pivot& p) { return main_mat[p.equ - main.begin]; };
+
+	const size_t min_rows_per_thread = 1 + parallel_min_elements / (pivots.size() * cols);
+	parallel_for(0, mat.rows(), threads, min_rows_per_thread, [&] (size_t begin, size_t end) {
+		// The left elements of the eliminations, [row - begin][pivot]
+		std::vector<double> left(pivots.size() * (end - begin));
+
+		// Columns of the pivots first: the left elements depend on them
+		for (size_t row = begin; row < end; row++) {
+			auto r = mat[row];
+			double* const row_left = &left[(row - begin) * pivots.size()];
+			for (size_t k = 0; k < pivots.size(); k++) {
+				const auto [equ, var] = pivots[k];
+				const auto m = main_row(pivots[k]);
+				const double left_element = r[var];
+				row_left[k] = left_element;
+				for (size_t col = var+1; col < var_end; col++)
+					r[col] -= (left_element * m[col]) / m[var];
+				r[var] = 0;
+			}
+		}
+
+		// The rest, tile by tile
+		for (size_t col0 = var_end; col0 < cols; col0 += tile_cols) {
+			const size_t col1 = std::min(cols, col0 + tile_cols);
+			for (size_t k0 = 0; k0 < pivots.size(); k0 += pivot_block) {
+				const size_t k1 = std::min(pivots.size(), k0 + pivot_block);
+				for (size_t row = begin; row < end; row++) {
+					double* const r = mat[row].data();
+					const double* const row_left = &left[(row - begin) * pivots.size()];
+					for (size_t k = k0; k < k1; k++) {
+						const auto m = main_row(pivots[k]);
+						const double left_element = row_left[k];
+						const double main_element = m[pivots[k].var];
+						for (size_t col = col0; col < col1; col++)
+							r[col] -= (left_element * m[col]) / main_element;
+					}
+				}
+			}
+		}
+	});
+}
+
+} // namespace
+
+Out_of_core_result out_of_core_solve (const char* source_path, const char* work_path,
+		const Out_of_core_settings& settings)
+{
+	Out_of_core_result result;
+#if OUT_OF_CORE_PREAD
+	const auto fail = [&] (Out_of_core_status status) {
+		result = {};
+		result.status = status;
+		return result;
+	};
+
+	const File source(::open(source_path, O_RDONLY | O_CLOEXEC));
+	Matrix_file_header header;
+	if (!source.valid() || !source.read(&header, sizeof(header), 0)
+	|| !valid_matrix_file_header(header, source.size().value_or(0))
+	|| header.rows == 0 || header.cols < 2)
+		return fail(Out_of_core_status::unreadable);
+
+	const size_t rows = header.rows, cols = header.cols, stride = header.stride;
+	const size_t num_variables = cols-1;
+	const size_t row_bytes = stride * sizeof(double);
+
+	// The strip being triangulated, the one before it, and two for streaming the earlier ones
+	constexpr size_t num_buffers = 4;
+	const size_t strip_rows = std::min(rows, settings.memory_limit / num_buffers / row_bytes);
+	if (strip_rows == 0)
+		return fail(Out_of_core_status::too_little_memory);
+	const size_t num_strips = (rows + strip_rows-1) / strip_rows;
+
+	const File work(::open(work_path, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644));
+	const auto work_header = make_matrix_file_header(rows, cols, stride);
+	if (!work.valid() || !work.write(&work_header, sizeof(work_header), 0)
+	|| !work.resize(work_header.data_offset + rows * row_bytes))
+		return fail(Out_of_core_status::unwritable);
+
+	std::vector<Strip> buffers(num_buffers);
+	for (Strip& strip: buffers) {
+		strip.data.resize(strip_rows * stride);
+		strip.stride = stride;
+		strip.cols = cols;
+	}
+
+	// Rows past the last one may lack their padding
+	const auto strip_elements = [&] (const Strip& strip) { return (strip.rows()-1) * stride + cols; };
+	const auto read_strip = [&] (const File& file, Strip& strip, size_t s) {
+		strip.begin = s * strip_rows;
+		strip.end = std::min(rows, strip.begin + strip_rows);
+		const size_t data_offset = &file == &source ? header.data_offset : work_header.data_offset;
+		return file.read(strip.data.data(), strip_elements(strip) * sizeof(double),
+				data_offset + strip.begin * row_bytes);
+	};
+	const auto write_strip = [&] (const Strip& strip) {
+		return work.write(strip.data.data(), strip_elements(strip) * sizeof(double),
+				work_header.data_offset + strip.begin * row_bytes);
+	};
+	const auto read_async = [&] (const File& file, Strip& strip, size_t s) {
+		return std::async(std::launch::async, read_strip, std::cref(file), std::ref(strip), s);
+	};
+
+	result.permute_variables.resize(num_variables);
+	for (size_t i = 0; i < num_variables; i++)
+		result.permute_variables[i] = i;
+
+	// The column swaps of gauss_triangulate() reach every row. Strips catch up with them
+	// when they are next read: `permutations_applied[s]` of them are in strip `s` in `work`
+	std::vector<Column_permutation> permutations;
+	std::vector<size_t> permutations_applied(num_strips);
+	std::vector<std::vector<Pivot>> pivots(num_strips);
+
+	// ======================= First step: gauss_triangulate() =======================
+	{
+		Strip* current = &buffers[0];
+		Strip* previous = &buffers[1];
+		std::future<bool> previous_written;
+		size_t var = 0;
+
+		for (size_t s = 0; s < num_strips; s++) {
+			auto current_read = read_async(source, *current, s);
+
+			// The earlier strips with main elements, except the previous one, which is in memory
+			std::vector<size_t> streamed;
+			for (size_t p = 0; p+1 < s; p++) {
+				if (!pivots[p].empty())
+					streamed.push_back(p);
+			}
+			std::future<bool> next_read;
+			if (!streamed.empty())
+				next_read = read_async(work, buffers[2], streamed[0]);
+
+			if (!current_read.get())
+				return fail(Out_of_core_status::unreadable);
+			permute_columns(*current, permutations);
+
+			for (size_t i = 0; i < streamed.size(); i++) {
+				if (!next_read.get())
+					return fail(Out_of_core_status::unreadable);
+				Strip& main = buffers[2 + i%2];
+				if (i+1 < streamed.size())
+					next_read = read_async(work, buffers[2 + (i+1)%2], streamed[i+1]);
+				permute_columns(main, std::span(permutations).subspan(permutations_applied[streamed[i]]));
+				eliminate(*current, main, pivots[streamed[i]], settings.threads);
+			}
+			if (s > 0)
+				eliminate(*current, *previous, pivots[s-1], settings.threads);
+
+			// The rows of the strip itself. Having all the eliminations above, they are zero
+			// left of `var`, so gauss_triangulate() can take it from there
+			if (var < num_variables) {
+				const size_t var_begin = var;
+				auto rest = current->view().subview(0, var_begin, current->rows(), cols - var_begin);
+				std::vector<size_t> order(num_variables - var_begin);
+				const unsigned swaps = gauss_triangulate(rest, std::span(order));
+				if (swaps > 0) {
+					result.permutations += swaps;
+					const std::vector<size_t> old(result.permute_variables.begin() + var_begin,
+							result.permute_variables.end());
+					for (size_t i = 0; i < order.size(); i++)
+						result.permute_variables[var_begin + i] = old[order[i]];
+					permutations.push_back({ var_begin, std::move(order) });
+				}
+
+				// Rows skipped for lack of a nonzero main element are all zero from `var` on
+				auto mat = current->view();
+				for (size_t row = 0; row < mat.rows() && var < num_variables; row++) {
+					if (mat[row][var] != 0)
+						pivots[s].push_back({ current->begin + row, var++ });
+				}
+			}
+			permutations_applied[s] = permutations.size();
+
+			if (previous_written.valid() && !previous_written.get())
+				return fail(Out_of_core_status::unwritable);
+			std::swap(current, previous);
+			previous_written = std::async(std::launch::async, write_strip, std::cref(*previous));
+		}
+		if (!previous_written.get())
+			return fail(Out_of_core_status::unwritable);
+	}
+
+	// ======================= Second step: gauss_gather() =======================
+	// Bottom to top, for back substitution. The strips also catch up with the last column swaps
+	bool no_solution = false;
+	bool zero_diagonal = false;
+	bool substituting = rows >= num_variables;
+	result.raw_solution.resize(num_variables);
+	auto& x = result.raw_solution;
+
+	std::future<bool> next_read = read_async(work, buffers[0], num_strips-1);
+	for (size_t i = 0; i < num_strips; i++) {
+		const size_t s = num_strips-1 - i;
+		if (!next_read.get())
+			return fail(Out_of_core_status::unreadable);
+		Strip& strip = buffers[i%2];
+		if (s > 0)
+			next_read = read_async(work, buffers[(i+1)%2], s-1);
+
+		const auto outstanding = std::span(permutations).subspan(permutations_applied[s]);
+		if (!outstanding.empty()) {
+			permute_columns(strip, outstanding);
+			if (!write_strip(strip))
+				return fail(Out_of_core_status::unwritable);
+		}
+
+		auto mat = strip.view();
+		for (size_t row = mat.rows()-1; row != size_t(-1); row--) {
+			auto r = mat[row];
+			// "0*x1 + 0*x2 + ... = <nonzero>" -> no solution
+			if (r.back() != 0 && std::all_of(r.begin(), r.end()-1, [] (double v) { return v == 0; }))
+				no_solution = true;
+
+			const size_t equ = strip.begin + row;
+			if (!substituting || equ >= num_variables)
+				continue;
+			if (r[equ] == 0) {
+				zero_diagonal = true;
+				substituting = false;
+				continue;
+			}
+			double coef = r[cols-1];
+			for (size_t j = equ+1; j < num_variables; j++)
+				coef -= r[j] * x[j];
+			x[equ] = coef / r[equ];
+		}
+	}
+
+	if (no_solution)
+		result.classification = -1;
+	else if (rows < num_variables)
+		result.classification = num_variables - rows;
+	else
+		result.classification = zero_diagonal ? 1 : 0;
+	return result;
+#else
+	(void)source_path, (void)work_path, (void)settings;
+	result.status = Out_of_core_status::unreadable; // no pread()
+	return result;
+#endif
+}
+
+} // namespace math
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <gauss/matrix-file.hpp>
+#include <vector>
+
+// The Gauss method for matrices that don't fit in memory. The matrix is read from a matrix
+// file (see matrix-file.hpp) in strips of whole rows, and no more than a set amount of memory
+// holds strips at any time. Reading the next strip overlaps with work on the current one.
+//
+// Every element receives the same operations, in the same order, as gauss_triangulate()
+// and gauss_gather() would apply to it, so the results are identical to theirs.
+
+namespace math {
+
+struct Out_of_core_settings {
+	size_t memory_limit = size_t(1) << 30; // in bytes, for the strips in memory
+	unsigned threads = 1;
+};
+
+enum class Out_of_core_status { ok, unreadable, unwritable, too_little_memory };
+
+struct Out_of_core_result {
+	Out_of_core_status status = Out_of_core_status::ok;
+	// The rest is only set when the status is ok, and means the same as for
+	// gauss_triangulate() and gauss_gather()
+	unsigned permutations = 0;
+	std::vector<size_t> permute_variables;
+	int classification = 0;
+	std::vector<double> raw_solution;
+};
+
+// Both steps of the Gauss method for the matrix in the matrix file `source`.
+// The triangulated matrix is written to the matrix file `work`, which is created or replaced
+Out_of_core_result out_of_core_solve (const char* source, const char* work, const Out_of_core_settings&);
+
+} // namespace math
@@ -0,0 +1,132 @@
+#pragma once
+
+#include <cmath>
+#include <gauss/kernels.hpp>
+#include <gauss/matrix.hpp>
+#include <gauss/solve.hpp>
+#include <limits>
+#include <vector>
+
+// Least squares solutions of overdetermined systems A*x ~ b by Householder QR.
+// QR of the augmented matrix [A | b] gives R = [R_A, c; 0, rho] with R_A*x = c the least squares
+// solution and |rho| = |b - A*x| its residual norm, so Q is never formed.
+//
+// Rows are stored contiguously, so rather than going column by column over the whole matrix,
+// R is built up from blocks of rows small enough to stay in cache: each block is folded into
+// R by the QR factorization of [R; block], and every row of the matrix is read once.
+// Chunks of rows are folded into R's of their own in parallel, which are then folded together
+
+namespace math {
+
+namespace detail {
+// Rows per block folded into R, and per chunk given to a thread
+constexpr size_t qr_block_rows = 256;
+constexpr size_t qr_chunk_rows = size_t(1) << 15;
+
+// Replace the upper triangular `r` with the R of the QR factorization of [r; block],
+// by Householder reflections that skip the zeros under the diagonal of `r`.
+// The block is given transposed, so that its columns are contiguous: row k of `block_t`
+// is column k of the block. It is destroyed
+template <typename T> void qr_fold_rows (Matrix_view<T> r, Matrix_view<T> block_t)
+{
+	using std::sqrt;
+	const size_t n = r.cols();
+	assert(r.rows() == n && block_t.rows() == n);
+
+	for (size_t j = 0; j < n; j++) {
+		const auto v = block_t[j];
+		const T norm2 = dot(std::span<const T>(v), std::span<const T>(v));
+		if (norm2 == 0)
+			continue;
+
+		// The reflection I - tau*(1, v)*(1, v)^T, with v scaled by 1 / (alpha - beta),
+		// takes (alpha, v) to (beta, 0)
+		const T alpha = r[j][j];
+		const T beta = alpha >= 0 ? -sqrt(alpha*alpha + norm2) : sqrt(alpha*alpha + norm2);
+		const T tau = (beta - alpha) / beta;
+		const T scale = T(1) / (alpha - beta);
+		for (T& value: v)
+			value *= scale;
+		r[j][j] = beta;
+
+		for (size_t k = j+1; k < n; k++) {
+			const T w = r[j][k] + dot(std::span<const T>(v), std::span<const T>(block_t[k]));
+			r[j][k] -= tau * w;
+			axpy(block_t[k], -tau * w, std::span<const T>(v));
+		}
+	}
+}
+
+// Copy `src` transposed into the top left corner of `dest`, and return that part of it
+template <typename T> Matrix_view<T> transpose_into (Matrix_view<T> dest, Matrix_view<const T> src)
+{
+	const auto result = dest.subview(0, 0, src.cols(), src.rows());
+	for (size_t i = 0; i < src.rows(); i++) {
+		for (size_t j = 0; j < src.cols(); j++)
+			result[j][i] = src[i][j];
+	}
+	return result;
+}
+} // namespace detail
+
+struct Least_squares_result {
+	// The columns of A are linearly dependent (as far as rounding can tell),
+	// so the least squares solution is not unique and `x` is meaningless
+	bool rank_deficient = false;
+	double residual_norm = 0; // |b - A*x| in the 2-norm
+};
+
+// Find `x` minimizing |b - A*x| for the augmented matrix `system` = [A | b],
+// with at least as many equations as variables.
+// The results don't depend on the number of threads
+template <typename T> Least_squares_result least_squares_solve
+(std::span<T> x, Matrix_view<const std::type_identity_t<T>> system, unsigned threads = 1)
+{
+	using std::abs;
+	const size_t cols = system.cols(), n = cols-1;
+	assert(cols > 1 && system.rows() >= n && x.size() == n);
+
+	const size_t chunks = (system.rows() + detail::qr_chunk_rows-1) / detail::qr_chunk_rows;
+	Matrix<T> rs(chunks * cols, cols, 0);
+
+	parallel_for(0, chunks, threads, 1, [&] (size_t begin, size_t end) {
+		Matrix<T> block_t(cols, detail::qr_block_rows);
+		for (size_t chunk = begin; chunk < end; chunk++) {
+			const auto r = Matrix_view<T>(rs).subview(chunk * cols, 0, cols, cols);
+			const size_t chunk_end = std::min(system.rows(), (chunk+1) * detail::qr_chunk_rows);
+			const size_t chunk_begin = chunk * detail::qr_chunk_rows;
+			for (size_t row0 = chunk_begin; row0 < chunk_end; row0 += detail::qr_block_rows) {
+				const size_t rows = std::min(detail::qr_block_rows, chunk_end - row0);
+				detail::qr_fold_rows(r, detail::transpose_into(Matrix_view<T>(block_t),
+						system.subview(row0, 0, rows, cols)));
+			}
+		}
+	});
+
+	const auto r = Matrix_view<T>(rs).subview(0, 0, cols, cols);
+	Matrix<T> r_t(cols, cols);
+	for (size_t chunk = 1; chunk < chunks; chunk++) {
+		const Matrix_view<const T> chunk_r = Matrix_view<T>(rs).subview(chunk * cols, 0, cols, cols);
+		detail::qr_fold_rows(r, detail::transpose_into(Matrix_view<T>(r_t), chunk_r));
+	}
+
+	Least_squares_result result;
+	T max_diagonal = 0;
+	for (size_t i = 0; i < n; i++)
+		max_diagonal = std::max(max_diagonal, abs(r[i][i]));
+	const T tolerance = T(system.rows()) * std::numeric_limits<T>::epsilon() * max_diagonal;
+	for (size_t i = 0; i < n; i++)
+		result.rank_deficient |= !(abs(r[i][i]) > tolerance);
+	if (result.rank_deficient)
+		return result;
+
+	for (size_t i = n-1; i != size_t(-1); i--) {
+		const auto known = std::span<const T>(x.subspan(i+1));
+		const T sum = dot(std::span<const T>(r[i].subspan(i+1, n-i-1)), known);
+		x[i] = (r[i][n] - sum) / r[i][i];
+	}
+	result.residual_norm = double(abs(r[n][n]));
+	return result;
+}
+
+} // namespace math
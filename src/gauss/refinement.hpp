@@ -0,0 +1,107 @@
+#pragma once
+
+#include <cmath>
+#include <gauss/expression.hpp>
+#include <gauss/lu.hpp>
+#include <limits>
+#include <vector>
+
+// Mixed-precision solving: the O(n^3) factorization is done in a lower precision, which is
+// about twice as fast and moves half the data, then the O(n^2) iterative refinement steps
+// recover the accuracy of the full precision
+
+namespace math {
+
+struct Refinement_settings {
+	size_t max_steps = 30;
+	// Every step must shrink the residual at least this many times, or refinement has stalled
+	double min_reduction = 2;
+};
+
+struct Refinement_result {
+	bool singular = false; // in the full precision; `x` is meaningless then
+	size_t steps = 0;      // of refinement, before it converged or was given up on
+	bool fell_back = false; // the matrix was factored in the full precision after all
+	// The max-norm of the residual b - A*x of the initial solution, then after every step
+	std::vector<double> residual_history;
+};
+
+// Solve the square system A*x = b. A is factored in the precision of `Low`, and `x` is refined
+// in the precision of T until the residual is as small as a backward stable solve in T leaves
+// it: |b - A*x| <= sqrt(n) * epsilon * |A| * |x| in max-norms, the same test as LAPACK's dsgesv.
+// If A is singular in `Low`, or refinement stalls or runs out of steps, A is factored in T
+template <typename Low, typename T> Refinement_result mixed_precision_solve
+(Matrix_view<const T> a, std::span<T> x, std::span<const std::type_identity_t<T>> b,
+ const Refinement_settings& settings = {}, unsigned threads = 1)
+{
+	const size_t n = a.rows();
+	assert(a.cols() == n && x.size() == n && b.size() == n && n > 0);
+	using std::abs, std::sqrt;
+
+	Refinement_result result;
+	const auto max_norm = [] (std::span<const T> v) {
+		T norm = 0;
+		for (const T& value: v)
+			norm = std::max(norm, abs(value));
+		return norm;
+	};
+
+	T a_norm = 0;
+	Matrix<Low> a_low(n, n);
+	for (size_t row = 0; row < n; row++) {
+		T row_sum = 0;
+		for (size_t col = 0; col < n; col++) {
+			row_sum += abs(a[row][col]);
+			a_low[row][col] = static_cast<Low>(a[row][col]);
+		}
+		a_norm = std::max(a_norm, row_sum);
+	}
+	const T tolerance_factor = sqrt(T(n)) * std::numeric_limits<T>::epsilon() * a_norm;
+
+	const auto fall_back = [&] {
+		result.fell_back = true;
+		const Lu_factorization<T> lu(a, default_lu_block_size, threads);
+		result.singular = lu.singular();
+		if (!result.singular)
+			lu.solve(x, b);
+		return result;
+	};
+
+	// Overflow in `Low` makes no sense to refine
+	if (!std::isfinite(double(a_norm)) || a_norm > T(std::numeric_limits<Low>::max()))
+		return fall_back();
+
+	const Lu_factorization<Low> lu(std::move(a_low), default_lu_block_size, threads);
+	if (lu.singular())
+		return fall_back();
+
+	std::vector<T> residual(b.begin(), b.end());
+	std::vector<Low> residual_low(n), correction(n);
+	std::fill(x.begin(), x.end(), T(0));
+
+	while (true) {
+		// Scaled, so that small residuals don't underflow in `Low`
+		const T residual_norm = max_norm(residual);
+		result.residual_history.push_back(double(residual_norm));
+		if (residual_norm <= tolerance_factor * max_norm(x))
+			return result;
+		if (!std::isfinite(double(residual_norm)) || result.steps == settings.max_steps)
+			return fall_back();
+		if (result.steps > 0) {
+			const double previous = result.residual_history[result.residual_history.size()-2];
+			if (double(residual_norm) * settings.min_reduction > previous)
+				return fall_back();
+		}
+
+		for (size_t i = 0; i < n; i++)
+			residual_low[i] = static_cast<Low>(residual[i] / residual_norm);
+		lu.solve(std::span(correction), std::span<const Low>(residual_low));
+		for (size_t i = 0; i < n; i++)
+			x[i] += T(correction[i]) * residual_norm;
+		result.steps++;
+
+		evaluate(std::span(residual), lazy(b) - lazy(a) * lazy(x), threads);
+	}
+}
+
+} // namespace math
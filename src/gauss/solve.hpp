@@ -1,84 +1,155 @@
 #pragma once
 
+#include <gauss/kernels.hpp>
 #include <gauss/matrix.hpp>
+#include <util/thread-pool.hpp>
 
 namespace math {
 
-// First step of the Gauss method: attempt to triangulate a matrix.
-// `dest` and `src` must not overlap.
-// The variables may be permuted if there are zeros on the main diagonal.
+// First step of the Gauss method: attempt to triangulate a matrix, in place.
+// The variables may be permuted if there are zeros on the main diagonal;
+// the columns of `mat` are swapped accordingly.
 // The order of permutation will be written to `permute_variables`
 // Returns: the number of swaps made between variables
-template <typename T> unsigned gauss_triangulate
-(Matrix_view<T> dest, Matrix_view<const T> src, std::span<size_t> permute_variables)
+template <typename T> unsigned gauss_triangulate (Matrix_view<T> mat, std::span<size_t> permute_variables)
 {
-	assert(src.cols() > 1 && src.rows() > 0);
-	assert(src.rows() == dest.rows() && src.cols() == dest.cols());
+	assert(mat.cols() > 1 && mat.rows() > 0);
 
 	unsigned permutations = 0;
 
-	const size_t num_equations = src.rows();
-	const size_t num_variables = src.cols()-1;
+	const size_t num_equations = mat.rows();
+	const size_t num_variables = mat.cols()-1;
 	assert(permute_variables.size() == num_variables);
 
 	for (size_t i = 0; i < num_variables; i++)
 		permute_variables[i] = i;
 
-	// Top row is unchanged
-	for (size_t i = 0; i < src.cols(); i++)
-		dest[0][i] = src[0][i];
-
-	Matrix<T> tmp(src);
-
 	for (size_t equ = 0, var = 0; equ < num_equations && var < num_variables; equ++) {
-		auto tmp_row = tmp[equ];
+		auto main_row = mat[equ];
 
 		{ // Find a nonzero main element
 			size_t nonzero = var;
-			while (nonzero < num_variables && tmp_row[permute_variables[nonzero]] == 0)
+			while (nonzero < num_variables && main_row[nonzero] == 0)
 				nonzero++;
 			if (nonzero == num_variables)
 				continue;
 			if (nonzero != var) {
+				std::ranges::swap_ranges(mat.column(nonzero), mat.column(var));
 				std::swap(permute_variables[nonzero], permute_variables[var]);
 				permutations++;
 			}
 		}
 
-		size_t main_var_id = permute_variables[var];
-		T main_element = tmp_row[main_var_id];
+		T main_element = main_row[var];
 		assert(main_element != 0);
 
 		for (size_t nequ = equ+1; nequ < num_equations; nequ++) {
-			auto nrow = tmp[nequ];
-			T& left_element = nrow[main_var_id];
-
-			const auto apply = [&] (size_t var_id) {
-				nrow[var_id] -= (left_element * tmp_row[var_id]) / main_element;
-			};
-
-			for (size_t nvar = var+1; nvar < num_variables; nvar++)
-				apply(permute_variables[nvar]);
-			apply(num_variables);
-
+			auto nrow = mat[nequ];
+			T& left_element = nrow[var];
+			for (size_t col = var+1; col < mat.cols(); col++)
+				nrow[col] -= (left_element * main_row[col]) / main_element;
 			left_element = 0;
 		}
 
 		var++;
 	}
 
-	for (size_t equ = 0; equ < num_equations; equ++) {
-		auto tmp_row = tmp[equ];
-		auto dest_row = dest[equ];
-		for (size_t var = 0; var < num_variables; var++)
-			dest_row[var] = tmp_row[permute_variables[var]];
-		dest_row[num_variables] = tmp_row[num_variables];
+	return permutations;
+}
+
+// Same as above, but the input is left intact.
+// `dest` and `src` must not overlap.
+template <typename T> unsigned gauss_triangulate
+(Matrix_view<T> dest, Matrix_view<const T> src, std::span<size_t> permute_variables)
+{
+	copy_matrix(dest, src);
+	return gauss_triangulate(dest, permute_variables);
+}
+
+
+// Same as gauss_triangulate(), but with partial pivoting: the element of the largest
+// magnitude in the column is chosen as the main one, and rows are swapped physically
+// to bring it onto the diagonal, so the elimination only walks contiguous rows.
+// Variables are only permuted (also physically) when the rest of a column is all zeros.
+// The original index of each equation will be written to `permute_equations`.
+// The rows below the main one are updated by up to `threads` threads; the result does
+// not depend on their number.
+// Returns: the number of swaps made, between equations and between variables
+template <typename T> unsigned gauss_triangulate_pivoting
+(Matrix_view<T> mat, std::span<size_t> permute_equations, std::span<size_t> permute_variables,
+ unsigned threads = 1)
+{
+	assert(mat.cols() > 1 && mat.rows() > 0);
+
+	unsigned permutations = 0;
+
+	const size_t num_equations = mat.rows();
+	const size_t num_variables = mat.cols()-1;
+	assert(permute_equations.size() == num_equations);
+	assert(permute_variables.size() == num_variables);
+
+	for (size_t i = 0; i < num_equations; i++)
+		permute_equations[i] = i;
+	for (size_t i = 0; i < num_variables; i++)
+		permute_variables[i] = i;
+
+	using std::abs;
+	for (size_t var = 0; var < num_equations && var < num_variables; var++) {
+		size_t main_row = var;
+		size_t main_col = var;
+
+		{ // Find the first column with a nonzero element, and the largest element in it
+			const auto by_magnitude = [] (const T& a, const T& b) { return abs(a) < abs(b); };
+			for (; main_col < num_variables; main_col++) {
+				const auto column = mat.column(main_col);
+				const auto largest = std::max_element(column.begin() + var, column.end(), by_magnitude);
+				main_row = largest - column.begin();
+				if (column[main_row] != 0)
+					break;
+			}
+			if (main_col == num_variables)
+				break; // Only zero coefficients are left
+		}
+
+		if (main_col != var) {
+			std::ranges::swap_ranges(mat.column(main_col), mat.column(var));
+			std::swap(permute_variables[main_col], permute_variables[var]);
+			permutations++;
+		}
+		if (main_row != var) {
+			std::swap_ranges(mat[var].begin(), mat[var].end(), mat[main_row].begin());
+			std::swap(permute_equations[main_row], permute_equations[var]);
+			permutations++;
+		}
+
+		auto main_row_ref = mat[var];
+		const T inv_main_element = T(1) / main_row_ref[var];
+		const size_t min_rows_per_thread = 1 + parallel_min_elements / mat.cols();
+		parallel_for(var+1, num_equations, threads, min_rows_per_thread, [&] (size_t begin, size_t end) {
+			for (size_t row = begin; row < end; row++) {
+				auto target = mat[row];
+				const T multiplier = target[var] * inv_main_element;
+				axpy(target.subspan(var+1), -multiplier, main_row_ref.subspan(var+1));
+				target[var] = 0;
+			}
+		});
 	}
 
 	return permutations;
 }
 
 
+// Same as above, but the input is left intact.
+// `dest` and `src` must not overlap.
+template <typename T> unsigned gauss_triangulate_pivoting
+(Matrix_view<T> dest, Matrix_view<const T> src,
+ std::span<size_t> permute_equations, std::span<size_t> permute_variables, unsigned threads = 1)
+{
+	copy_matrix(dest, src, threads);
+	return gauss_triangulate_pivoting(dest, permute_equations, permute_variables, threads);
+}
+
+
 // Second step of the Gauss method: gather solutions from a triangulated matrix.
 // `mat` must be triangular already.
 //
@@ -100,10 +171,8 @@ template <typename T> int gauss_gather (std::span<T> raw_solution, Matrix_view<T
 	// "0*x1 + 0*x2 + ... = <nonzero>" -> no solution
 	for (size_t i = 0; i < num_equations; i++) {
 		if (auto row = mat[i]; row.back() != 0) {
-			size_t j = i; // nonzero coefficients can only be left of the diagonal, inclusive
-			while (j < num_variables && row[j] == 0)
-				j++;
-			if (j == num_variables)
+			// Rows past the last variable have no diagonal element, so scan the whole row
+			if (std::all_of(row.begin(), row.end()-1, [] (const T& x) { return x == 0; }))
 				return -1;
 		}
 	}
@@ -114,7 +183,7 @@ template <typename T> int gauss_gather (std::span<T> raw_solution, Matrix_view<T
 	} else if (num_equations > num_variables) {
 		// The matrix being triangular, all the extra equations have zero coefficients.
 		// We've already checked that their free coefficient is also zero, so just ignore them
-		mat = mat.subview(0, 0, mat.cols(), mat.cols()-1);
+		mat = mat.subview(0, 0, num_variables, mat.cols());
 		num_equations = num_variables;
 	}
 
@@ -135,29 +204,46 @@ template <typename T> int gauss_gather (std::span<T> raw_solution, Matrix_view<T
 
 // The determinant of a triangular matrix (product of main diagonal)
 // `mat` must be square
-template <typename T> T triangular_determinant (Matrix_view<T> mat)
+template <typename T> std::remove_const_t<T> triangular_determinant (Matrix_view<T> mat)
 {
 	assert(mat.rows() == mat.cols());
 	assert(mat.rows() > 0);
-	T result = 1;
+	std::remove_const_t<T> result = 1;
 	for (size_t i = 0; i < mat.rows(); i++)
 		result *= mat[i][i];
 	return result;
 }
 
-// Multiply a matrix with a vector.
+// Multiply a matrix with a vector, splitting the rows between up to `threads` threads.
 // The dimensions must be appropriate for the multiplication to make sense.
 // `dest` and `vec` must not overlap
-template <typename T>
-void mul_matrix_vector (std::span<T> dest, Matrix_view<T> mat, std::span<T> vec)
+template <typename T> void mul_matrix_vector
+(std::span<T> dest, Matrix_view<const std::type_identity_t<T>> mat,
+ std::span<const std::type_identity_t<T>> vec, unsigned threads = 1)
 {
 	assert(mat.rows() == dest.size());
 	assert(mat.cols() == vec.size());
-	for (size_t i = 0; i < mat.rows(); i++) {
-		dest[i] = 0;
-		for (size_t j = 0; j < mat.cols(); j++)
-			dest[i] += mat[i][j] * vec[j];
-	}
+	const size_t min_rows_per_thread = 1 + parallel_min_elements / std::max<size_t>(mat.cols(), 1);
+	parallel_for(mat.begin(), mat.end(), threads, min_rows_per_thread, [&] (auto begin, auto end) {
+		std::transform(begin, end, dest.begin() + (begin - mat.begin()),
+				[&] (std::span<const T> row) { return dot(row, vec); });
+	});
+}
+
+// The residual A*x - b of `solution` to the system given as the augmented matrix [A | b],
+// the rows split between up to `threads` threads
+template <typename T> void residual
+(std::span<T> dest, Matrix_view<const std::type_identity_t<T>> system,
+ std::span<const std::type_identity_t<T>> solution, unsigned threads = 1)
+{
+	assert(system.rows() == dest.size());
+	assert(system.cols() == solution.size() + 1);
+	const size_t min_rows_per_thread = 1 + parallel_min_elements / system.cols();
+	parallel_for(system.begin(), system.end(), threads, min_rows_per_thread, [&] (auto begin, auto end) {
+		std::transform(begin, end, dest.begin() + (begin - system.begin()), [&] (std::span<const T> row) {
+			return dot(row.first(solution.size()), solution) - row.back();
+		});
+	});
 }
 
 } // namespace math
\ No newline at end of file
@@ -0,0 +1,64 @@
+#include <cctype>
+#include <gauss/sparse.hpp>
+#include <sstream>
+#include <string>
+
+namespace math {
+
+std::optional<Csr_matrix<double>> load_matrix_market (std::istream& in)
+{
+	std::string line;
+	if (!std::getline(in, line))
+		return {};
+
+	std::string banner, object, format, field, symmetry;
+	std::istringstream(line) >> banner >> object >> format >> field >> symmetry;
+	for (std::string* word: { &object, &format, &field, &symmetry })
+		std::transform(word->begin(), word->end(), word->begin(), [] (unsigned char c) { return std::tolower(c); });
+
+	if (banner != "%%MatrixMarket" || object != "matrix" || format != "coordinate")
+		return {};
+	const bool pattern = field == "pattern";
+	if (!pattern && field != "real" && field != "integer")
+		return {};
+	const bool symmetric = symmetry == "symmetric";
+	const bool skew = symmetry == "skew-symmetric";
+	if (!symmetric && !skew && symmetry != "general")
+		return {};
+
+	// Comments and blank lines are allowed before the size line
+	while (std::getline(in, line)) {
+		if (line.find_first_not_of(" \t\r") != std::string::npos && line[0] != '%')
+			break;
+	}
+	size_t rows, cols, entries;
+	if (!(std::istringstream(line) >> rows >> cols >> entries))
+		return {};
+	if ((symmetric || skew) && rows != cols)
+		return {};
+	// Every element is listed once at most
+	if (entries > 0 && (rows == 0 || (entries - 1) / rows >= cols))
+		return {};
+
+	// The count is only trusted as far as reading the entries goes, so that a corrupt one
+	// doesn't allocate everything up front
+	constexpr size_t max_reserved = size_t(1) << 20;
+	std::vector<Csr_matrix<double>::Triplet> triplets;
+	triplets.reserve(std::min(symmetric || skew ? 2*entries : entries, max_reserved));
+	for (size_t i = 0; i < entries; i++) {
+		size_t row, col;
+		double value = 1;
+		if (!(in >> row >> col) || (!pattern && !(in >> value)))
+			return {};
+		if (row == 0 || col == 0 || row > rows || col > cols)
+			return {};
+		row--, col--;
+		triplets.push_back({ row, col, value });
+		if ((symmetric || skew) && row != col)
+			triplets.push_back({ col, row, skew ? -value : value });
+	}
+
+	return Csr_matrix<double>::from_triplets(rows, cols, std::move(triplets));
+}
+
+} // namespace math
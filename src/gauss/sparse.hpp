@@ -0,0 +1,437 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <gauss/matrix.hpp>
+#include <istream>
+#include <optional>
+#include <span>
+#include <vector>
+
+namespace math {
+
+// Compressed sparse row matrix: only the nonzero elements are stored, row after row.
+// The CSR form of the transpose is the CSC (compressed sparse column) form of the original,
+// see transposed().
+template <typename T> struct Csr_matrix {
+	size_t rows = 0;
+	size_t cols = 0;
+	std::vector<size_t> row_start { 0 }; // row `r` is [row_start[r], row_start[r+1])
+	std::vector<size_t> col_index;       // increasing within each row
+	std::vector<T> values;
+
+	struct Triplet { size_t row, col; T value; };
+
+	[[nodiscard]] size_t nonzeros () const { return values.size(); }
+
+	std::span<const size_t> row_cols (size_t row) const {
+		assert(row < rows);
+		return std::span(col_index).subspan(row_start[row], row_start[row+1] - row_start[row]);
+	}
+	std::span<const T> row_values (size_t row) const {
+		assert(row < rows);
+		return std::span(values).subspan(row_start[row], row_start[row+1] - row_start[row]);
+	}
+
+	T at (size_t row, size_t col) const {
+		const auto cs = row_cols(row);
+		const auto it = std::lower_bound(cs.begin(), cs.end(), col);
+		return (it != cs.end() && *it == col) ? row_values(row)[it - cs.begin()] : T(0);
+	}
+
+	// Duplicate entries are summed, zeros are dropped
+	static Csr_matrix from_triplets (size_t rows, size_t cols, std::vector<Triplet> triplets)
+	{
+		std::sort(triplets.begin(), triplets.end(), [] (const Triplet& a, const Triplet& b) {
+			return a.row != b.row ? a.row < b.row : a.col < b.col;
+		});
+
+		Csr_matrix result;
+		result.rows = rows;
+		result.cols = cols;
+		result.row_start.assign(rows+1, 0);
+		for (size_t i = 0; i < triplets.size(); ) {
+			const auto [row, col, first_value] = triplets[i];
+			assert(row < rows && col < cols);
+			T value = first_value;
+			for (i++; i < triplets.size() && triplets[i].row == row && triplets[i].col == col; i++)
+				value += triplets[i].value;
+			if (value == 0)
+				continue;
+			result.col_index.push_back(col);
+			result.values.push_back(value);
+			result.row_start[row+1]++;
+		}
+		for (size_t row = 0; row < rows; row++)
+			result.row_start[row+1] += result.row_start[row];
+		return result;
+	}
+
+	static Csr_matrix from_dense (Matrix_view<const T> mat)
+	{
+		Csr_matrix result;
+		result.rows = mat.rows();
+		result.cols = mat.cols();
+		result.row_start.reserve(mat.rows()+1);
+		for (auto row: mat) {
+			for (size_t col = 0; col < row.size(); col++) {
+				if (row[col] != 0) {
+					result.col_index.push_back(col);
+					result.values.push_back(row[col]);
+				}
+			}
+			result.row_start.push_back(result.values.size());
+		}
+		return result;
+	}
+
+	void to_dense (Matrix_view<T> dest) const
+	{
+		assert(dest.rows() == rows && dest.cols() == cols);
+		for (size_t row = 0; row < rows; row++) {
+			std::fill(dest[row].begin(), dest[row].end(), T(0));
+			const auto cs = row_cols(row);
+			const auto vs = row_values(row);
+			for (size_t i = 0; i < cs.size(); i++)
+				dest[row][cs[i]] = vs[i];
+		}
+	}
+
+	Csr_matrix transposed () const
+	{
+		Csr_matrix result;
+		result.rows = cols;
+		result.cols = rows;
+		result.row_start.assign(cols+1, 0);
+		for (size_t col: col_index)
+			result.row_start[col+1]++;
+		for (size_t col = 0; col < cols; col++)
+			result.row_start[col+1] += result.row_start[col];
+
+		result.col_index.resize(nonzeros());
+		result.values.resize(nonzeros());
+		std::vector<size_t> next(result.row_start.begin(), result.row_start.end()-1);
+		for (size_t row = 0; row < rows; row++) {
+			for (size_t i = row_start[row]; i < row_start[row+1]; i++) {
+				const size_t at = next[col_index[i]]++;
+				result.col_index[at] = row;
+				result.values[at] = values[i];
+			}
+		}
+		return result;
+	}
+
+	// The first `n` columns, e.g. the coefficients of an augmented matrix
+	Csr_matrix leading_columns (size_t n) const
+	{
+		assert(n <= cols);
+		Csr_matrix result;
+		result.rows = rows;
+		result.cols = n;
+		result.row_start.reserve(rows+1);
+		for (size_t row = 0; row < rows; row++) {
+			const auto cs = row_cols(row);
+			const auto vs = row_values(row);
+			for (size_t i = 0; i < cs.size() && cs[i] < n; i++) {
+				result.col_index.push_back(cs[i]);
+				result.values.push_back(vs[i]);
+			}
+			result.row_start.push_back(result.values.size());
+		}
+		return result;
+	}
+
+	void column (std::span<T> dest, size_t col) const
+	{
+		assert(dest.size() == rows);
+		for (size_t row = 0; row < rows; row++)
+			dest[row] = at(row, col);
+	}
+};
+
+// Multiply a sparse matrix with a vector.
+// `dest` and `vec` must not overlap
+template <typename T> void mul_matrix_vector
+(std::span<T> dest, const Csr_matrix<std::type_identity_t<T>>& mat,
+ std::span<const std::type_identity_t<T>> vec)
+{
+	assert(mat.rows == dest.size());
+	assert(mat.cols == vec.size());
+	for (size_t row = 0; row < mat.rows; row++) {
+		const auto cs = mat.row_cols(row);
+		const auto vs = mat.row_values(row);
+		T sum = 0;
+		for (size_t i = 0; i < cs.size(); i++)
+			sum += vs[i] * vec[cs[i]];
+		dest[row] = sum;
+	}
+}
+
+// Read a matrix in the Matrix Market coordinate format:
+// real, integer or pattern values; general, symmetric or skew-symmetric storage.
+// Returns nothing if the data is malformed or not supported
+std::optional<Csr_matrix<double>> load_matrix_market (std::istream&);
+
+// The largest distance of a nonzero element from the main diagonal,
+// after reordering rows and columns symmetrically: new index i is old index order[i]
+template <typename T> size_t bandwidth (const Csr_matrix<T>& mat, std::span<const size_t> order)
+{
+	assert(mat.rows == mat.cols && order.size() == mat.rows);
+	std::vector<size_t> new_index(order.size());
+	for (size_t i = 0; i < order.size(); i++)
+		new_index[order[i]] = i;
+
+	size_t result = 0;
+	for (size_t row = 0; row < mat.rows; row++) {
+		for (size_t col: mat.row_cols(row)) {
+			const size_t r = new_index[row], c = new_index[col];
+			result = std::max(result, r > c ? r-c : c-r);
+		}
+	}
+	return result;
+}
+
+// Reverse Cuthill-McKee ordering of the pattern of A + A^T.
+// Brings the nonzeros close to the diagonal, which limits fill-in during LU factorization.
+// New index i is old index result[i]
+template <typename T> std::vector<size_t> reverse_cuthill_mckee (const Csr_matrix<T>& mat)
+{
+	assert(mat.rows == mat.cols);
+	const size_t n = mat.rows;
+
+	// Adjacency of the symmetrized pattern, without the diagonal
+	std::vector<std::vector<size_t>> adjacent(n);
+	for (size_t row = 0; row < n; row++) {
+		for (size_t col: mat.row_cols(row)) {
+			if (col != row) {
+				adjacent[row].push_back(col);
+				adjacent[col].push_back(row);
+			}
+		}
+	}
+	for (auto& list: adjacent) {
+		std::sort(list.begin(), list.end());
+		list.erase(std::unique(list.begin(), list.end()), list.end());
+	}
+
+	const auto by_degree = [&] (size_t a, size_t b) {
+		return adjacent[a].size() != adjacent[b].size() ? adjacent[a].size() < adjacent[b].size() : a < b;
+	};
+
+	std::vector<size_t> nodes_by_degree(n);
+	for (size_t i = 0; i < n; i++)
+		nodes_by_degree[i] = i;
+	std::sort(nodes_by_degree.begin(), nodes_by_degree.end(), by_degree);
+
+	std::vector<size_t> order;
+	order.reserve(n);
+	std::vector<bool> visited(n, false);
+
+	// Breadth-first search from a node of the lowest degree in every connected component
+	for (size_t start: nodes_by_degree) {
+		if (visited[start])
+			continue;
+		visited[start] = true;
+		order.push_back(start);
+		// `order` doubles as the queue
+		for (size_t head = order.size()-1; head < order.size(); head++) {
+			const size_t neighbours_begin = order.size();
+			for (size_t next: adjacent[order[head]]) {
+				if (!visited[next]) {
+					visited[next] = true;
+					order.push_back(next);
+				}
+			}
+			std::sort(order.begin() + neighbours_begin, order.end(), by_degree);
+		}
+	}
+
+	std::reverse(order.begin(), order.end());
+	return order;
+}
+
+// LU factorization of a square sparse matrix, storing only the nonzeros of the factors.
+// Rows and columns are first reordered symmetrically with reverse Cuthill-McKee.
+// Among the candidates for the main element in a column, those that are at least a tenth
+// of the largest in magnitude are chosen by the fewest nonzeros in their row,
+// which keeps the fill-in low without giving up numerical stability.
+template <typename T> class Sparse_lu {
+	struct Entry {
+		size_t col;
+		T value;
+	};
+
+	size_t n;
+	std::vector<size_t> order;     // new index i is old index order[i], for rows and columns
+	std::vector<size_t> pivot_row; // the (reordered) row that became the main one at step k
+	std::vector<std::vector<Entry>> upper; // row k of U; the first entry is the diagonal
+	std::vector<std::vector<Entry>> lower; // multipliers applied to row k of U, by step
+	size_t factored = 0;
+
+	// Main element candidates must be at least this many times smaller than the largest one
+	constexpr static unsigned pivot_threshold = 10;
+
+	// this - multiplier * other, for the entries past the first one of both
+	static std::vector<Entry> eliminate
+	(const std::vector<Entry>& target, T multiplier, const std::vector<Entry>& other,
+	 std::vector<size_t>& fill)
+	{
+		std::vector<Entry> result;
+		result.reserve(target.size() + other.size());
+		auto t = target.begin() + 1, o = other.begin() + 1;
+		while (t != target.end() || o != other.end()) {
+			if (o == other.end() || (t != target.end() && t->col < o->col)) {
+				result.push_back(*t++);
+			} else if (t == target.end() || o->col < t->col) {
+				fill.push_back(o->col);
+				result.push_back({ o->col, -multiplier * o->value });
+				o++;
+			} else {
+				result.push_back({ t->col, t->value - multiplier * o->value });
+				t++, o++;
+			}
+		}
+		return result;
+	}
+
+public:
+	explicit Sparse_lu (const Csr_matrix<T>& a, bool reorder = true)
+		: n{a.rows}, pivot_row(a.rows), upper(a.rows), lower(a.rows)
+	{
+		assert(a.rows == a.cols);
+
+		if (reorder) {
+			order = reverse_cuthill_mckee(a);
+		} else {
+			order.resize(n);
+			for (size_t i = 0; i < n; i++)
+				order[i] = i;
+		}
+		std::vector<size_t> new_index(n);
+		for (size_t i = 0; i < n; i++)
+			new_index[order[i]] = i;
+
+		// Rows not yet used as the main one, in the reordered numbering
+		std::vector<std::vector<Entry>> rows(n);
+		std::vector<std::vector<Entry>> multipliers(n);
+		std::vector<std::vector<size_t>> rows_in_col(n);
+		for (size_t row = 0; row < n; row++) {
+			auto& r = rows[row];
+			const size_t old_row = order[row];
+			const auto cs = a.row_cols(old_row);
+			const auto vs = a.row_values(old_row);
+			for (size_t i = 0; i < cs.size(); i++)
+				r.push_back({ new_index[cs[i]], vs[i] });
+			std::sort(r.begin(), r.end(), [] (const Entry& x, const Entry& y) { return x.col < y.col; });
+			for (const Entry& e: r)
+				rows_in_col[e.col].push_back(row);
+		}
+
+		std::vector<bool> used(n, false);
+		std::vector<size_t> fill;
+
+		using std::abs;
+		for (size_t k = 0; k < n; k++) {
+			// Every unused row with a nonzero in column k has it as its first entry
+			auto& candidates = rows_in_col[k];
+			std::erase_if(candidates, [&] (size_t row) { return used[row]; });
+
+			T max_abs = 0;
+			for (size_t row: candidates)
+				max_abs = std::max<T>(max_abs, abs(rows[row].front().value));
+			if (max_abs == 0)
+				return; // singular
+
+			size_t main = n;
+			for (size_t row: candidates) {
+				if (abs(rows[row].front().value) * T(pivot_threshold) >= max_abs
+				&& (main == n || rows[row].size() < rows[main].size()))
+					main = row;
+			}
+
+			used[main] = true;
+			pivot_row[k] = main;
+			upper[k] = std::move(rows[main]);
+			lower[k] = std::move(multipliers[main]);
+
+			const T inv_main_element = T(1) / upper[k].front().value;
+			for (size_t row: candidates) {
+				if (row == main)
+					continue;
+				const T multiplier = rows[row].front().value * inv_main_element;
+				multipliers[row].push_back({ k, multiplier });
+				fill.clear();
+				rows[row] = eliminate(rows[row], multiplier, upper[k], fill);
+				for (size_t col: fill)
+					rows_in_col[col].push_back(row);
+			}
+			std::vector<size_t>().swap(candidates);
+			factored = k+1;
+		}
+	}
+
+	[[nodiscard]] size_t size () const { return n; }
+
+	// The matrix has no unique inverse; solve() must not be called then
+	[[nodiscard]] bool singular () const { return factored < n; }
+
+	// Nonzeros stored in L and U together
+	[[nodiscard]] size_t factor_nonzeros () const
+	{
+		size_t result = 0;
+		for (size_t k = 0; k < factored; k++)
+			result += upper[k].size() + lower[k].size();
+		return result;
+	}
+
+	[[nodiscard]] std::span<const size_t> ordering () const { return order; }
+
+	[[nodiscard]] T determinant () const
+	{
+		if (singular())
+			return 0;
+		T result = 1;
+		for (size_t k = 0; k < n; k++)
+			result *= upper[k].front().value;
+
+		// The sign of the row permutation, by its cycles
+		std::vector<bool> seen(n, false);
+		for (size_t start = 0; start < n; start++) {
+			if (seen[start])
+				continue;
+			size_t length = 0;
+			for (size_t i = start; !seen[i]; i = pivot_row[i], length++)
+				seen[i] = true;
+			if (length % 2 == 0)
+				result = -result;
+		}
+		return result;
+	}
+
+	// Solve A*x = b. `x` and `b` must not overlap
+	void solve (std::span<T> x, std::span<const T> b) const
+	{
+		assert(!singular());
+		assert(x.size() == n && b.size() == n);
+
+		std::vector<T> y(n);
+		for (size_t k = 0; k < n; k++) {
+			T value = b[order[pivot_row[k]]];
+			for (const Entry& e: lower[k])
+				value -= e.value * y[e.col];
+			y[k] = value;
+		}
+
+		for (size_t k = n-1; k != size_t(-1); k--) {
+			T value = y[k];
+			for (size_t i = 1; i < upper[k].size(); i++)
+				value -= upper[k][i].value * y[upper[k][i].col];
+			y[k] = value / upper[k].front().value;
+		}
+
+		for (size_t i = 0; i < n; i++)
+			x[order[i]] = y[i];
+	}
+};
+
+} // namespace math
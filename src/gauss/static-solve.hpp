@@ -0,0 +1,212 @@
+#pragma once
+
+#include <array>
+#include <cmath>
+#include <gauss/matrix.hpp>
+#include <type_traits>
+#include <utility>
+
+// The solve.hpp functions for Static_matrix, with every size known at compile time.
+// The loops are unrolled, so small matrices can live in registers, and everything is usable
+// in constant expressions.
+// Each main element is divided by once, and multiplied by after that. Multiplications and
+// subtractions are fused where the target has FMA. Static_arithmetic::reference
+// does the arithmetic in the same order as gauss_triangulate() and gauss_gather() instead,
+// so the results match theirs bit for bit, unless the compiler is allowed to fuse operations
+// and does so differently
+
+namespace math {
+
+// Larger matrices would unroll into too much code; use the views for them
+constexpr size_t static_max_size = 16;
+
+enum class Static_arithmetic { fast, reference };
+
+namespace detail {
+
+// f(std::integral_constant<size_t, I>{}) for every I in [Begin, End), in order
+template <size_t Begin, size_t End, typename F> constexpr void unrolled (F&& f)
+{
+	if constexpr (Begin < End) {
+		[&] <size_t... I> (std::index_sequence<I...>) {
+			(f(std::integral_constant<size_t, Begin + I>{}), ...);
+		} (std::make_index_sequence<End - Begin>{});
+	}
+}
+
+// c - a*b, in one rounding where that is as fast. Not in constant expressions, where
+// std::fma is not allowed
+template <typename T> constexpr T multiply_subtract (T c, T a, T b)
+{
+#ifdef FP_FAST_FMA
+	if constexpr (std::is_floating_point_v<T>) {
+		if (!std::is_constant_evaluated())
+			return std::fma(-a, b, c);
+	}
+#endif
+	return c - a * b;
+}
+
+} // namespace detail
+
+// See gauss_triangulate() in solve.hpp
+template <Static_arithmetic Arithmetic = Static_arithmetic::fast, typename T, size_t Rows, size_t Cols>
+	requires (Rows <= static_max_size && Cols <= static_max_size+1)
+constexpr unsigned gauss_triangulate
+(Static_matrix<T, Rows, Cols>& mat, std::array<size_t, Cols-1>& permute_variables)
+{
+	constexpr size_t num_variables = Cols-1;
+	unsigned permutations = 0;
+
+	for (size_t i = 0; i < num_variables; i++)
+		permute_variables[i] = i;
+
+	size_t var = 0;
+	detail::unrolled<0, Rows>([&] (auto equ_constant) {
+		constexpr size_t equ = decltype(equ_constant)::value;
+		if (var == num_variables)
+			return;
+
+		{ // Find a nonzero main element
+			size_t nonzero = var;
+			while (nonzero < num_variables && mat(equ, nonzero) == 0)
+				nonzero++;
+			if (nonzero == num_variables)
+				return;
+			if (nonzero != var) {
+				detail::unrolled<0, Rows>([&] (auto row) { std::swap(mat(row, nonzero), mat(row, var)); });
+				std::swap(permute_variables[nonzero], permute_variables[var]);
+				permutations++;
+			}
+		}
+
+		const T main_element = mat(equ, var);
+		const T inverse = Arithmetic == Static_arithmetic::fast ? 1 / main_element : 0;
+		// Subtracts the main row, times the element of row `nequ` under the main element
+		const auto subtract = [&] (size_t nequ, size_t col, const T& left_element) {
+			if constexpr (Arithmetic == Static_arithmetic::reference)
+				mat(nequ, col) -= (left_element * mat(equ, col)) / main_element;
+			else
+				mat(nequ, col) = detail::multiply_subtract(mat(nequ, col), left_element, mat(equ, col));
+		};
+		const auto left = [&] (size_t nequ) {
+			return Arithmetic == Static_arithmetic::reference ? mat(nequ, var) : mat(nequ, var) * inverse;
+		};
+
+		const auto eliminate = [&] {
+			detail::unrolled<equ+1, Rows>([&] (auto nequ) {
+				const T left_element = left(nequ);
+				for (size_t col = var+1; col < Cols; col++)
+					subtract(nequ, col, left_element);
+				mat(nequ, var) = 0;
+			});
+		};
+
+		// No zero columns skipped so far is the usual case: then all indices are constant
+		if constexpr (equ < num_variables) {
+			if (var == equ) {
+				detail::unrolled<equ+1, Rows>([&] (auto nequ) {
+					const T left_element = left(nequ);
+					detail::unrolled<equ+1, Cols>([&] (auto col) { subtract(nequ, col, left_element); });
+					mat(nequ, equ) = 0;
+				});
+			} else {
+				eliminate();
+			}
+		} else {
+			eliminate();
+		}
+
+		var++;
+	});
+
+	return permutations;
+}
+
+// See gauss_gather() in solve.hpp.
+// When the return value is not 0, `raw_solution` may be left partly unchanged
+template <Static_arithmetic Arithmetic = Static_arithmetic::fast, typename T, size_t Rows, size_t Cols>
+	requires (Rows <= static_max_size && Cols <= static_max_size+1)
+constexpr int gauss_gather (std::array<T, Cols-1>& raw_solution, const Static_matrix<T, Rows, Cols>& mat)
+{
+	constexpr size_t num_variables = Cols-1;
+	constexpr size_t free_col = Cols-1;
+
+	// "0*x1 + 0*x2 + ... = <nonzero>" -> no solution
+	const auto inconsistent = [&] (size_t i) {
+		if (mat(i, free_col) == 0)
+			return false;
+		for (size_t j = 0; j < num_variables; j++) {
+			if (mat(i, j) != 0)
+				return false;
+		}
+		return true;
+	};
+
+	if constexpr (Rows >= num_variables) {
+		bool full_rank = true;
+		detail::unrolled<0, num_variables>([&] (auto i) { full_rank &= mat(i, i) != 0; });
+		// The usual case. Only the extra equations can be inconsistent then, and they are
+		// all zeros, see gauss_gather()
+		if (full_rank) {
+			for (size_t i = num_variables; i < Rows; i++) {
+				if (inconsistent(i))
+					return -1;
+			}
+
+			// The divisions don't depend on each other, so done first they are off the chain
+			// of substitutions
+			std::array<T, num_variables> inverse {};
+			if constexpr (Arithmetic == Static_arithmetic::fast)
+				detail::unrolled<0, num_variables>([&] (auto i) { inverse[i] = 1 / mat(i, i); });
+
+			detail::unrolled<0, num_variables>([&] (auto k) {
+				constexpr size_t i = num_variables-1 - k;
+				T coef = mat(i, free_col);
+				if constexpr (Arithmetic == Static_arithmetic::reference) {
+					detail::unrolled<i+1, num_variables>([&] (auto j) { coef -= mat(i, j) * raw_solution[j]; });
+					raw_solution[i] = coef / mat(i, i);
+				} else {
+					detail::unrolled<i+1, num_variables>([&] (auto j) {
+						coef = detail::multiply_subtract(coef, mat(i, j), raw_solution[j]);
+					});
+					raw_solution[i] = coef * inverse[i];
+				}
+			});
+			return 0;
+		}
+	}
+
+	for (size_t i = 0; i < Rows; i++) {
+		if (inconsistent(i))
+			return -1;
+	}
+	if constexpr (Rows < num_variables)
+		return num_variables - Rows;
+	else
+		return 1;
+}
+
+// See triangular_determinant() in solve.hpp
+template <typename T, size_t N> requires (N <= static_max_size)
+constexpr T triangular_determinant (const Static_matrix<T, N, N>& mat)
+{
+	T result = 1;
+	detail::unrolled<0, N>([&] (auto i) { result *= mat(i, i); });
+	return result;
+}
+
+// See mul_matrix_vector() in solve.hpp. The products are summed in plain order
+template <typename T, size_t Rows, size_t Cols>
+	requires (Rows <= static_max_size && Cols <= static_max_size)
+constexpr void mul_matrix_vector
+(std::array<T, Rows>& dest, const Static_matrix<T, Rows, Cols>& mat, const std::array<T, Cols>& vec)
+{
+	detail::unrolled<0, Rows>([&] (auto row) {
+		T sum = 0;
+		detail::unrolled<0, Cols>([&] (auto col) { sum += mat(row, col) * vec[col]; });
+		dest[row] = sum;
+	});
+}
+
+} // namespace math
@@ -0,0 +1,72 @@
+#include <cassert>
+#include <util/thread-pool.hpp>
+
+Thread_pool::Thread_pool (unsigned num_threads)
+{
+	assert(num_threads > 0);
+	workers.reserve(num_threads-1);
+	for (unsigned i = 1; i < num_threads; i++)
+		workers.emplace_back([this] { worker_loop(); });
+}
+
+Thread_pool::~Thread_pool ()
+{
+	{
+		std::lock_guard lock(mutex);
+		stopping = true;
+	}
+	job_posted.notify_all();
+	// std::jthread joins on destruction
+}
+
+void Thread_pool::worker_loop ()
+{
+	std::unique_lock lock(mutex);
+	while (true) {
+		job_posted.wait(lock, [this] { return stopping || next_chunk < job_chunks; });
+		if (stopping)
+			return;
+		work_on_job(lock);
+	}
+}
+
+void Thread_pool::work_on_job (std::unique_lock<std::mutex>& lock)
+{
+	while (next_chunk < job_chunks) {
+		const unsigned chunk = next_chunk++;
+		const auto fn = job_fn;
+		void* const context = job_context;
+
+		lock.unlock();
+		fn(context, chunk);
+		lock.lock();
+
+		if (--unfinished_chunks == 0)
+			job_finished.notify_all();
+	}
+}
+
+void Thread_pool::run_erased (unsigned chunks, void (*fn) (void*, unsigned), void* context)
+{
+	std::unique_lock lock(mutex);
+	assert(unfinished_chunks == 0);
+
+	job_fn = fn;
+	job_context = context;
+	job_chunks = chunks;
+	next_chunk = 0;
+	unfinished_chunks = chunks;
+	job_posted.notify_all();
+
+	work_on_job(lock);
+	job_finished.wait(lock, [this] { return unfinished_chunks == 0; });
+
+	job_chunks = 0;
+	next_chunk = 0;
+}
+
+Thread_pool& shared_thread_pool ()
+{
+	static Thread_pool pool(std::max(1u, std::thread::hardware_concurrency()));
+	return pool;
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// A fixed set of worker threads that run one job at a time, split into chunks.
+// The calling thread takes part in the job, and run() returns only when all chunks are done,
+// which makes every call a barrier.
+class Thread_pool {
+	std::vector<std::jthread> workers;
+
+	std::mutex mutex;
+	std::condition_variable job_posted;
+	std::condition_variable job_finished;
+
+	// The current job, all guarded by `mutex`
+	void (*job_fn) (void*, unsigned) = nullptr;
+	void* job_context = nullptr;
+	unsigned job_chunks = 0;
+	unsigned next_chunk = 0;
+	unsigned unfinished_chunks = 0;
+	bool stopping = false;
+
+	void worker_loop ();
+	// Take and run chunks of the current job until there are none left. `lock` must be held
+	void work_on_job (std::unique_lock<std::mutex>& lock);
+
+	void run_erased (unsigned chunks, void (*fn) (void*, unsigned), void* context);
+
+public:
+	// `num_threads` includes the calling thread
+	explicit Thread_pool (unsigned num_threads);
+	~Thread_pool ();
+
+	Thread_pool (const Thread_pool&) = delete;
+	Thread_pool& operator= (const Thread_pool&) = delete;
+
+	unsigned size () const { return workers.size() + 1; }
+
+	// Call `f(chunk)` for every chunk in [0, chunks), concurrently. Not reentrant
+	template <typename F> void run (unsigned chunks, F&& f)
+	{
+		using Fn = std::remove_reference_t<F>;
+		run_erased(chunks, [] (void* context, unsigned chunk) { (*static_cast<Fn*>(context))(chunk); },
+				const_cast<void*>(static_cast<const void*>(std::addressof(f))));
+	}
+};
+
+// The pool shared by the whole program, with a thread per hardware thread
+Thread_pool& shared_thread_pool ();
+
+// Split [begin, end) into up to `threads` contiguous subranges of at least `min_chunk` each,
+// and call `f(sub_begin, sub_end)` for each of them on the shared pool.
+// The split only depends on the arguments, never on timing.
+template <typename F>
+void parallel_for (size_t begin, size_t end, unsigned threads, size_t min_chunk, F&& f)
+{
+	const size_t count = end - begin;
+	const size_t chunks = std::min<size_t>(threads, count / std::max<size_t>(min_chunk, 1));
+	if (chunks <= 1) {
+		f(begin, end);
+		return;
+	}
+	shared_thread_pool().run(chunks, [&] (unsigned chunk) {
+		f(begin + count * chunk / chunks, begin + count * (chunk+1) / chunks);
+	});
+}
+
+// Same as above, over a random access range: `f(sub_begin, sub_end)` gets iterators
+template <std::random_access_iterator It, typename F>
+void parallel_for (It begin, It end, unsigned threads, size_t min_chunk, F&& f)
+{
+	using Difference = std::iter_difference_t<It>;
+	parallel_for(0, size_t(end - begin), threads, min_chunk, [&] (size_t sub_begin, size_t sub_end) {
+		f(begin + Difference(sub_begin), begin + Difference(sub_end));
+	});
+}
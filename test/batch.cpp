@@ -0,0 +1,119 @@
+#include "check.hpp"
+#include <gauss/batch.hpp>
+#include <gauss/solve.hpp>
+#include <vector>
+
+using namespace math;
+
+// The dispatched kernel against the plain loop, with counts that leave a tail after each vector
+template <typename T> void check_eliminate (std::mt19937& rng)
+{
+	for (size_t count: { 1, 7, 13, 16, 37 }) {
+		for (size_t width: { 1, 2, 5 }) {
+			std::vector<T> row(width * count), main_row(width * count), inverse(count);
+			for (auto& x: row)
+				x = T(test::random_real(rng));
+			for (auto& x: main_row)
+				x = T(test::random_real(rng));
+			for (size_t s = 0; s < count; s++)
+				inverse[s] = 1 / main_row[s];
+
+			std::vector<T> expected = row;
+			for (size_t col = 1; col < width; col++) {
+				for (size_t s = 0; s < count; s++)
+					expected[col * count + s] -= (row[s] * inverse[s]) * main_row[col * count + s];
+			}
+			eliminate_batch(std::span(row), std::span<const T>(main_row), std::span<const T>(inverse));
+			for (size_t s = 0; s < count; s++)
+				CHECK(row[s] == 0);
+			for (size_t i = count; i < row.size(); i++)
+				CHECK(test::near(row[i], expected[i], std::is_same_v<T, float> ? 1e-5 : 1e-13, 100));
+		}
+	}
+}
+
+enum class Fill {
+	random,
+	zero_row, // one equation with every coefficient zero, sometimes with a nonzero free term
+	zero_column, // one variable in no equation
+	mixed, // any of the above
+};
+
+// Every system of a batch against gauss_triangulate() and gauss_gather() on it alone.
+// The batch is rounded differently, so, as in test/static-solve.cpp, coefficients are
+// generic reals that don't cancel out, and its results only have to be close
+template <typename T> void check_batch
+(std::mt19937& rng, size_t rows, size_t cols, size_t count, Fill fill, unsigned threads)
+{
+	const size_t num_variables = cols-1;
+	const double tolerance = std::is_same_v<T, float> ? 1e-3 : 1e-9;
+
+	Matrix_batch<T> systems(count, rows, cols), triangulated(count, rows, cols);
+	for (size_t s = 0; s < count; s++) {
+		const Fill kind = fill == Fill::mixed ? Fill(s % 3) : fill;
+		const size_t zero_row = rng() % rows, zero_column = rng() % num_variables;
+		const bool zero_free_term = rng() % 2 == 0;
+		for (size_t row = 0; row < rows; row++) {
+			for (size_t col = 0; col < cols; col++) {
+				T value = T(test::random_real(rng));
+				if (kind == Fill::zero_row && row == zero_row && (col < num_variables || zero_free_term))
+					value = 0;
+				if (kind == Fill::zero_column && col == zero_column)
+					value = 0;
+				systems(row, col)[s] = value;
+			}
+		}
+	}
+
+	std::vector<T> solutions(count * num_variables);
+	std::vector<int> classification(count);
+	gauss_solve_batch(systems, triangulated, std::span(solutions), std::span(classification), threads);
+
+	Matrix<T> mat(rows, cols);
+	std::vector<size_t> permute(num_variables);
+	std::vector<T> raw_solution(num_variables);
+	for (size_t s = 0; s < count; s++) {
+		for (size_t row = 0; row < rows; row++) {
+			for (size_t col = 0; col < cols; col++)
+				mat[row][col] = systems(row, col)[s];
+		}
+		gauss_triangulate(Matrix_view<T>(mat), std::span(permute));
+
+		double max_element = 0;
+		for (size_t row = 0; row < rows; row++) {
+			for (size_t col = 0; col < cols; col++)
+				max_element = std::max(max_element, double(std::abs(mat[row][col])));
+		}
+		for (size_t row = 0; row < rows; row++) {
+			for (size_t col = 0; col < cols; col++)
+				CHECK(test::near(triangulated(row, col)[s], mat[row][col], tolerance, max_element));
+		}
+
+		const int expected = gauss_gather(std::span(raw_solution), Matrix_view<T>(mat));
+		CHECK(classification[s] == expected);
+		if (expected != 0 || classification[s] != 0)
+			continue;
+		for (size_t var = 0; var < num_variables; var++) {
+			CHECK(test::near(solutions[permute[var] * count + s], raw_solution[var], tolerance,
+					std::abs(raw_solution[var]) * 1e3));
+		}
+	}
+}
+
+int main ()
+{
+	auto rng = test::generator();
+	check_eliminate<double>(rng);
+	check_eliminate<float>(rng);
+
+	// Square, wide and tall, with counts that don't fill the last block of 256
+	const std::pair<size_t, size_t> sizes[] = { {3, 4}, {4, 5}, {8, 9}, {2, 5}, {6, 4}, {5, 5}, {1, 2} };
+	for (auto [rows, cols]: sizes) {
+		for (Fill fill: { Fill::random, Fill::zero_row, Fill::zero_column, Fill::mixed }) {
+			check_batch<double>(rng, rows, cols, 700, fill, 1);
+			check_batch<double>(rng, rows, cols, 3000, fill, 3);
+		}
+		check_batch<float>(rng, rows, cols, 300, Fill::mixed, 1);
+	}
+	return test::result();
+}
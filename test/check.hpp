@@ -0,0 +1,61 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+
+// A test is an executable that returns test::result() from main(). CHECK is like assert(),
+// but it isn't compiled out by NDEBUG, and a failure is counted instead of aborting,
+// so that a run reports every failed check
+
+namespace test {
+
+inline int failures = 0;
+
+inline bool check (bool ok, const char* what, const char* file, int line)
+{
+	if (!ok) {
+		std::fprintf(stderr, "%s:%d: check failed: %s\n", file, line, what);
+		failures++;
+	}
+	return ok;
+}
+
+inline int result ()
+{
+	if (failures > 0)
+		std::fprintf(stderr, "%d checks failed\n", failures);
+	return failures == 0 ? 0 : 1;
+}
+
+// |a - b| within `tolerance` relative to `scale`, or absolute below a scale of 1
+inline bool near (double a, double b, double tolerance, double scale = 0)
+{
+	scale = std::max({ scale, std::abs(a), std::abs(b), 1.0 });
+	return std::abs(a - b) <= tolerance * scale;
+}
+
+// The tests are deterministic: every one seeds its own generator the same way
+inline std::mt19937 generator () { return std::mt19937(12345); }
+
+// A value in [-10, 10] in steps of 0.01, and zero with a probability of `zero_share`
+inline double random_value (std::mt19937& rng, double zero_share = 0)
+{
+	if (zero_share > 0 && std::uniform_real_distribution<double>(0, 1)(rng) < zero_share)
+		return 0;
+	return std::uniform_int_distribution<int>(-1000, 1000)(rng) / 100.0;
+}
+
+// Like random_value(), but any double in [-10, 10]: with them, elements practically never
+// cancel out exactly, so results that are rounded differently don't tell apart zero and nonzero
+inline double random_real (std::mt19937& rng, double zero_share = 0)
+{
+	if (zero_share > 0 && std::uniform_real_distribution<double>(0, 1)(rng) < zero_share)
+		return 0;
+	return std::uniform_real_distribution<double>(-10, 10)(rng);
+}
+
+} // namespace test
+
+#define CHECK(condition) test::check((condition), #condition, __FILE__, __LINE__)
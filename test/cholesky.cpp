@@ -0,0 +1,88 @@
+#include "check.hpp"
+#include <gauss/cholesky.hpp>
+#include <gauss/lu.hpp>
+#include <limits>
+#include <vector>
+
+using namespace math;
+
+// B^T*B + n*I, symmetric positive definite and well-conditioned
+Matrix<double> random_positive_definite (std::mt19937& rng, size_t n)
+{
+	Matrix<double> b(n, n), a(n, n);
+	for (size_t i = 0; i < n; i++) {
+		for (size_t j = 0; j < n; j++)
+			b[i][j] = test::random_real(rng) / 10;
+	}
+	for (size_t i = 0; i < n; i++) {
+		for (size_t j = 0; j < n; j++) {
+			double sum = i == j ? double(n) : 0;
+			for (size_t k = 0; k < n; k++)
+				sum += b[k][i] * b[k][j];
+			a[i][j] = sum;
+		}
+	}
+	return a;
+}
+
+// The residual of the solution is that of a backward stable solve, at sizes on and around
+// the edges of blocks, where the panels and the trailing updates meet
+void check_solve (std::mt19937& rng, size_t n, size_t block_size, unsigned threads)
+{
+	const auto a = random_positive_definite(rng, n);
+	CHECK(maybe_positive_definite(Matrix_view<const double>(a)));
+
+	// Only the upper triangle is read
+	Matrix<double> upper = a;
+	for (size_t i = 0; i < n; i++) {
+		for (size_t j = 0; j < i; j++)
+			upper[i][j] = std::numeric_limits<double>::quiet_NaN();
+	}
+	const Cholesky_factorization<double> factorization(std::move(upper), block_size, threads);
+	if (!CHECK(factorization.positive_definite()))
+		return;
+
+	std::vector<double> b(n), x(n);
+	for (double& value: b)
+		value = test::random_real(rng);
+	factorization.solve(std::span(x), std::span<const double>(b));
+	for (size_t i = 0; i < n; i++) {
+		double sum = 0, scale = std::abs(b[i]);
+		for (size_t j = 0; j < n; j++) {
+			sum += a[i][j] * x[j];
+			scale += std::abs(a[i][j] * x[j]);
+		}
+		CHECK(test::near(sum, b[i], 1e-14 * double(n), scale));
+	}
+
+	// The determinant overflows past about 130 rows here
+	if (n > 130)
+		return;
+	const Lu_factorization<double> lu { Matrix_view<const double>(a) };
+	CHECK(test::near(factorization.determinant(), lu.determinant(), 1e-10 * double(n),
+			std::abs(lu.determinant())));
+}
+
+int main ()
+{
+	auto rng = test::generator();
+	for (size_t n: { 1, 2, 63, 64, 65, 127, 128, 129, 200 })
+		check_solve(rng, n, default_cholesky_block_size, 1);
+	for (size_t n: { 15, 16, 17, 100 })
+		check_solve(rng, n, 16, 3);
+
+	// Symmetric, with a positive diagonal, but not positive definite: an eigenvalue is -1
+	{
+		Matrix<double> a(3, 3);
+		const double elements[3][3] = { { 1, 2, 0 }, { 2, 1, 0 }, { 0, 0, 1 } };
+		for (size_t i = 0; i < 3; i++) {
+			for (size_t j = 0; j < 3; j++)
+				a[i][j] = elements[i][j];
+		}
+		CHECK(maybe_positive_definite(Matrix_view<const double>(a)));
+		CHECK(!Cholesky_factorization<double>(Matrix_view<const double>(a)).positive_definite());
+		a[0][1] = 3;
+		CHECK(!maybe_positive_definite(Matrix_view<const double>(a)));
+	}
+	return test::result();
+}
@@ -0,0 +1,144 @@
+#include "check.hpp"
+#include <gauss/cholesky.hpp>
+#include <gauss/eigen.hpp>
+#include <numbers>
+#include <vector>
+
+using namespace math;
+
+// Every expected eigenvalue is found, each once
+void check_eigenvalues
+(Matrix_view<const double> a, std::vector<std::complex<double>> expected, double tolerance)
+{
+	const auto found = eigenvalues(a);
+	if (!CHECK(found && found->size() == expected.size()))
+		return;
+	for (const auto& value: *found) {
+		const auto distance = [&] (std::complex<double> e) { return std::abs(e - value); };
+		const auto nearest = std::ranges::min_element(expected, {}, distance);
+		CHECK(std::abs(*nearest - value) <= tolerance);
+		expected.erase(nearest);
+	}
+}
+
+// The roots of (x - 1)(x - 2)(x + 3)(x^2 + 1) as the eigenvalues of its companion matrix,
+// which has complex ones and isn't symmetric
+void check_companion ()
+{
+	// Coefficients of x^0 .. x^4 of the monic polynomial, from the roots
+	const std::vector<std::complex<double>> roots = { 1, 2, -3, { 0, 1 }, { 0, -1 } };
+	std::vector<std::complex<double>> poly = { 1 };
+	for (auto root: roots) {
+		std::vector<std::complex<double>> next(poly.size() + 1);
+		for (size_t i = 0; i < poly.size(); i++) {
+			next[i+1] += poly[i];
+			next[i] -= root * poly[i];
+		}
+		poly = next;
+	}
+
+	const size_t n = roots.size();
+	Matrix<double> companion(n, n);
+	for (size_t i = 0; i < n; i++) {
+		for (size_t j = 0; j < n; j++)
+			companion[i][j] = 0;
+	}
+	for (size_t i = 1; i < n; i++)
+		companion[i][i-1] = 1;
+	for (size_t i = 0; i < n; i++)
+		companion[i][n-1] = -poly[i].real();
+	check_eigenvalues(Matrix_view<const double>(companion), roots, 1e-8);
+}
+
+// The roots of unity, all of the same magnitude: the QR algorithm must not stall on them
+void check_cyclic_permutation (size_t n)
+{
+	Matrix<double> permutation(n, n);
+	for (size_t i = 0; i < n; i++) {
+		for (size_t j = 0; j < n; j++)
+			permutation[i][j] = j == (i + 1) % n ? 1 : 0;
+	}
+	std::vector<std::complex<double>> expected;
+	for (size_t k = 0; k < n; k++)
+		expected.push_back(std::polar(1.0, 2 * std::numbers::pi * double(k) / double(n)));
+	check_eigenvalues(Matrix_view<const double>(permutation), expected, 1e-8);
+}
+
+// The second difference matrix, with eigenvalues 2 - 2cos(k*pi / (n+1))
+void check_lanczos (size_t n)
+{
+	Matrix<double> laplacian(n, n);
+	for (size_t i = 0; i < n; i++) {
+		for (size_t j = 0; j < n; j++)
+			laplacian[i][j] = i == j ? 2 : i == j+1 || j == i+1 ? -1 : 0;
+	}
+	const auto eigenvalue = [&] (size_t k) {
+		return 2 - 2 * std::cos(double(k) * std::numbers::pi / double(n+1));
+	};
+
+	const auto result = lanczos<double>(Matrix_view<const double>(laplacian), 2, { .max_iterations = n });
+	CHECK(result.converged);
+	if (!CHECK(result.smallest.size() == 2 && result.largest.size() == 2))
+		return;
+	CHECK(test::near(result.smallest[0], eigenvalue(1), 1e-8, 4));
+	CHECK(test::near(result.smallest[1], eigenvalue(2), 1e-8, 4));
+	CHECK(test::near(result.largest[0], eigenvalue(n-1), 1e-8, 4));
+	CHECK(test::near(result.largest[1], eigenvalue(n), 1e-8, 4));
+
+	std::vector<double> v(n);
+	const auto dominant = power_iteration(Matrix_view<const double>(laplacian), std::span(v), 0.0,
+			{ .max_iterations = 100000 });
+	CHECK(dominant.converged && test::near(dominant.eigenvalue, eigenvalue(n), 1e-6, 4));
+	std::ranges::fill(v, 0);
+	const auto nearest = inverse_iteration(Matrix_view<const double>(laplacian), std::span(v), 1.0);
+	CHECK(nearest.converged);
+	CHECK(std::abs(nearest.eigenvalue - 1) < std::abs(eigenvalue(n/2) - 1) + 1e-8);
+}
+
+// Three distinct eigenvalues: the Krylov subspace is invariant after three steps, which is all there is
+void check_lanczos_invariant ()
+{
+	const size_t n = 300;
+	Matrix<double> diagonal(n, n);
+	for (size_t i = 0; i < n; i++) {
+		for (size_t j = 0; j < n; j++)
+			diagonal[i][j] = i == j ? double(1 + i % 3) : 0;
+	}
+	const auto one = lanczos<double>(Matrix_view<const double>(diagonal), 1);
+	CHECK(one.converged && one.smallest.size() == 1 && one.largest.size() == 1);
+	CHECK(test::near(one.smallest.front(), 1, 1e-12) && test::near(one.largest.front(), 3, 1e-12));
+	// Five of each are asked for, but there are only three in the subspace, and more in the matrix
+	CHECK(!lanczos<double>(Matrix_view<const double>(diagonal), 5).converged);
+}
+
+// The Hilbert matrix of size 8 has eigenvalues from 1.11e-10 to 1.70. Lanczos finds the smallest
+// only to within 1e-10 * 1.70; inverse iteration with the Cholesky factorization finds it
+// to within its own size
+void check_smallest_eigenvalue ()
+{
+	const size_t n = 8;
+	Matrix<double> hilbert(n, n);
+	for (size_t i = 0; i < n; i++) {
+		for (size_t j = 0; j < n; j++)
+			hilbert[i][j] = 1.0 / double(i + j + 1);
+	}
+	const Cholesky_factorization<double> factorization { Matrix_view<const double>(hilbert) };
+	if (!CHECK(factorization.positive_definite()))
+		return;
+	std::vector<double> v(n);
+	const auto solve = [&] (std::span<double> x, std::span<const double> b) { factorization.solve(x, b); };
+	const auto result = smallest_eigenvalue<double>(solve, std::span(v));
+	CHECK(result.converged);
+	CHECK(test::near(result.eigenvalue, 1.111538966e-10, 1e-7, 1e-10) && result.eigenvalue > 1.1e-10);
+}
+
+int main ()
+{
+	check_companion();
+	for (size_t n: { 2, 3, 7, 16 })
+		check_cyclic_permutation(n);
+	check_lanczos(50);
+	check_lanczos_invariant();
+	check_smallest_eigenvalue();
+	return test::result();
+}
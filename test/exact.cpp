@@ -0,0 +1,135 @@
+#include "check.hpp"
+#include <cmath>
+#include <gauss/exact.hpp>
+#include <vector>
+
+using namespace math;
+
+Fraction add (const Fraction& x, const Fraction& y)
+{
+	Big_int numerator = x.numerator * y.denominator + y.numerator * x.denominator;
+	Big_int denominator = x.denominator * y.denominator;
+	const Big_int divisor = gcd(numerator, denominator);
+	if (!divisor.is_zero() && divisor != Big_int(1)) {
+		numerator = numerator / divisor;
+		denominator = denominator / divisor;
+	}
+	return { numerator, denominator };
+}
+
+// The exact value of a finite double
+Fraction to_fraction (double value)
+{
+	int exponent;
+	const double mantissa = std::frexp(value, &exponent);
+	Fraction result { Big_int(std::int64_t(std::ldexp(mantissa, 53))), 1 };
+	exponent -= 53;
+	for (; exponent > 0; exponent--)
+		result.numerator = result.numerator * Big_int(2);
+	for (; exponent < 0; exponent++)
+		result.denominator = result.denominator * Big_int(2);
+	return add(result, Fraction {});
+}
+
+// Every equation holds exactly
+bool satisfies (Matrix_view<const double> system, const std::vector<Fraction>& solution)
+{
+	const size_t n = system.rows();
+	for (size_t i = 0; i < n; i++) {
+		Fraction sum { Big_int(0), Big_int(1) };
+		for (size_t j = 0; j < n; j++) {
+			const Fraction element = to_fraction(system[i][j]);
+			sum = add(sum, { element.numerator * solution[j].numerator,
+					element.denominator * solution[j].denominator });
+		}
+		if (sum != to_fraction(system[i][n]))
+			return false;
+	}
+	return true;
+}
+
+void check_integer (std::mt19937& rng, size_t n, int range)
+{
+	Matrix<double> system(n, n+1);
+	for (size_t i = 0; i < n; i++) {
+		for (size_t j = 0; j <= n; j++)
+			system[i][j] = std::uniform_int_distribution<int>(-range, range)(rng);
+	}
+	const auto result = exact_solve(Matrix_view<const double>(system));
+	if (!CHECK(result.status == Exact_status::ok && result.solution.size() == n))
+		return;
+	CHECK(satisfies(Matrix_view<const double>(system), result.solution));
+	// The primes go to the threads in a fixed order, so the result doesn't depend on them
+	const auto result_threads = exact_solve(Matrix_view<const double>(system), { .threads = 3 });
+	CHECK(result_threads.status == Exact_status::ok && result_threads.solution == result.solution);
+}
+
+int main ()
+{
+	auto rng = test::generator();
+	check_integer(rng, 1, 10);
+	check_integer(rng, 5, 10);
+	check_integer(rng, 12, 1000);
+	check_integer(rng, 30, 100);
+
+	// 2x + y = 1, x + 3y = 2: x = 1/5, y = 3/5
+	{
+		Matrix<double> system(2, 3);
+		const double elements[] = { 2, 1, 1,  1, 3, 2 };
+		for (size_t i = 0; i < 6; i++)
+			system[i / 3][i % 3] = elements[i];
+		const auto result = exact_solve(Matrix_view<const double>(system));
+		if (!CHECK(result.status == Exact_status::ok && result.solution.size() == 2))
+			return test::result();
+		CHECK(to_string(result.solution[0]) == "1/5" && to_string(result.solution[1]) == "3/5");
+		CHECK(to_double(result.solution[1]) == 0.6);
+		CHECK(!satisfies(Matrix_view<const double>(system), { result.solution[1], result.solution[0] }));
+	}
+
+	// The Hilbert matrix, as rounded to doubles: its fractions have hundreds of digits
+	{
+		const size_t n = 8;
+		Matrix<double> system(n, n+1);
+		for (size_t i = 0; i < n; i++) {
+			for (size_t j = 0; j < n; j++)
+				system[i][j] = 1.0 / double(i + j + 1);
+			system[i][n] = 1;
+		}
+		const auto result = exact_solve(Matrix_view<const double>(system), { .threads = 2 });
+		if (CHECK(result.status == Exact_status::ok))
+			CHECK(satisfies(Matrix_view<const double>(system), result.solution));
+	}
+
+	// Singular: the second equation is twice the first
+	{
+		Matrix<double> system(3, 4);
+		const double elements[] = { 1, 2, 3, 1,  2, 4, 6, 2,  1, 0, 1, 5 };
+		for (size_t i = 0; i < 12; i++)
+			system[i / 4][i % 4] = elements[i];
+		CHECK(exact_solve(Matrix_view<const double>(system)).status == Exact_status::singular);
+
+		// A zero column, with numbers far apart in magnitude elsewhere
+		for (size_t i = 0; i < 3; i++)
+			system[i][1] = 0;
+		system[0][0] = 1e300;
+		system[2][2] = 1e-300;
+		CHECK(exact_solve(Matrix_view<const double>(system)).status == Exact_status::singular);
+
+		system[0][0] = INFINITY;
+		CHECK(exact_solve(Matrix_view<const double>(system)).status == Exact_status::not_finite);
+		system[0][0] = NAN;
+		CHECK(exact_solve(Matrix_view<const double>(system)).status == Exact_status::not_finite);
+	}
+
+	// Magnitudes far apart, but not singular
+	{
+		Matrix<double> system(3, 4);
+		const double elements[] = { 0.1, 2, 3, 1,  2, 1e-300, 6, 2,  1, 0, 1e300, 5 };
+		for (size_t i = 0; i < 12; i++)
+			system[i / 4][i % 4] = elements[i];
+		const auto result = exact_solve(Matrix_view<const double>(system));
+		if (CHECK(result.status == Exact_status::ok))
+			CHECK(satisfies(Matrix_view<const double>(system), result.solution));
+	}
+	return test::result();
+}
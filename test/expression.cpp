@@ -0,0 +1,105 @@
+#include "check.hpp"
+#include <gauss/expression.hpp>
+#include <limits>
+#include <vector>
+
+using namespace math;
+
+Matrix<double> random_matrix (std::mt19937& rng, size_t rows, size_t cols)
+{
+	Matrix<double> mat(rows, cols);
+	for (size_t i = 0; i < rows; i++) {
+		for (size_t j = 0; j < cols; j++)
+			mat[i][j] = test::random_real(rng);
+	}
+	return mat;
+}
+
+std::vector<double> random_vector (std::mt19937& rng, size_t size)
+{
+	std::vector<double> v(size);
+	for (double& value: v)
+		value = test::random_real(rng);
+	return v;
+}
+
+double product_element (const Matrix<double>& a, const Matrix<double>& b, size_t i, size_t j)
+{
+	double sum = 0;
+	for (size_t k = 0; k < a.cols(); k++)
+		sum += a[i][k] * b[k][j];
+	return sum;
+}
+
+void check_vectors (std::mt19937& rng, size_t rows, size_t cols, unsigned threads)
+{
+	const auto a = random_matrix(rng, rows, cols), other = random_matrix(rng, cols, 5);
+	const auto x = random_vector(rng, cols), y = random_vector(rng, rows);
+	std::vector<double> r(rows);
+
+	evaluate(std::span(r), lazy(a) * lazy(x) - 2.0 * lazy(y) + lazy(y), threads);
+	for (size_t i = 0; i < rows; i++) {
+		double sum = 0;
+		for (size_t j = 0; j < cols; j++)
+			sum += a[i][j] * x[j];
+		CHECK(test::near(r[i], sum - y[i], 1e-12, 100));
+	}
+
+	// A column of a matrix, as a vector of its own and as the vector of a product
+	const auto column = Matrix_view<const double>(a).column(cols-1);
+	evaluate(std::span(r), -(lazy(y) - lazy(column)) * 3.0, threads);
+	for (size_t i = 0; i < rows; i++)
+		CHECK(test::near(r[i], -3 * (y[i] - a[i][cols-1]), 1e-14));
+	evaluate(std::span(r), lazy(a) * lazy(Matrix_view<const double>(other).column(2)), threads);
+	for (size_t i = 0; i < rows; i++)
+		CHECK(test::near(r[i], product_element(a, other, i, 2), 1e-12, 100));
+
+	// The destination may be an operand, elementwise
+	std::vector<double> z = y;
+	evaluate(std::span(z), lazy(z) - lazy(z) + 0.5 * lazy(y), threads);
+	for (size_t i = 0; i < rows; i++)
+		CHECK(z[i] == 0.5 * y[i]);
+}
+
+void check_matrices (std::mt19937& rng, size_t m, size_t k, size_t n, unsigned threads)
+{
+	const auto a = random_matrix(rng, m, k), b = random_matrix(rng, k, n), d = random_matrix(rng, m, n);
+	const auto b_a = random_matrix(rng, m, k), a_b = random_matrix(rng, k, n);
+	Matrix<double> c(m, n);
+
+	evaluate(c, lazy(a) * lazy(b) + 2.0 * lazy(d) - 0.5 * (lazy(b_a) * lazy(a_b)), threads);
+	for (size_t i = 0; i < m; i++) {
+		for (size_t j = 0; j < n; j++) {
+			const double expected = product_element(a, b, i, j) + 2 * d[i][j]
+					- 0.5 * product_element(b_a, a_b, i, j);
+			CHECK(test::near(c[i][j], expected, 1e-12, 100 * double(k)));
+		}
+	}
+
+	// Only a product: C isn't read, so garbage in it doesn't matter
+	for (auto row: Matrix_view<double>(c))
+		std::ranges::fill(row, std::numeric_limits<double>::quiet_NaN());
+	evaluate(c, lazy(a) * lazy(b), threads);
+	for (size_t i = 0; i < m; i++) {
+		for (size_t j = 0; j < n; j++)
+			CHECK(test::near(c[i][j], product_element(a, b, i, j), 1e-12, 100 * double(k)));
+	}
+
+	// Elementwise only, into an operand
+	Matrix<double> e = d;
+	evaluate(e, lazy(e) + lazy(e) - lazy(d), threads);
+	for (size_t i = 0; i < m; i++)
+		CHECK(std::ranges::equal(e[i], d[i]));
+}
+
+int main ()
+{
+	auto rng = test::generator();
+	check_vectors(rng, 1, 1, 1);
+	check_vectors(rng, 30, 7, 1);
+	check_vectors(rng, 300, 301, 3);
+	check_matrices(rng, 1, 1, 1, 1);
+	check_matrices(rng, 13, 7, 29, 1);
+	check_matrices(rng, 200, 150, 120, 3);
+	return test::result();
+}
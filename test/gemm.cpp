@@ -0,0 +1,108 @@
+#include "check.hpp"
+#include <gauss/gemm.hpp>
+#include <array>
+#include <limits>
+#include <vector>
+
+using namespace math;
+
+template <typename T> Matrix<T> random_matrix (std::mt19937& rng, size_t rows, size_t cols)
+{
+	Matrix<T> mat(rows, cols);
+	for (size_t i = 0; i < rows; i++) {
+		for (size_t j = 0; j < cols; j++)
+			mat[i][j] = T(test::random_real(rng));
+	}
+	return mat;
+}
+
+// gemm() on a view inside a larger matrix, whose border must stay untouched, against a plain
+// triple loop, for every combination of transposes
+template <typename T> void check_gemm
+(std::mt19937& rng, size_t m, size_t n, size_t k, T beta, unsigned threads)
+{
+	const double tolerance = (std::is_same_v<T, float> ? 1e-5 : 1e-13) * double(k + 1);
+	for (Transpose ta: { Transpose::no, Transpose::yes }) {
+		for (Transpose tb: { Transpose::no, Transpose::yes }) {
+			const auto a = ta == Transpose::no ? random_matrix<T>(rng, m, k) : random_matrix<T>(rng, k, m);
+			const auto b = tb == Transpose::no ? random_matrix<T>(rng, k, n) : random_matrix<T>(rng, n, k);
+			auto outer = random_matrix<T>(rng, m+2, n+3);
+			const Matrix<T> original = outer;
+			const Matrix_view<T> c(outer[1].data() + 1, m, n, outer.stride());
+			// Not read when beta is 0
+			if (beta == 0) {
+				for (auto row: c)
+					std::ranges::fill(row, std::numeric_limits<T>::quiet_NaN());
+			}
+
+			const T alpha = T(0.7);
+			gemm<T>(c, alpha, a, ta, b, tb, beta, threads);
+
+			for (size_t i = 0; i < m+2; i++) {
+				for (size_t j = 0; j < n+3; j++) {
+					if (i == 0 || i > m || j == 0 || j > n) {
+						CHECK(outer[i][j] == original[i][j]);
+						continue;
+					}
+					double expected = 0;
+					for (size_t p = 0; p < k; p++) {
+						const T a_element = ta == Transpose::no ? a[i-1][p] : a[p][i-1];
+						const T b_element = tb == Transpose::no ? b[p][j-1] : b[j-1][p];
+						expected += double(a_element) * double(b_element);
+					}
+					expected *= double(alpha);
+					if (beta != 0)
+						expected += double(beta) * double(original[i][j]);
+					CHECK(test::near(double(outer[i][j]), expected, tolerance, 10));
+				}
+			}
+		}
+	}
+}
+
+template <typename T> void check_gemv (std::mt19937& rng, size_t rows, size_t cols, unsigned threads)
+{
+	for (Transpose ta: { Transpose::no, Transpose::yes }) {
+		const auto a = random_matrix<T>(rng, rows, cols);
+		const size_t x_size = ta == Transpose::no ? cols : rows, y_size = ta == Transpose::no ? rows : cols;
+		std::vector<T> x(x_size), y(y_size);
+		for (T& value: x)
+			value = T(test::random_real(rng));
+		for (T& value: y)
+			value = T(test::random_real(rng));
+		const std::vector<T> original = y;
+
+		gemv(std::span(y), T(2), Matrix_view<const T>(a), ta, std::span<const T>(x), T(0.5), threads);
+		for (size_t i = 0; i < y_size; i++) {
+			double expected = 0;
+			for (size_t p = 0; p < x_size; p++)
+				expected += double(ta == Transpose::no ? a[i][p] : a[p][i]) * double(x[p]);
+			expected = 2 * expected + 0.5 * double(original[i]);
+			CHECK(test::near(double(y[i]), expected, 1e-12 * double(x_size), 10));
+		}
+	}
+}
+
+int main ()
+{
+	auto rng = test::generator();
+	// Smaller than a tile, tiles with edges, and past each block size (kc 256, mc 96, nc 4096)
+	const std::array<size_t, 3> shapes[] = {
+		{ 1, 1, 1 }, { 5, 7, 3 }, { 13, 17, 19 }, { 12, 16, 1 }, { 97, 33, 257 },
+		{ 200, 33, 300 }, { 7, 4100, 5 }, { 193, 40, 520 },
+	};
+	for (auto [m, n, k]: shapes) {
+		for (double beta: { 0.0, 1.0, -0.5 })
+			check_gemm<double>(rng, m, n, k, beta, 1);
+		check_gemm<double>(rng, m, n, k, 0.5, 3);
+		check_gemm<float>(rng, m, n, k, 0.5f, 1);
+	}
+	// The generic version
+	check_gemm<long double>(rng, 13, 17, 19, 0.5L, 1);
+	check_gemm<long double>(rng, 40, 3, 30, 0, 2);
+
+	check_gemv<double>(rng, 301, 203, 1);
+	check_gemv<double>(rng, 301, 203, 3);
+	check_gemv<double>(rng, 1, 50, 1);
+	return test::result();
+}
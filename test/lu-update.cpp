@@ -0,0 +1,80 @@
+#include "check.hpp"
+#include <gauss/lu-update.hpp>
+#include <vector>
+
+using namespace math;
+
+// The solution and the determinant agree with those of a fresh factorization of `a`
+void check_against_fresh (Updatable_lu<double>& updatable, const Matrix<double>& a, std::mt19937& rng)
+{
+	const size_t n = a.rows();
+	for (size_t i = 0; i < n; i++)
+		CHECK(std::ranges::equal(updatable.matrix()[i], a[i]));
+
+	std::vector<double> b(n), x(n), expected(n);
+	for (double& value: b)
+		value = test::random_real(rng);
+	const Lu_factorization<double> fresh { Matrix_view<const double>(a) };
+	CHECK(updatable.singular() == fresh.singular());
+	if (fresh.singular())
+		return;
+	updatable.solve(std::span(x), std::span<const double>(b));
+	fresh.solve(std::span(expected), std::span<const double>(b));
+	double max_element = 0;
+	for (double value: expected)
+		max_element = std::max(max_element, std::abs(value));
+	for (size_t i = 0; i < n; i++)
+		CHECK(test::near(x[i], expected[i], 1e-9, max_element));
+	CHECK(test::near(updatable.determinant(), fresh.determinant(), 1e-8, std::abs(fresh.determinant())));
+}
+
+int main ()
+{
+	auto rng = test::generator();
+	const size_t n = 60;
+	Matrix<double> a(n, n);
+	for (size_t i = 0; i < n; i++) {
+		for (size_t j = 0; j < n; j++)
+			a[i][j] = test::random_real(rng) + (i == j ? 50 : 0);
+	}
+
+	// 100 updates, more than max_updates, so some of them factor anew
+	Updatable_lu<double> updatable { Matrix_view<const double>(a) };
+	std::optional<Updatable_lu<double>> copy;
+	Matrix<double> copied_matrix(n, n);
+	for (int step = 0; step < 100; step++) {
+		const size_t row = rng() % n;
+		if (step % 3 == 0) {
+			std::vector<double> values(n);
+			for (size_t col = 0; col < n; col++)
+				values[col] = test::random_real(rng) + (col == row ? 50 : 0);
+			std::ranges::copy(values, a[row].begin());
+			updatable.update_row(row, std::span<const double>(values));
+		} else {
+			const size_t col = rng() % n;
+			a[row][col] = test::random_real(rng) + (col == row ? 50 : 0);
+			updatable.update_element(row, col, a[row][col]);
+		}
+		check_against_fresh(updatable, a, rng);
+
+		if (step == 50) {
+			copy.emplace(updatable);
+			copied_matrix = a;
+		}
+	}
+	CHECK(updatable.refactorizations() > 0);
+
+	// A copy doesn't share anything with the one it was made from
+	check_against_fresh(*copy, copied_matrix, rng);
+
+	// A zero row makes the matrix singular, until it is put back
+	const std::vector<double> saved(a[7].begin(), a[7].end());
+	std::ranges::fill(a[7], 0);
+	updatable.update_row(7, std::span<const double>(a[7]));
+	CHECK(updatable.singular());
+	std::ranges::copy(saved, a[7].begin());
+	updatable.update_row(7, std::span<const double>(saved));
+	check_against_fresh(updatable, a, rng);
+	CHECK(!updatable.singular());
+	return test::result();
+}
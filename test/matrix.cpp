@@ -0,0 +1,124 @@
+#include "check.hpp"
+#include <algorithm>
+#include <gauss/solve.hpp>
+#include <ranges>
+#include <vector>
+
+using namespace math;
+
+static_assert(std::ranges::random_access_range<Matrix_view<double>>);
+static_assert(std::ranges::random_access_range<Matrix_view<const double>>);
+static_assert(std::ranges::random_access_range<Matrix_view<double>::column_ref>);
+static_assert(std::ranges::random_access_range<Matrix_tiles<double>>);
+
+Matrix<double> numbered (size_t rows, size_t cols)
+{
+	Matrix<double> mat(rows, cols);
+	for (size_t i = 0; i < rows; i++) {
+		for (size_t j = 0; j < cols; j++)
+			mat[i][j] = double(i * 1000 + j);
+	}
+	return mat;
+}
+
+void check_rows ()
+{
+	auto mat = numbered(20, 7);
+	// A view that doesn't start at the first element, with a stride wider than its rows
+	const auto view = Matrix_view<double>(mat).subview(2, 1, 15, 5);
+	CHECK(std::ranges::distance(view) == 15);
+	CHECK(view.begin()[4][0] == 6001 && (view.end() - 1)[0][4] == 16005);
+	auto it = view.begin();
+	it += 10;
+	CHECK(it - view.begin() == 10 && (*it)[0] == 12001 && it > view.begin());
+	it -= 3;
+	CHECK((*it)[2] == 9003 && (*it--)[0] == 9001 && (*it)[0] == 8001);
+
+	// The rows are sorted by their first element, so binary search works on them
+	const auto first = [] (std::span<double> row) { return row[0]; };
+	const auto found = std::ranges::lower_bound(view, 7000.0, {}, first);
+	CHECK(found - view.begin() == 5);
+}
+
+void check_columns ()
+{
+	auto mat = numbered(9, 6);
+	const auto view = Matrix_view<double>(mat).subview(1, 1, 7, 4);
+	const auto column = view.column(2);
+	CHECK(column.size() == 7 && column[0] == 1003 && column[6] == 7003);
+	CHECK(std::ranges::distance(column) == 7 && column.begin()[3] == 4003);
+
+	// Sorted in place, with real references to the elements
+	std::ranges::sort(column, std::greater {});
+	for (size_t i = 0; i < 7; i++)
+		CHECK(mat[1 + i][3] == double((7 - i) * 1000 + 3));
+
+	std::ranges::swap_ranges(view.column(0), view.column(3));
+	for (size_t i = 1; i < 8; i++)
+		CHECK(mat[i][1] == double(i * 1000 + 4) && mat[i][4] == double(i * 1000 + 1));
+	// Untouched outside the view
+	CHECK(mat[0][1] == 1 && mat[8][1] == 8001);
+}
+
+// Every element is in exactly one tile, and the edge tiles are cut short
+void check_tiles (size_t rows, size_t cols, size_t tile_rows, size_t tile_cols)
+{
+	auto mat = numbered(rows, cols);
+	Matrix<int> seen(rows, cols);
+	for (auto row: Matrix_view<int>(seen))
+		std::ranges::fill(row, 0);
+
+	const auto tiles = Matrix_view<double>(mat).tiles(tile_rows, tile_cols);
+	CHECK(tiles.size() == (rows + tile_rows-1) / tile_rows * ((cols + tile_cols-1) / tile_cols));
+	CHECK(size_t(std::ranges::distance(tiles)) == tiles.size());
+	for (const auto& [row0, col0, block]: tiles) {
+		CHECK(block.rows() == std::min(tile_rows, rows - row0));
+		CHECK(block.cols() == std::min(tile_cols, cols - col0));
+		for (size_t i = 0; i < block.rows(); i++) {
+			for (size_t j = 0; j < block.cols(); j++) {
+				CHECK(block[i][j] == mat[row0 + i][col0 + j]);
+				seen[row0 + i][col0 + j]++;
+			}
+		}
+	}
+	for (auto row: Matrix_view<const int>(seen))
+		CHECK(std::ranges::all_of(row, [] (int count) { return count == 1; }));
+}
+
+// The parallel row loops give the same results as the serial ones
+void check_parallel (std::mt19937& rng)
+{
+	const size_t rows = 500, cols = 101;
+	Matrix<double> system(rows, cols), copy(rows, cols);
+	for (size_t i = 0; i < rows; i++) {
+		for (size_t j = 0; j < cols; j++)
+			system[i][j] = test::random_real(rng);
+	}
+	copy_matrix(Matrix_view<double>(copy), Matrix_view<const double>(system), 3);
+	for (size_t i = 0; i < rows; i++)
+		CHECK(std::ranges::equal(copy[i], system[i]));
+
+	std::vector<double> x(cols-1), product(rows), product_threads(rows), r(rows);
+	for (double& value: x)
+		value = test::random_real(rng);
+	const auto coefficients = Matrix_view<const double>(system).subview(0, 0, rows, cols-1);
+	mul_matrix_vector(std::span(product), coefficients, std::span<const double>(x));
+	mul_matrix_vector(std::span(product_threads), coefficients, std::span<const double>(x), 3);
+	CHECK(product == product_threads);
+	residual(std::span(r), Matrix_view<const double>(system), std::span<const double>(x), 3);
+	for (size_t i = 0; i < rows; i++)
+		CHECK(r[i] == product[i] - system[i][cols-1]);
+}
+
+int main ()
+{
+	auto rng = test::generator();
+	check_rows();
+	check_columns();
+	check_tiles(7, 10, 3, 4);
+	check_tiles(64, 64, 64, 64);
+	check_tiles(65, 1, 64, 64);
+	check_tiles(1, 130, 2, 64);
+	check_parallel(rng);
+	return test::result();
+}
@@ -0,0 +1,100 @@
+#include "check.hpp"
+#include <gauss/qr.hpp>
+#include <vector>
+
+using namespace math;
+
+// The least squares solution by the normal equations A^T*A*x = A^T*b, solved in long double
+// by Gaussian elimination. Fine for well-conditioned A, which is what this test builds
+std::vector<long double> normal_equations (Matrix_view<const double> system)
+{
+	const size_t n = system.cols()-1;
+	std::vector<std::vector<long double>> normal(n, std::vector<long double>(n+1, 0));
+	for (auto row: system) {
+		for (size_t i = 0; i < n; i++) {
+			for (size_t j = 0; j <= n; j++)
+				normal[i][j] += (long double)(row[i]) * row[j];
+		}
+	}
+	for (size_t k = 0; k < n; k++) {
+		for (size_t i = k+1; i < n; i++) {
+			const long double factor = normal[i][k] / normal[k][k];
+			for (size_t j = k; j <= n; j++)
+				normal[i][j] -= factor * normal[k][j];
+		}
+	}
+	std::vector<long double> x(n);
+	for (size_t i = n-1; i != size_t(-1); i--) {
+		long double sum = normal[i][n];
+		for (size_t j = i+1; j < n; j++)
+			sum -= normal[i][j] * x[j];
+		x[i] = sum / normal[i][i];
+	}
+	return x;
+}
+
+// Rows past the chunk size of 2^15 are folded in parallel and then together (TSQR)
+void check_least_squares (std::mt19937& rng, size_t rows, size_t n)
+{
+	Matrix<double> system(rows, n+1);
+	for (size_t i = 0; i < rows; i++) {
+		for (size_t j = 0; j <= n; j++)
+			system[i][j] = test::random_real(rng) + (j == i % (n+1) ? 20 : 0);
+	}
+
+	std::vector<double> x(n), x_threads(n);
+	const auto view = Matrix_view<const double>(system);
+	const auto result = least_squares_solve(std::span(x), view);
+	const auto result_threads = least_squares_solve(std::span(x_threads), view, 3);
+	CHECK(!result.rank_deficient);
+	CHECK(x == x_threads && result.residual_norm == result_threads.residual_norm);
+
+	const auto expected = normal_equations(system);
+	for (size_t i = 0; i < n; i++)
+		CHECK(test::near(x[i], double(expected[i]), 1e-10));
+
+	long double residual_square = 0;
+	for (auto row: view) {
+		long double residual = row[n];
+		for (size_t j = 0; j < n; j++)
+			residual -= (long double)(row[j]) * x[j];
+		residual_square += residual * residual;
+	}
+	CHECK(test::near(result.residual_norm, double(std::sqrt(residual_square)), 1e-10));
+}
+
+int main ()
+{
+	auto rng = test::generator();
+	check_least_squares(rng, 5, 5);
+	check_least_squares(rng, 300, 7);
+	check_least_squares(rng, 1000, 1);
+	check_least_squares(rng, 70000, 12);
+
+	// A consistent system: the residual vanishes
+	{
+		Matrix<double> system(40, 4);
+		for (size_t i = 0; i < 40; i++) {
+			for (size_t j = 0; j < 3; j++)
+				system[i][j] = test::random_real(rng);
+			system[i][3] = system[i][0] - 2 * system[i][1] + 3 * system[i][2];
+		}
+		std::vector<double> x(3);
+		const auto result = least_squares_solve(std::span(x), Matrix_view<const double>(system));
+		CHECK(!result.rank_deficient && result.residual_norm < 1e-12);
+		CHECK(test::near(x[0], 1, 1e-12) && test::near(x[1], -2, 1e-12) && test::near(x[2], 3, 1e-12));
+	}
+
+	// Two equal columns
+	{
+		Matrix<double> system(50, 4);
+		for (size_t i = 0; i < 50; i++) {
+			for (size_t j = 0; j < 4; j++)
+				system[i][j] = test::random_real(rng);
+			system[i][2] = system[i][0];
+		}
+		std::vector<double> x(3);
+		CHECK(least_squares_solve(std::span(x), Matrix_view<const double>(system)).rank_deficient);
+	}
+	return test::result();
+}
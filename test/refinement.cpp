@@ -0,0 +1,85 @@
+#include "check.hpp"
+#include <gauss/refinement.hpp>
+#include <vector>
+
+using namespace math;
+
+double max_residual (Matrix_view<const double> a, std::span<const double> x, std::span<const double> b)
+{
+	double result = 0;
+	for (size_t i = 0; i < a.rows(); i++) {
+		double sum = 0;
+		for (size_t j = 0; j < a.cols(); j++)
+			sum += a[i][j] * x[j];
+		result = std::max(result, std::abs(b[i] - sum));
+	}
+	return result;
+}
+
+// The residual is as small as a backward stable solve in double leaves it, as the refinement
+// promises, whether it got there in float or fell back to double
+void check_solve (Matrix_view<const double> a, std::mt19937& rng, bool expect_fall_back)
+{
+	const size_t n = a.rows();
+	std::vector<double> b(n), x(n);
+	for (double& value: b)
+		value = test::random_real(rng);
+	const auto result = mixed_precision_solve<float>(a, std::span(x), std::span<const double>(b), {}, 2);
+	if (!CHECK(!result.singular))
+		return;
+	CHECK(result.fell_back == expect_fall_back);
+	if (!result.fell_back)
+		CHECK(result.residual_history.size() == result.steps + 1);
+
+	double a_norm = 0, x_norm = 0;
+	for (size_t i = 0; i < n; i++) {
+		double row_sum = 0;
+		for (size_t j = 0; j < n; j++)
+			row_sum += std::abs(a[i][j]);
+		a_norm = std::max(a_norm, row_sum);
+		x_norm = std::max(x_norm, std::abs(x[i]));
+	}
+	// A bit of slack for the fallback, which doesn't test the residual
+	const double bound = 4 * std::sqrt(double(n)) * std::numeric_limits<double>::epsilon() * a_norm * x_norm;
+	CHECK(max_residual(a, x, b) <= bound);
+}
+
+Matrix<double> random_matrix (std::mt19937& rng, size_t n)
+{
+	Matrix<double> a(n, n);
+	for (size_t i = 0; i < n; i++) {
+		for (size_t j = 0; j < n; j++)
+			a[i][j] = test::random_real(rng) + (i == j ? 10 : 0);
+	}
+	return a;
+}
+
+int main ()
+{
+	auto rng = test::generator();
+	for (size_t n: { 1, 10, 200, 300 }) {
+		const auto a = random_matrix(rng, n);
+		check_solve(Matrix_view<const double>(a), rng, false);
+	}
+
+	// Two rows that differ by less than float can tell: singular in float, not in double
+	{
+		auto a = random_matrix(rng, 50);
+		for (size_t j = 0; j < 50; j++)
+			a[49][j] = a[0][j] * (1 + 1e-12);
+		a[49][49] += 1e-9;
+		check_solve(Matrix_view<const double>(a), rng, true);
+	}
+
+	// Singular in double too
+	{
+		auto a = random_matrix(rng, 20);
+		for (size_t j = 0; j < 20; j++)
+			a[19][j] = 2 * a[3][j];
+		std::vector<double> b(20, 1), x(20);
+		const auto result = mixed_precision_solve<float>(Matrix_view<const double>(a), std::span(x),
+				std::span<const double>(b));
+		CHECK(result.singular && result.fell_back);
+	}
+	return test::result();
+}
@@ -0,0 +1,124 @@
+#include "check.hpp"
+#include <gauss/solve.hpp>
+#include <gauss/static-solve.hpp>
+#include <vector>
+
+using namespace math;
+
+// 0x + 2y + z = 7, x + y + z = 6, 2x + y + 3z = 13: x = 1, y = 2, z = 3.
+// The first main element is zero, so the columns get swapped
+template <Static_arithmetic Arithmetic> constexpr bool constant_solve ()
+{
+	Static_matrix<double, 3, 4> mat;
+	const double elements[] = { 0, 2, 1, 7,  1, 1, 1, 6,  2, 1, 3, 13 };
+	for (size_t i = 0; i < 12; i++)
+		mat(i / 4, i % 4) = elements[i];
+
+	std::array<size_t, 3> permute {};
+	std::array<double, 3> raw_solution {}, solution {};
+	gauss_triangulate<Arithmetic>(mat, permute);
+	if (gauss_gather<Arithmetic>(raw_solution, mat) != 0)
+		return false;
+	for (size_t i = 0; i < 3; i++)
+		solution[permute[i]] = raw_solution[i];
+
+	const double expected[] = { 1, 2, 3 };
+	for (size_t i = 0; i < 3; i++) {
+		if (solution[i] - expected[i] > 1e-12 || expected[i] - solution[i] > 1e-12)
+			return false;
+	}
+	return true;
+}
+static_assert(constant_solve<Static_arithmetic::fast>());
+static_assert(constant_solve<Static_arithmetic::reference>());
+
+// Random systems, some with zeros where the main elements would be, some with a zero column,
+// against the views in solve.hpp. The reference arithmetic has to match them bit for bit, even
+// where elements cancel out exactly. The fast one is rounded differently, so its results only
+// have to be close, and it gets systems where no elements cancel out: no zeros but in the
+// first row, where they are main elements before any elimination
+template <Static_arithmetic Arithmetic, size_t Rows, size_t Cols> void compare (std::mt19937& rng, int count)
+{
+	constexpr size_t num_variables = Cols-1;
+	constexpr bool exact = Arithmetic == Static_arithmetic::reference;
+
+	for (int it = 0; it < count; it++) {
+		Static_matrix<double, Rows, Cols> mat;
+		Matrix<double> reference(Rows, Cols), original(Rows, Cols);
+		const bool zero_column = it % 5 == 0;
+		for (size_t i = 0; i < Rows; i++) {
+			for (size_t j = 0; j < Cols; j++) {
+				const double value = zero_column && j == 0 ? 0
+					: exact ? test::random_value(rng, 0.3) : test::random_real(rng, i == 0 ? 0.3 : 0);
+				mat(i, j) = value;
+				reference[i][j] = value;
+				original[i][j] = value;
+			}
+		}
+
+		std::array<size_t, num_variables> permute;
+		std::vector<size_t> reference_permute(num_variables);
+		const unsigned permutations = gauss_triangulate<Arithmetic>(mat, permute);
+		const unsigned reference_permutations =
+			gauss_triangulate(Matrix_view<double>(reference), std::span(reference_permute));
+		// The zero tests see the same zeros either way, so the same columns get swapped
+		CHECK(permutations == reference_permutations);
+		CHECK(std::equal(permute.begin(), permute.end(), reference_permute.begin()));
+		double max_element = 0;
+		for (size_t i = 0; i < Rows; i++) {
+			for (size_t j = 0; j < Cols; j++)
+				max_element = std::max(max_element, std::abs(reference[i][j]));
+		}
+		for (size_t i = 0; i < Rows; i++) {
+			for (size_t j = 0; j < Cols; j++) {
+				if (exact)
+					CHECK(mat(i, j) == reference[i][j]);
+				else
+					CHECK(test::near(mat(i, j), reference[i][j], 1e-9, max_element));
+			}
+		}
+
+		std::array<double, num_variables> raw_solution {};
+		std::vector<double> reference_solution(num_variables);
+		const int result = gauss_gather<Arithmetic>(raw_solution, mat);
+		const int reference_result =
+			gauss_gather(std::span(reference_solution), Matrix_view<double>(reference));
+		CHECK(result == reference_result);
+		if (result != 0 || reference_result != 0)
+			continue;
+		if (exact) {
+			for (size_t i = 0; i < num_variables; i++)
+				CHECK(raw_solution[i] == reference_solution[i]);
+			continue;
+		}
+		// Both solve the system as well as the other, even where it is ill-conditioned
+		std::array<double, num_variables> solution;
+		for (size_t i = 0; i < num_variables; i++)
+			solution[permute[i]] = raw_solution[i];
+		for (size_t i = 0; i < Rows; i++) {
+			double sum = 0, scale = std::abs(original[i][num_variables]);
+			for (size_t j = 0; j < num_variables; j++) {
+				sum += original[i][j] * solution[j];
+				scale += std::abs(original[i][j] * solution[j]);
+			}
+			CHECK(test::near(sum, original[i][num_variables], 1e-10, scale));
+		}
+	}
+}
+
+template <Static_arithmetic Arithmetic> void compare_sizes (std::mt19937& rng)
+{
+	compare<Arithmetic, 4, 5>(rng, 5000);
+	compare<Arithmetic, 6, 7>(rng, 5000);
+	// Wide and tall
+	compare<Arithmetic, 3, 6>(rng, 1000);
+	compare<Arithmetic, 7, 4>(rng, 1000);
+}
+
+int main ()
+{
+	auto rng = test::generator();
+	compare_sizes<Static_arithmetic::reference>(rng);
+	compare_sizes<Static_arithmetic::fast>(rng);
+	return test::result();
+}